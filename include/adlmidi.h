@@ -156,6 +156,46 @@ enum ADLMIDI_ChannelAlloc
     ADLMIDI_ChanAlloc_Count
 };
 
+/*!
+ * \brief Settings which can be staged by adl_stageSetting() from another thread than render calls
+ */
+enum ADLMIDI_StagedSetting
+{
+    /*! Deep vibrato mode, as adl_setHVibrato() */
+    ADLMIDI_Stage_HVibrato = 0,
+    /*! Deep tremolo mode, as adl_setHTremolo() */
+    ADLMIDI_Stage_HTremolo,
+    /*! Scaling of modulator volumes, as adl_setScaleModulators() */
+    ADLMIDI_Stage_ScaleModulators,
+    /*! Full-ranged brightness CC74, as adl_setFullRangeBrightness() */
+    ADLMIDI_Stage_FullRangeBrightness,
+    /*! Automatical arpeggio, as adl_setAutoArpeggio() */
+    ADLMIDI_Stage_AutoArpeggio,
+    /*! Soft panning, as adl_setSoftPanEnabled() */
+    ADLMIDI_Stage_SoftPanEnabled,
+    /*! Volume range model (#ADLMIDI_VolumeModels), as adl_setVolumeRangeModel() */
+    ADLMIDI_Stage_VolumeRangeModel,
+    /*! Channel allocation mode (#ADLMIDI_ChannelAlloc), as adl_setChannelAllocMode() */
+    ADLMIDI_Stage_ChannelAllocMode,
+    /*! Count of settings which can be staged */
+    ADLMIDI_Stage_Count
+};
+
+/*!
+ * \brief Quality of the output resampling
+ */
+enum ADLMIDI_ResamplerQuality
+{
+    /*! Linear interpolation of every chip output (fastest, default) */
+    ADLMIDI_Resampler_Linear = 0,
+    /*! Windowed-sinc polyphase filter with 16 taps */
+    ADLMIDI_Resampler_Medium,
+    /*! Windowed-sinc polyphase filter with 48 taps */
+    ADLMIDI_Resampler_High,
+    /*! Count of available resampler qualities */
+    ADLMIDI_Resampler_Count
+};
+
 /**
  * @brief Device types to filter incompatible MIDI tracks, primarily used by HMI/HMP and EMIDI.
  * Can be combined to enable more tracks.
@@ -706,6 +746,24 @@ extern ADLMIDI_DECLSPEC void adl_setChannelAllocMode(struct ADL_MIDIPlayer *devi
  */
 extern ADLMIDI_DECLSPEC int adl_getChannelAllocMode(struct ADL_MIDIPlayer *device);
 
+/**
+ * @brief Stage the change of the setting to be applied by the render call
+ *
+ * Unlike the setter of the setting, this function may be called by another thread
+ * (for example, the UI thread) while the output is rendered, without any locks.
+ * Staged settings are published at once and applied by adl_play(), adl_playFormat(),
+ * adl_generate() and adl_generateFormat() at the beginning of the next call. Every setting
+ * staged since the previous call is set once, even if its value is the same as before,
+ * the latest value wins when the setting was staged several times.
+ * Only one thread may stage settings at the same time.
+ *
+ * @param device Instance of the library
+ * @param setting Setting to change (#ADLMIDI_StagedSetting)
+ * @param value New value of the setting, the same as for its setter
+ * @return 0 on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int adl_stageSetting(struct ADL_MIDIPlayer *device, int setting, int value);
+
 /**
  * @brief Assigns the device filter to enable/disable tracks in special formats like HMI/HMP or EMIDI
  *
@@ -792,6 +850,11 @@ enum ADL_Emulator
     ADLMIDI_EMU_NUKED_CQM,
     /*! DosBox ran in OPL2 mode */
     ADLMIDI_EMU_DOSBOX_OPL2,
+    /*! Nuked OPL3 with slots processed by vector units, a single chip is bit-exact with ADLMIDI_EMU_NUKED.
+        Multiple chips get emulated in lock-step, their mix is always resampled by the mix bus: the output
+        is bit-exact with ADLMIDI_EMU_NUKED only while adl_setMixBusResampling() is enabled, otherwise
+        it may differ by rounding of the resampler */
+    ADLMIDI_EMU_NUKED_SIMD,
     /*! Count instrument on the level */
     ADLMIDI_EMU_end,
 
@@ -827,6 +890,76 @@ typedef struct {
  */
 extern ADLMIDI_DECLSPEC int adl_setRunAtPcmRate(struct ADL_MIDIPlayer *device, int enabled);
 
+/**
+ * @brief Resample the mixed output of all chips once instead of resampling every chip separately
+ *
+ * Every chip generates its output at the native rate, the sum gets resampled into
+ * the output rate by a single resampler. Reduces CPU usage when multiple chips are used.
+ * Has no effect when only one chip is used, or when chips are running at the PCM rate.
+ * The mix bus uses the same kind of resampler as every chip does by itself: the linear
+ * interpolation, or the HQ resampler when the library is built with it. The polyphase
+ * filter chosen by adl_setResamplerQuality() replaces both.
+ *
+ * @param device Instance of the library
+ * @param enabled 0 - disabled, 1 - enabled
+ * @return 0 on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int adl_setMixBusResampling(struct ADL_MIDIPlayer *device, int enabled);
+
+/**
+ * @brief Set the quality of the output resampling
+ *
+ * On medium and high qualities, all chips are mixed at their native rate and the mix
+ * gets converted into the output rate by the windowed-sinc polyphase filter.
+ * Has no effect when chips are running at the PCM rate.
+ *
+ * @param device Instance of the library
+ * @param quality Resampler quality (#ADLMIDI_ResamplerQuality)
+ * @return 0 on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int adl_setResamplerQuality(struct ADL_MIDIPlayer *device, int quality);
+
+/**
+ * @brief Get the quality of the output resampling
+ * @param device Instance of the library
+ * @return Resampler quality (#ADLMIDI_ResamplerQuality) on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int adl_getResamplerQuality(struct ADL_MIDIPlayer *device);
+
+/**
+ * @brief Set the count of threads used to render chips concurrently
+ *
+ * Every chip gets rendered into its own buffer, and buffers are mixed in the order
+ * of chips, so the output is identical to the single-threaded rendering.
+ * This is useful with a large number of chips only. Not supported on all platforms.
+ *
+ * @param device Instance of the library
+ * @param threads Total count of threads including the calling thread (1 - render chips on the calling thread only, default)
+ * @return 0 on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int adl_setRenderThreads(struct ADL_MIDIPlayer *device, int threads);
+
+/**
+ * @brief Get the count of threads used to render chips
+ * @param device Instance of the library
+ * @return Count of threads on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int adl_getRenderThreads(struct ADL_MIDIPlayer *device);
+
+/**
+ * @brief Skip the emulation of chips which have released all notes and produce silence (disabled by default)
+ *
+ * Skipped chips get resumed on the next register write, the output stays bit-identical
+ * to the continuous emulation. Only emulators which can prove the silence and advance
+ * their state exactly get skipped: currently the Nuked OPL3 (the plain one, not the SIMD one),
+ * other emulators are always emulated.
+ *
+ * @param device Instance of the library
+ * @param skip 0 - emulate all chips always, 1 - skip silent chips
+ * @return 0 on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int adl_setSkipIdleChips(struct ADL_MIDIPlayer *device, int skip);
+
 /**
  * @brief The list of serial port protocols
  */
@@ -851,6 +984,21 @@ extern ADLMIDI_DECLSPEC int adl_switchSerialHW(struct ADL_MIDIPlayer *device,
                                                unsigned baud,
                                                unsigned protocol);
 
+/**
+ * @brief Limit the data sent to the hardware chip by the bandwidth of the Serial port
+ *
+ * Register writes are buffered and sent to the Serial port together once per tick of the player
+ * (by adl_play(), adl_generate(), adl_tickEvents() or adl_tickIterators() calls). With the throttle,
+ * the data which the port can't transfer by the time of the tick is kept for next ticks instead
+ * of being queued by the system driver of the port. When the kept data overflows its buffer, only
+ * the oldest data needed to fit new writes is sent at once, and next ticks send less to make up for it.
+ *
+ * @param device Instance of the library
+ * @param throttle 0 - send all buffered data at every tick (default), 1 - limit the data by the baud speed
+ * @return 0 on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int adl_setSerialThrottle(struct ADL_MIDIPlayer *device, int throttle);
+
 
 /**
  * \brief The list of possible chip types for DOS hardware interface
@@ -1271,6 +1419,99 @@ extern ADLMIDI_DECLSPEC int  adl_generate(struct ADL_MIDIPlayer *device, int sam
  */
 extern ADLMIDI_DECLSPEC int  adl_generateFormat(struct ADL_MIDIPlayer *device, int sampleCount, ADL_UInt8 *left, ADL_UInt8 *right, const struct ADLMIDI_AudioFormat *format);
 
+/**
+ * @brief Start the background render thread which keeps the output buffered ahead of time
+ *
+ * The library-managed thread renders the output by adl_playFormat() or adl_generateFormat()
+ * into the ring buffer, and adl_readAsync() just copies rendered samples, so spikes of the
+ * chips emulation don't cause underruns of the audio callback. Without the music file,
+ * or after its end, the real-time output is generated.
+ *
+ * While the thread is running, only adl_readAsync(), adl_stopAsyncRender(), adl_stageSetting()
+ * and the adl_rt_enqueue* family of functions may be called with this instance,
+ * other functions must be called after adl_stopAsyncRender() only.
+ * Calling of this function again restarts the thread and replaces the ring buffer,
+ * so adl_readAsync() must not run in another thread at the same time.
+ * Not supported on all platforms.
+ *
+ * @param device Instance of the library
+ * @param bufferFrames Count of frames in the ring buffer, rounded up to the power of two (one frame is two samples)
+ * @param format Format of samples returned by adl_readAsync(), NULL to use signed 16-bit interleaved samples as adl_play()
+ * @param playMusic 1 - play the music file as adl_playFormat(), 0 - generate the real-time output only as adl_generateFormat()
+ * @return 0 on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int  adl_startAsyncRender(struct ADL_MIDIPlayer *device, int bufferFrames, const struct ADLMIDI_AudioFormat *format, int playMusic);
+
+/**
+ * @brief Take samples rendered by the background render thread
+ *
+ * Destination buffers are in the format passed into adl_startAsyncRender().
+ * Nothing is rendered by this call, so it's safe to call it from the audio callback.
+ *
+ * Don't use count of frames, use instead count of samples. One frame is two samples.
+ *
+ * @param device Instance of the library
+ * @param sampleCount Count of samples to take
+ * @param left Left channel buffer output (Must be casted into bytes array)
+ * @param right Right channel buffer output (Must be casted into bytes array)
+ * @return Count of given samples, less than requested when the render thread is behind,
+ *         0 after adl_stopAsyncRender(), <0 when the rendering was never started
+ */
+extern ADLMIDI_DECLSPEC int  adl_readAsync(struct ADL_MIDIPlayer *device, int sampleCount, ADL_UInt8 *left, ADL_UInt8 *right);
+
+/**
+ * @brief Stop the background render thread, samples rendered but not taken yet are dropped
+ *
+ * The ring buffer stays allocated until adl_close() or the next adl_startAsyncRender(),
+ * so adl_readAsync() called by the audio callback at the same time safely returns 0.
+ *
+ * @param device Instance of the library
+ */
+extern ADLMIDI_DECLSPEC void adl_stopAsyncRender(struct ADL_MIDIPlayer *device);
+
+/**
+ * @brief Pool of threads shared by many instances of the library, see adl_renderMany()
+ */
+struct ADL_RenderPool;
+
+/**
+ * @brief Create the pool of threads to render many instances of the library concurrently
+ * @param threads Total count of threads including the calling thread (1 - render everything on the calling thread only)
+ * @return Pool of threads on success, NULL when the count is invalid or threads are not supported on this platform
+ */
+extern ADLMIDI_DECLSPEC struct ADL_RenderPool *adl_renderPoolCreate(int threads);
+
+/**
+ * @brief Destroy the pool of threads created by adl_renderPoolCreate()
+ * @param pool Pool of threads
+ */
+extern ADLMIDI_DECLSPEC void adl_renderPoolDestroy(struct ADL_RenderPool *pool);
+
+/**
+ * @brief Render the next block of many independent instances of the library concurrently
+ *
+ * Every instance renders its block as a separate job, threads of the pool take the next
+ * free job until all of them are done, so fast and slow instances are balanced between
+ * threads. Instances having many chips may also split their chips between their own
+ * threads by adl_setRenderThreads(). The call returns after all blocks were rendered.
+ * Every instance may appear in the list only once. The pool may be used by several threads
+ * at once: their calls are processed one after another, and every instance still may be
+ * rendered by only one call at a time.
+ *
+ * Without the music file, or after its end, the real-time output is generated.
+ *
+ * @param devices Array of instances of the library
+ * @param count Count of instances
+ * @param sampleCount Count of samples to render by every instance (one frame is two samples)
+ * @param left Array of left channel buffers of every instance (Must be casted into bytes array)
+ * @param right Array of right channel buffers of every instance (Must be casted into bytes array)
+ * @param format Destination PCM format format context, NULL to use signed 16-bit interleaved samples as adl_play()
+ * @param playMusic 1 - play music files as adl_playFormat(), 0 - generate the real-time output only as adl_generateFormat()
+ * @param pool Pool of threads, NULL to render all instances on the calling thread
+ * @return 0 on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int  adl_renderMany(struct ADL_MIDIPlayer **devices, size_t count, int sampleCount, ADL_UInt8 **left, ADL_UInt8 **right, const struct ADLMIDI_AudioFormat *format, int playMusic, struct ADL_RenderPool *pool);
+
 /**
  * @brief Periodic tick handler.
  *
@@ -1440,6 +1681,110 @@ extern ADLMIDI_DECLSPEC void adl_rt_bankChange(struct ADL_MIDIPlayer *device, AD
  */
 extern ADLMIDI_DECLSPEC int adl_rt_systemExclusive(struct ADL_MIDIPlayer *device, const ADL_UInt8 *msg, size_t size);
 
+/**
+ * @brief Schedule a MIDI channel message at the given frame of the generated output
+ *
+ * Scheduled events are performed by adl_generate(), adl_generateFormat(), adl_play() and
+ * adl_playFormat() at their exact frames inside of the generated block, so the whole audio
+ * buffer of the host can be generated by one call instead of splitting it at every event.
+ * Events of the same frame are performed in the order they were scheduled.
+ * Events that are not reached by the generated block stay scheduled, their offsets
+ * are counted further into next blocks. Scheduled events are dropped by adl_reset()
+ * and by any change of the setup which resets chips.
+ *
+ * @param device Instance of the library
+ * @param frameOffset Offset from the start of the next block generated by adl_generate(), in frames of the output
+ * @param msg Raw MIDI channel message: the status byte (0x80...0xEF) followed by its data bytes, the running status is not supported
+ * @param size Size of given message buffer
+ * @return 1 when message was scheduled, 0 when message was rejected as not a valid channel message
+ */
+extern ADLMIDI_DECLSPEC int adl_rt_scheduleEvent(struct ADL_MIDIPlayer *device, ADL_UInt32 frameOffset, const ADL_UInt8 *msg, size_t size);
+
+/**
+ * @brief Set the capacity of the input queue of adl_rt_enqueueEvent() and similar functions
+ *
+ * Events waiting in the queue are dropped. This function must not be called while
+ * another thread puts events into the queue or renders the output. By default, the
+ * queue has capacity of 1024 events.
+ *
+ * @param device Instance of the library
+ * @param capacity Maximum count of queued events (rounded up to the power of two), 0 to disable the queue
+ * @return 0 on success, <0 when any error has occurred
+ */
+extern ADLMIDI_DECLSPEC int adl_setInputQueueCapacity(struct ADL_MIDIPlayer *device, size_t capacity);
+
+/**
+ * @brief Get the count of events dropped by adl_rt_enqueueEvent() and similar functions because the input queue was full
+ * @param device Instance of the library
+ * @return Count of dropped events since the creation of the instance
+ */
+extern ADLMIDI_DECLSPEC ADL_UInt32 adl_getInputQueueOverflows(struct ADL_MIDIPlayer *device);
+
+/**
+ * @brief Put a MIDI channel message into the input queue
+ *
+ * Unlike other real-time functions, the adl_rt_enqueue* family may be called by one
+ * thread (for example, the MIDI input thread) while another thread renders the output,
+ * without any locks: the queue is a wait-free single-producer single-consumer ring.
+ * Queued events are taken by adl_generate(), adl_generateFormat(), adl_play() and
+ * adl_playFormat() at the beginning of the call and performed as scheduled by adl_rt_scheduleEvent().
+ * Only one thread may put events into the queue at the same time.
+ *
+ * @param device Instance of the library
+ * @param frameOffset Offset from the start of the block generated by the call which takes the event, in frames of the output
+ * @param msg Raw MIDI channel message: the status byte (0x80...0xEF) followed by its data bytes
+ * @param size Size of given message buffer
+ * @return 1 when message was queued, 0 when message was rejected or the queue is full
+ */
+extern ADLMIDI_DECLSPEC int adl_rt_enqueueEvent(struct ADL_MIDIPlayer *device, ADL_UInt32 frameOffset, const ADL_UInt8 *msg, size_t size);
+
+/**
+ * @brief Put the Note-On event into the input queue (see adl_rt_enqueueEvent())
+ * @param device Instance of the library
+ * @param channel Target MIDI channel [0~15]
+ * @param note Note number to on [Between 0 and 127]
+ * @param velocity Velocity level [Between 0 and 127]
+ * @return 1 when event was queued, 0 when the queue is full
+ */
+extern ADLMIDI_DECLSPEC int adl_rt_enqueueNoteOn(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt8 note, ADL_UInt8 velocity);
+
+/**
+ * @brief Put the Note-Off event into the input queue (see adl_rt_enqueueEvent())
+ * @param device Instance of the library
+ * @param channel Target MIDI channel [0~15]
+ * @param note Note number to off [Between 0 and 127]
+ * @return 1 when event was queued, 0 when the queue is full
+ */
+extern ADLMIDI_DECLSPEC int adl_rt_enqueueNoteOff(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt8 note);
+
+/**
+ * @brief Put the Control Change event into the input queue (see adl_rt_enqueueEvent())
+ * @param device Instance of the library
+ * @param channel Target MIDI channel [0~15]
+ * @param type Type of the controller [Between 0 and 127]
+ * @param value Value of the controller event [Between 0 and 127]
+ * @return 1 when event was queued, 0 when the queue is full
+ */
+extern ADLMIDI_DECLSPEC int adl_rt_enqueueControllerChange(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt8 type, ADL_UInt8 value);
+
+/**
+ * @brief Put the Patch Change event into the input queue (see adl_rt_enqueueEvent())
+ * @param device Instance of the library
+ * @param channel Target MIDI channel [0~15]
+ * @param patch Patch number [Between 0 and 127]
+ * @return 1 when event was queued, 0 when the queue is full
+ */
+extern ADLMIDI_DECLSPEC int adl_rt_enqueuePatchChange(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt8 patch);
+
+/**
+ * @brief Put the Pitch Bend event into the input queue (see adl_rt_enqueueEvent())
+ * @param device Instance of the library
+ * @param channel Target MIDI channel [0~15]
+ * @param pitch 14-bit pitch bend value [Between 0 and 16383, 8192 is the center]
+ * @return 1 when event was queued, 0 when the queue is full
+ */
+extern ADLMIDI_DECLSPEC int adl_rt_enqueuePitchBend(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt16 pitch);
+
 /**
  * @brief Write a raw OPL3 register on a specific chip, bypassing the MIDI driver.
  *
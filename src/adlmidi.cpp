@@ -26,6 +26,8 @@
 #include "adlmidi_opl3.hpp"
 #include "adlmidi_private.hpp"
 #include "chips/opl_chip_base.h"
+#include "adlmidi_render_threads.hpp"
+#include "adlmidi_async_render.hpp"
 #ifndef ADLMIDI_DISABLE_MIDI_SEQUENCER
 #   define BWMIDI_ENABLE_OPL_MUSIC_SUPPORT
 #   include "midiseq/midi_sequencer.hpp"
@@ -128,6 +130,7 @@ ADLMIDI_EXPORT void adl_close(struct ADL_MIDIPlayer *device)
 
     MidiPlayer *play = GET_MIDI_PLAYER(device);
     assert(play);
+    play->m_asyncRender.reset(NULL); // Stop rendering before the player will be destroyed
     delete play;
     device->adl_midiPlayer = NULL;
     free(device);
@@ -994,6 +997,107 @@ ADLMIDI_EXPORT int adl_setRunAtPcmRate(ADL_MIDIPlayer *device, int enabled)
     return -1;
 }
 
+ADLMIDI_EXPORT int adl_setMixBusResampling(ADL_MIDIPlayer *device, int enabled)
+{
+    if(device)
+    {
+        MidiPlayer *play = GET_MIDI_PLAYER(device);
+        assert(play);
+        Synth &synth = *play->m_synth;
+        bool en = (enabled != 0);
+
+        if(synth.m_resampleMixBus != en)
+        {
+            synth.m_resampleMixBus = en;
+            synth.resetMixBus();
+        }
+
+        return 0;
+    }
+
+    return -1;
+}
+
+ADLMIDI_EXPORT int adl_setResamplerQuality(ADL_MIDIPlayer *device, int quality)
+{
+    if(device)
+    {
+        MidiPlayer *play = GET_MIDI_PLAYER(device);
+        assert(play);
+
+        if(quality < ADLMIDI_Resampler_Linear || quality >= ADLMIDI_Resampler_Count)
+        {
+            play->setErrorString("Invalid resampler quality value!");
+            return -1;
+        }
+
+        play->m_synth->setResamplerQuality(quality);
+        return 0;
+    }
+
+    return -1;
+}
+
+ADLMIDI_EXPORT int adl_getResamplerQuality(ADL_MIDIPlayer *device)
+{
+    if(!device)
+        return -1;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+    return play->m_synth->m_resamplerQuality;
+}
+
+ADLMIDI_EXPORT int adl_setRenderThreads(ADL_MIDIPlayer *device, int threads)
+{
+    if(!device)
+        return -1;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+
+    if(threads < 1 || threads > (int)ChipRenderThreads::MaxThreads)
+    {
+        play->setErrorString("Invalid count of render threads!");
+        return -1;
+    }
+
+    if(threads > 1 && !ChipRenderThreads::isSupported())
+    {
+        play->setErrorString("Multi-threaded rendering is not supported by this build of the library!");
+        return -1;
+    }
+
+    if(!play->m_synth->setRenderThreads((unsigned)threads))
+    {
+        play->setErrorString("Failed to start render threads!");
+        return -1;
+    }
+
+    return 0;
+}
+
+ADLMIDI_EXPORT int adl_getRenderThreads(ADL_MIDIPlayer *device)
+{
+    if(!device)
+        return -1;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+    return (int)play->m_synth->renderThreads();
+}
+
+ADLMIDI_EXPORT int adl_setSkipIdleChips(ADL_MIDIPlayer *device, int skip)
+{
+    if(!device)
+        return -1;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+    play->m_synth->setSkipIdleChips(skip != 0);
+    return 0;
+}
+
 ADLMIDI_EXPORT int adl_switchSerialHW(struct ADL_MIDIPlayer *device,
                                       const char *name,
                                       unsigned baud,
@@ -1020,6 +1124,23 @@ ADLMIDI_EXPORT int adl_switchSerialHW(struct ADL_MIDIPlayer *device,
     return -1;
 }
 
+ADLMIDI_EXPORT int adl_setSerialThrottle(struct ADL_MIDIPlayer *device, int throttle)
+{
+    if(!device)
+        return -1;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+#ifdef ADLMIDI_ENABLE_HW_SERIAL
+    play->m_synth->setSerialThrottle(throttle != 0);
+    return 0;
+#else
+    (void)throttle;
+    play->setErrorString("ADLMIDI: The hardware serial mode is not enabled in this build");
+    return -1;
+#endif
+}
+
 int adl_switchDOSHW(int chipType, ADL_UInt16 baseAddress)
 {
 #ifdef ENABLE_HW_OPL_DOS
@@ -1612,6 +1733,75 @@ static int SendStereoAudio(int        samples_requested,
 
 #endif // ADLMIDI_HW_OPL
 
+static void ApplyStagedSettings(struct ADL_MIDIPlayer *device)
+{
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    MidiPlayer::StagedSettings changes;
+
+    if(!play->takeStagedSettings(changes))
+        return;
+
+    for(int i = 0; i < ADLMIDI_Stage_Count; ++i)
+    {
+        if((changes.mask & (1u << i)) == 0)
+            continue;
+
+        const int value = changes.values[i];
+
+        switch(i)
+        {
+        case ADLMIDI_Stage_HVibrato:
+            adl_setHVibrato(device, value);
+            break;
+        case ADLMIDI_Stage_HTremolo:
+            adl_setHTremolo(device, value);
+            break;
+        case ADLMIDI_Stage_ScaleModulators:
+            adl_setScaleModulators(device, value);
+            break;
+        case ADLMIDI_Stage_FullRangeBrightness:
+            adl_setFullRangeBrightness(device, value);
+            break;
+        case ADLMIDI_Stage_AutoArpeggio:
+            adl_setAutoArpeggio(device, value);
+            break;
+        case ADLMIDI_Stage_SoftPanEnabled:
+            adl_setSoftPanEnabled(device, value);
+            break;
+        case ADLMIDI_Stage_VolumeRangeModel:
+            adl_setVolumeRangeModel(device, value);
+            break;
+        case ADLMIDI_Stage_ChannelAllocMode:
+            adl_setChannelAllocMode(device, value);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+ADLMIDI_EXPORT int adl_stageSetting(struct ADL_MIDIPlayer *device, int setting, int value)
+{
+    if(!device)
+        return -1;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+
+    if(!play->stageSetting(setting, value))
+    {
+        play->setErrorString("Unknown setting to stage");
+        return -1;
+    }
+
+#ifdef ADLMIDI_HW_OPL
+    // No render calls, apply now
+    ApplyStagedSettings(device);
+#endif
+
+    return 0;
+}
+
 
 ADLMIDI_EXPORT int adl_play(struct ADL_MIDIPlayer *device, int sampleCount, short *out)
 {
@@ -1650,6 +1840,9 @@ ADLMIDI_EXPORT int adl_playFormat(ADL_MIDIPlayer *device, int sampleCount,
     int left = sampleCount;
     bool hasSkipped = setup.tick_skip_samples_delay > 0;
 
+    ApplyStagedSettings(device);
+    player->drainInputQueue();
+
     while(left > 0)
     {
         const double eat_delay = setup.delay < setup.maxdelay ? setup.delay : setup.maxdelay;
@@ -1684,21 +1877,14 @@ ADLMIDI_EXPORT int adl_playFormat(ADL_MIDIPlayer *device, int sampleCount,
             ssize_t in_generatedStereo = (n_periodCountStereo > 512) ? 512 : n_periodCountStereo;
             //! Total count of samples
             ssize_t in_generatedPhys = in_generatedStereo * 2;
-            //! Unsigned total sample count
-            //fill buffer with zeros
             int32_t *out_buf = player->m_outBuf;
-            std::memset(out_buf, 0, static_cast<size_t>(in_generatedPhys) * sizeof(out_buf[0]));
             Synth &synth = *player->m_synth;
-            unsigned int chips = synth.m_numChips;
 
-            if(chips == 1)
-                synth.m_chips[0]->generate32(out_buf, (size_t)in_generatedStereo);
-            else/* if(n_periodCountStereo > 0)*/
-            {
-                /* Generate data from every chip and mix result */
-                for(size_t card = 0; card < chips; ++card)
-                    synth.m_chips[card]->generateAndMix32(out_buf, (size_t)in_generatedStereo);
-            }
+            /* Perform events scheduled into this block at their frames */
+            player->processScheduledEvents((size_t)in_generatedStereo);
+
+            /* Generate data from every chip and mix result */
+            synth.generate32(out_buf, (size_t)in_generatedStereo);
 
             /* Process it */
             if(SendStereoAudio(sampleCount, in_generatedStereo, out_buf, gotten_len, out_left, out_right, format) == -1)
@@ -1760,6 +1946,9 @@ ADLMIDI_EXPORT int adl_generateFormat(struct ADL_MIDIPlayer *device, int sampleC
     int     left = sampleCount;
     double  delay = double(sampleCount / 2) / double(setup.PCM_RATE);
 
+    ApplyStagedSettings(device);
+    player->drainInputQueue();
+
     while(left > 0)
     {
         if(delay <= 0.0)
@@ -1781,21 +1970,14 @@ ADLMIDI_EXPORT int adl_generateFormat(struct ADL_MIDIPlayer *device, int sampleC
             ssize_t in_generatedStereo = (n_periodCountStereo > 512) ? 512 : n_periodCountStereo;
             //! Total count of samples
             ssize_t in_generatedPhys = in_generatedStereo * 2;
-            //! Unsigned total sample count
-            //fill buffer with zeros
             int32_t *out_buf = player->m_outBuf;
-            std::memset(out_buf, 0, static_cast<size_t>(in_generatedPhys) * sizeof(out_buf[0]));
             Synth &synth = *player->m_synth;
-            unsigned int chips = synth.m_numChips;
 
-            if(chips == 1)
-                synth.m_chips[0]->generate32(out_buf, (size_t)in_generatedStereo);
-            else if(n_periodCountStereo > 0)
-            {
-                /* Generate data from every chip and mix result */
-                for(unsigned card = 0; card < chips; ++card)
-                    synth.m_chips[card]->generateAndMix32(out_buf, (size_t)in_generatedStereo);
-            }
+            /* Perform events scheduled into this block at their frames */
+            player->processScheduledEvents((size_t)in_generatedStereo);
+
+            /* Generate data from every chip and mix result */
+            synth.generate32(out_buf, (size_t)in_generatedStereo);
 
             /* Process it */
             if(SendStereoAudio(sampleCount, in_generatedStereo, out_buf, gotten_len, out_left, out_right, format) == -1)
@@ -1812,6 +1994,213 @@ ADLMIDI_EXPORT int adl_generateFormat(struct ADL_MIDIPlayer *device, int sampleC
 #endif
 }
 
+static void RenderPlayerBlock(struct ADL_MIDIPlayer *device, int sampleCount,
+                              ADL_UInt8 *left, ADL_UInt8 *right,
+                              const ADLMIDI_AudioFormat *format, bool playMusic)
+{
+    int gotten = 0;
+
+    if(playMusic)
+        gotten = adl_playFormat(device, sampleCount, left, right, format);
+
+    if(gotten < sampleCount)
+    {
+        // No music or the end of it: generate the tail of voices and real-time events
+        const size_t offset = (size_t)(gotten / 2) * format->sampleOffset;
+        adl_generateFormat(device, sampleCount - gotten, left + offset, right + offset, format);
+    }
+}
+
+static void AsyncRenderBlock(void *userData, uint8_t *dst, size_t frames)
+{
+    ADL_MIDIPlayer *device = static_cast<ADL_MIDIPlayer *>(userData);
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    ADLMIDI_AudioFormat format = play->m_asyncFormat;
+
+    format.sampleOffset = format.containerSize * 2; // The ring is interleaved
+    RenderPlayerBlock(device, static_cast<int>(frames * 2), dst, dst + format.containerSize, &format, play->m_asyncPlayMusic);
+}
+
+ADLMIDI_EXPORT int adl_startAsyncRender(struct ADL_MIDIPlayer *device, int bufferFrames,
+                                        const ADLMIDI_AudioFormat *format, int playMusic)
+{
+    if(!device)
+        return -1;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+
+#ifdef ADLMIDI_HW_OPL
+    ADL_UNUSED(bufferFrames);
+    ADL_UNUSED(format);
+    ADL_UNUSED(playMusic);
+    play->setErrorString("Asynchronous rendering is not supported by this build of the library!");
+    return -1;
+#else
+    if(!AsyncRenderThread::isSupported())
+    {
+        play->setErrorString("Asynchronous rendering is not supported by this build of the library!");
+        return -1;
+    }
+
+    if(bufferFrames <= 0 || bufferFrames > (int)AsyncRenderThread::MaxFrames)
+    {
+        play->setErrorString("Invalid size of the asynchronous render buffer!");
+        return -1;
+    }
+
+    if(!format)
+        format = &adl_DefaultAudioFormat;
+
+    if(format->containerSize == 0)
+    {
+        play->setErrorString("Invalid format of the asynchronous rendering!");
+        return -1;
+    }
+
+    if(!play->m_asyncRender.get())
+        play->m_asyncRender.reset(new AsyncRenderThread);
+    else
+        play->m_asyncRender->stop(); // The ring gets reallocated: the reader must not run now
+
+    play->m_asyncFormat = *format;
+    play->m_asyncPlayMusic = (playMusic != 0);
+
+    // Sleep for about a half of the rendered chunk while the ring buffer is full
+    unsigned idleSleepMs = static_cast<unsigned>((bufferFrames < 2048 ? bufferFrames : 2048) * 1000.0 / play->m_setup.PCM_RATE / 8);
+
+    if(!play->m_asyncRender->start(&AsyncRenderBlock, device, (size_t)bufferFrames, format->containerSize, idleSleepMs))
+    {
+        play->setErrorString("Failed to start the asynchronous render thread!");
+        return -1;
+    }
+
+    return 0;
+#endif
+}
+
+ADLMIDI_EXPORT int adl_readAsync(struct ADL_MIDIPlayer *device, int sampleCount, ADL_UInt8 *left, ADL_UInt8 *right)
+{
+    if(!device)
+        return -1;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+    AsyncRenderThread *render = play->m_asyncRender.get();
+
+    if(!render || sampleCount < 0)
+        return -1;
+
+    size_t frames = render->read(left, right, (size_t)(sampleCount / 2), play->m_asyncFormat.sampleOffset);
+    return static_cast<int>(frames * 2);
+}
+
+ADLMIDI_EXPORT void adl_stopAsyncRender(struct ADL_MIDIPlayer *device)
+{
+    if(!device)
+        return;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+    // Keep the ring buffer: adl_readAsync() may run in the audio callback at the same time
+    if(play->m_asyncRender.get())
+        play->m_asyncRender->stop();
+}
+
+struct ADL_RenderPool
+{
+    ChipRenderThreads threads;
+};
+
+struct RenderManyJob
+{
+    struct ADL_MIDIPlayer **devices;
+    int sampleCount;
+    ADL_UInt8 **left;
+    ADL_UInt8 **right;
+    const ADLMIDI_AudioFormat *format;
+    bool playMusic;
+};
+
+static void RenderManyJobFunc(void *userData, size_t job)
+{
+    const RenderManyJob *j = static_cast<const RenderManyJob *>(userData);
+    RenderPlayerBlock(j->devices[job], j->sampleCount, j->left[job], j->right[job], j->format, j->playMusic);
+}
+
+ADLMIDI_EXPORT struct ADL_RenderPool *adl_renderPoolCreate(int threads)
+{
+    if(threads < 1 || threads > (int)ChipRenderThreads::MaxThreads)
+        return NULL;
+
+    if(threads > 1 && !ChipRenderThreads::isSupported())
+        return NULL;
+
+    ADL_RenderPool *pool = new(std::nothrow) ADL_RenderPool;
+    if(!pool)
+        return NULL;
+
+    if(!pool->threads.setThreads((unsigned)threads))
+    {
+        delete pool;
+        return NULL;
+    }
+
+    return pool;
+}
+
+ADLMIDI_EXPORT void adl_renderPoolDestroy(struct ADL_RenderPool *pool)
+{
+    delete pool;
+}
+
+ADLMIDI_EXPORT int adl_renderMany(struct ADL_MIDIPlayer **devices, size_t count, int sampleCount,
+                                  ADL_UInt8 **left, ADL_UInt8 **right,
+                                  const ADLMIDI_AudioFormat *format, int playMusic,
+                                  struct ADL_RenderPool *pool)
+{
+#ifdef ADLMIDI_HW_OPL
+    ADL_UNUSED(devices);
+    ADL_UNUSED(count);
+    ADL_UNUSED(sampleCount);
+    ADL_UNUSED(left);
+    ADL_UNUSED(right);
+    ADL_UNUSED(format);
+    ADL_UNUSED(playMusic);
+    ADL_UNUSED(pool);
+    return -1;
+#else
+    sampleCount -= sampleCount % 2; //Avoid even sample requests
+
+    if(sampleCount < 0 || (count > 0 && (!devices || !left || !right)))
+        return -1;
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(!devices[i])
+            return -1;
+    }
+
+    RenderManyJob job;
+    job.devices = devices;
+    job.sampleCount = sampleCount;
+    job.left = left;
+    job.right = right;
+    job.format = format ? format : &adl_DefaultAudioFormat;
+    job.playMusic = (playMusic != 0);
+
+    if(pool)
+        pool->threads.run(&RenderManyJobFunc, &job, count, true);
+    else
+    {
+        for(size_t i = 0; i < count; ++i)
+            RenderManyJobFunc(&job, i);
+    }
+
+    return 0;
+#endif
+}
+
 ADLMIDI_EXPORT double adl_tickEvents(struct ADL_MIDIPlayer *device, double seconds, double granulality)
 {
 #ifndef ADLMIDI_DISABLE_MIDI_SEQUENCER
@@ -2123,6 +2512,86 @@ ADLMIDI_EXPORT int adl_rt_systemExclusive(struct ADL_MIDIPlayer *device, const A
     return play->realTime_SysEx(msg, size);
 }
 
+ADLMIDI_EXPORT int adl_rt_scheduleEvent(struct ADL_MIDIPlayer *device, ADL_UInt32 frameOffset, const ADL_UInt8 *msg, size_t size)
+{
+    if(!device)
+        return 0;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+
+    return (int)play->realTime_scheduleEvent(frameOffset, msg, size);
+}
+
+ADLMIDI_EXPORT int adl_setInputQueueCapacity(struct ADL_MIDIPlayer *device, size_t capacity)
+{
+    if(!device)
+        return -1;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+
+    if(!play->setInputQueueCapacity(capacity))
+    {
+        play->setErrorString("Capacity of the input queue is too big");
+        return -1;
+    }
+
+    return 0;
+}
+
+ADLMIDI_EXPORT ADL_UInt32 adl_getInputQueueOverflows(struct ADL_MIDIPlayer *device)
+{
+    if(!device)
+        return 0;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+
+    return play->inputQueueOverflows();
+}
+
+ADLMIDI_EXPORT int adl_rt_enqueueEvent(struct ADL_MIDIPlayer *device, ADL_UInt32 frameOffset, const ADL_UInt8 *msg, size_t size)
+{
+    if(!device)
+        return 0;
+
+    MidiPlayer *play = GET_MIDI_PLAYER(device);
+    assert(play);
+
+    return (int)play->realTime_enqueueEvent(frameOffset, msg, size);
+}
+
+ADLMIDI_EXPORT int adl_rt_enqueueNoteOn(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt8 note, ADL_UInt8 velocity)
+{
+    const ADL_UInt8 msg[3] = {(ADL_UInt8)(0x90 | (channel & 0x0F)), (ADL_UInt8)(note & 0x7F), (ADL_UInt8)(velocity & 0x7F)};
+    return adl_rt_enqueueEvent(device, 0, msg, 3);
+}
+
+ADLMIDI_EXPORT int adl_rt_enqueueNoteOff(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt8 note)
+{
+    const ADL_UInt8 msg[3] = {(ADL_UInt8)(0x80 | (channel & 0x0F)), (ADL_UInt8)(note & 0x7F), 0};
+    return adl_rt_enqueueEvent(device, 0, msg, 3);
+}
+
+ADLMIDI_EXPORT int adl_rt_enqueueControllerChange(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt8 type, ADL_UInt8 value)
+{
+    const ADL_UInt8 msg[3] = {(ADL_UInt8)(0xB0 | (channel & 0x0F)), (ADL_UInt8)(type & 0x7F), (ADL_UInt8)(value > 127 ? 127 : value)};
+    return adl_rt_enqueueEvent(device, 0, msg, 3);
+}
+
+ADLMIDI_EXPORT int adl_rt_enqueuePatchChange(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt8 patch)
+{
+    const ADL_UInt8 msg[2] = {(ADL_UInt8)(0xC0 | (channel & 0x0F)), (ADL_UInt8)(patch & 0x7F)};
+    return adl_rt_enqueueEvent(device, 0, msg, 2);
+}
+
+ADLMIDI_EXPORT int adl_rt_enqueuePitchBend(struct ADL_MIDIPlayer *device, ADL_UInt8 channel, ADL_UInt16 pitch)
+{
+    const ADL_UInt8 msg[3] = {(ADL_UInt8)(0xE0 | (channel & 0x0F)), (ADL_UInt8)(pitch & 0x7F), (ADL_UInt8)((pitch >> 7) & 0x7F)};
+    return adl_rt_enqueueEvent(device, 0, msg, 3);
+}
+
 ADLMIDI_EXPORT int adl_rt_rawOPL3(struct ADL_MIDIPlayer *device, int chipId, ADL_UInt16 reg, ADL_UInt8 value)
 {
     if(!device)
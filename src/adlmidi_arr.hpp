@@ -26,6 +26,8 @@
 
 #include <stddef.h>
 #include <cstdlib>
+#include <cstring>
+#include <new>
 
 /**
  * \file adlmidi_arr.hpp
@@ -178,4 +180,101 @@ struct adl_array
 #endif
 };
 
+/**
+ * \brief A growing queue of plain items in the order of their processing
+ *
+ * Items are taken from the head, and appended or inserted before the tail.
+ * When the array gets full, pending items are moved to its beginning to reuse
+ * the space of taken ones, and the array grows twice only if it's still full.
+ * Items are moved by memmove(), so they must have no constructors.
+ */
+template<class T>
+struct adl_fifo
+{
+    adl_array<T> items;
+    //! Index of the first pending item
+    size_t head;
+    //! End of pending items
+    size_t tail;
+
+    adl_fifo() :
+        head(0),
+        tail(0)
+    {}
+
+    bool empty() const
+    {
+        return head == tail;
+    }
+
+    //! Count of pending items
+    size_t count() const
+    {
+        return tail - head;
+    }
+
+    T &front()
+    {
+        return items.data[head];
+    }
+
+    T &back()
+    {
+        return items.data[tail - 1];
+    }
+
+    //! Pending item by its index from the head
+    T &operator[](size_t i)
+    {
+        return items.data[head + i];
+    }
+
+    //! Append the item, returns it to fill in
+    T &push()
+    {
+        reserve();
+        return items.data[tail++];
+    }
+
+    //! Insert the item before the pending item of the given index from the head, returns it to fill in
+    T &insert(size_t pos)
+    {
+        reserve();
+        T *at = items.data + head + pos;
+        std::memmove(at + 1, at, (tail - head - pos) * sizeof(T));
+        ++tail;
+        return *at;
+    }
+
+    //! Take the first pending item
+    void pop()
+    {
+        if(++head == tail)
+            head = tail = 0;
+    }
+
+    void clear()
+    {
+        head = tail = 0;
+    }
+
+private:
+    //! Make a room for one more item after the tail
+    void reserve()
+    {
+        if(tail < items.size)
+            return;
+
+        if(head > 0)
+        {
+            std::memmove(items.data, items.data + head, (tail - head) * sizeof(T));
+            tail -= head;
+            head = 0;
+        }
+
+        if(tail == items.size)
+            items.expand(items.size > 0 ? items.size * 2 : 256);
+    }
+};
+
 #endif //ADLMIDI_ARR_HPP_THING
@@ -0,0 +1,280 @@
+/*
+ * libADLMIDI is a free Software MIDI synthesizer library with OPL3 emulation
+ *
+ * Original ADLMIDI code: Copyright (c) 2010-2014 Joel Yliluoma <bisqwit@iki.fi>
+ * ADLMIDI Library API:   Copyright (c) 2015-2026 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * Library is based on the ADLMIDI, a MIDI player for Linux and Windows with OPL3 emulation:
+ * http://iki.fi/bisqwit/source/adlmidi.html
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "adlmidi_async_render.hpp"
+#include <string.h>
+
+#if !defined(ADLMIDI_DISABLE_RENDER_THREADS)
+#   if defined(_WIN32)
+#       include <windows.h>
+#   else
+#       include <pthread.h>
+#       include <time.h>
+#   endif
+#endif
+
+
+#if defined(ADLMIDI_DISABLE_RENDER_THREADS) // No threads, the render thread can't be started
+
+struct AsyncRenderThread::Impl
+{};
+
+bool AsyncRenderThread::isSupported()
+{
+    return false;
+}
+
+bool AsyncRenderThread::createThread()
+{
+    return false;
+}
+
+void AsyncRenderThread::joinThread()
+{}
+
+void AsyncRenderThread::idle()
+{}
+
+#elif !defined(_WIN32) // pthread
+
+struct AsyncRenderThread::Impl
+{
+    pthread_t thread;
+};
+
+void *asyncRenderThreadMain(void *self)
+{
+    static_cast<AsyncRenderThread *>(self)->renderLoop();
+    return NULL;
+}
+
+bool AsyncRenderThread::isSupported()
+{
+    return true;
+}
+
+bool AsyncRenderThread::createThread()
+{
+    return pthread_create(&p->thread, NULL, &asyncRenderThreadMain, this) == 0;
+}
+
+void AsyncRenderThread::joinThread()
+{
+    pthread_join(p->thread, NULL);
+}
+
+void AsyncRenderThread::idle()
+{
+    struct timespec ts;
+    ts.tv_sec = m_idleSleepMs / 1000;
+    ts.tv_nsec = (long)(m_idleSleepMs % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+
+#else // Win32
+
+struct AsyncRenderThread::Impl
+{
+    HANDLE thread;
+};
+
+void *asyncRenderThreadMain(void *self)
+{
+    static_cast<AsyncRenderThread *>(self)->renderLoop();
+    return NULL;
+}
+
+static DWORD WINAPI asyncRenderThreadWin32(LPVOID self)
+{
+    asyncRenderThreadMain(self);
+    return 0;
+}
+
+bool AsyncRenderThread::isSupported()
+{
+    return true;
+}
+
+bool AsyncRenderThread::createThread()
+{
+    p->thread = CreateThread(NULL, 0, &asyncRenderThreadWin32, this, 0, NULL);
+    return p->thread != NULL;
+}
+
+void AsyncRenderThread::joinThread()
+{
+    WaitForSingleObject(p->thread, INFINITE);
+    CloseHandle(p->thread);
+}
+
+void AsyncRenderThread::idle()
+{
+    Sleep(m_idleSleepMs);
+}
+
+#endif
+
+
+AsyncRenderThread::AsyncRenderThread() :
+    m_func(NULL),
+    m_userData(NULL),
+    m_mask(0),
+    m_sampleSize(0),
+    m_frameSize(0),
+    m_chunkFrames(0),
+    m_idleSleepMs(1),
+    m_readPos(0),
+    m_writePos(0),
+    m_quit(0),
+    m_running(0),
+    p(NULL)
+{}
+
+AsyncRenderThread::~AsyncRenderThread()
+{
+    stop();
+    delete p;
+}
+
+bool AsyncRenderThread::start(RenderFunc func, void *userData, size_t bufferFrames, size_t sampleSize, unsigned idleSleepMs)
+{
+    size_t frames = 64;
+
+    stop();
+
+    if(!isSupported() || bufferFrames > (size_t)MaxFrames || sampleSize == 0)
+        return false;
+
+    while(frames < bufferFrames)
+        frames <<= 1;
+
+    m_func = func;
+    m_userData = userData;
+    m_sampleSize = sampleSize;
+    m_frameSize = sampleSize * 2;
+    m_ring.resize(frames * m_frameSize);
+    m_mask = static_cast<uint32_t>(frames - 1);
+    // Quarters of the ring, so the reader rarely finds it empty while a chunk is rendered
+    m_chunkFrames = frames / 4;
+    if(m_chunkFrames > 512)
+        m_chunkFrames = 512;
+    m_idleSleepMs = idleSleepMs > 0 ? idleSleepMs : 1;
+    m_readPos = 0;
+    m_writePos = 0;
+    m_quit = 0;
+
+    if(!p)
+        p = new Impl;
+
+    if(!createThread())
+        return false;
+
+    adl_atomicStore(&m_running, 1);
+    return true;
+}
+
+void AsyncRenderThread::stop()
+{
+    if(!running())
+        return;
+
+    // The reader takes nothing since now, rendered frames get dropped by the next start()
+    adl_atomicStore(&m_running, 0);
+    adl_atomicStore(&m_quit, 1);
+    joinThread();
+}
+
+size_t AsyncRenderThread::buffered() const
+{
+    return adl_atomicLoad(&m_writePos) - adl_atomicLoad(&m_readPos);
+}
+
+size_t AsyncRenderThread::read(uint8_t *left, uint8_t *right, size_t frames, size_t sampleOffset)
+{
+    if(!running())
+        return 0;
+
+    const uint32_t readPos = m_readPos;
+    const size_t available = adl_atomicLoad(&m_writePos) - readPos;
+    const size_t capacity = (size_t)m_mask + 1;
+    size_t taken = 0;
+
+    if(frames > available)
+        frames = available;
+
+    while(taken < frames)
+    {
+        const size_t index = (readPos + taken) & m_mask;
+        size_t count = frames - taken;
+        const uint8_t *src = m_ring.data + index * m_frameSize;
+
+        if(count > capacity - index)
+            count = capacity - index;
+
+        if(right == left + m_sampleSize && sampleOffset == m_frameSize)
+        {
+            // Interleaved output of the same layout
+            memcpy(left, src, count * m_frameSize);
+            left += count * m_frameSize;
+            right += count * m_frameSize;
+        }
+        else
+        {
+            for(size_t i = 0; i < count; ++i)
+            {
+                memcpy(left, src, m_sampleSize);
+                memcpy(right, src + m_sampleSize, m_sampleSize);
+                src += m_frameSize;
+                left += sampleOffset;
+                right += sampleOffset;
+            }
+        }
+
+        taken += count;
+    }
+
+    adl_atomicStore(&m_readPos, readPos + static_cast<uint32_t>(frames));
+    return frames;
+}
+
+void AsyncRenderThread::renderLoop()
+{
+    const size_t capacity = (size_t)m_mask + 1;
+
+    while(!adl_atomicLoad(&m_quit))
+    {
+        const uint32_t writePos = m_writePos;
+        const size_t space = capacity - (writePos - adl_atomicLoad(&m_readPos));
+
+        if(space < m_chunkFrames)
+        {
+            idle();
+            continue;
+        }
+
+        // Chunks never cross the end of the ring: both sizes are powers of two
+        m_func(m_userData, m_ring.data + (writePos & m_mask) * m_frameSize, m_chunkFrames);
+        adl_atomicStore(&m_writePos, writePos + static_cast<uint32_t>(m_chunkFrames));
+    }
+}
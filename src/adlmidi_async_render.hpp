@@ -0,0 +1,147 @@
+/*
+ * libADLMIDI is a free Software MIDI synthesizer library with OPL3 emulation
+ *
+ * Original ADLMIDI code: Copyright (c) 2010-2014 Joel Yliluoma <bisqwit@iki.fi>
+ * ADLMIDI Library API:   Copyright (c) 2015-2026 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * Library is based on the ADLMIDI, a MIDI player for Linux and Windows with OPL3 emulation:
+ * http://iki.fi/bisqwit/source/adlmidi.html
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADLMIDI_ASYNC_RENDER_HPP
+#define ADLMIDI_ASYNC_RENDER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include "adlmidi_arr.hpp"
+#include "adlmidi_atomic.hpp"
+#include "adlmidi_render_threads.hpp"
+
+/**
+ * @brief Background thread that keeps the ring buffer of output frames filled ahead of time
+ *
+ * The render thread is the only producer of the ring, the reader (audio callback)
+ * is the only consumer, and they don't wait for each other: the reader takes the
+ * frames rendered so far, the render thread sleeps while the ring is full.
+ */
+class AsyncRenderThread
+{
+public:
+    /**
+     * @brief Render function
+     * @param userData Pointer to the user data
+     * @param dst Destination of interleaved frames
+     * @param frames Count of frames to render
+     */
+    typedef void (*RenderFunc)(void *userData, uint8_t *dst, size_t frames);
+
+    //! Maximum count of frames in the ring buffer
+    enum { MaxFrames = 0x100000 };
+
+    AsyncRenderThread();
+    ~AsyncRenderThread();
+
+    /**
+     * @brief Is the background rendering supported on this platform?
+     * @return true when the render thread can be started
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Start the render thread
+     * @param func Render function, called by the render thread only
+     * @param userData Pointer to the user data passed into the render function
+     * @param bufferFrames Count of frames in the ring buffer, rounded up to the power of two
+     * @param sampleSize Size of one sample of one channel in bytes
+     * @param idleSleepMs Time to sleep while the ring buffer is full, in milliseconds
+     * @return true on success, false if the thread can't be started
+     */
+    bool start(RenderFunc func, void *userData, size_t bufferFrames, size_t sampleSize, unsigned idleSleepMs);
+
+    /**
+     * @brief Stop and join the render thread, buffered frames are dropped
+     *
+     * The ring buffer is kept until the next start() or the destruction,
+     * so the reader may still call read() at the same time: it returns 0.
+     */
+    void stop();
+
+    /**
+     * @brief Is the render thread running?
+     * @return true if the render thread is running
+     */
+    bool running() const
+    {
+        return adl_atomicLoad(&m_running) != 0;
+    }
+
+    /**
+     * @brief Count of rendered frames not read yet
+     * @return Count of buffered frames
+     */
+    size_t buffered() const;
+
+    /**
+     * @brief Take rendered frames from the ring buffer, called by the reader thread only
+     * @param left Destination of left channel samples
+     * @param right Destination of right channel samples
+     * @param frames Maximum count of frames to take
+     * @param sampleOffset Distance in bytes between consecutive samples of the destination
+     * @return Count of taken frames, less than requested when the ring buffer runs empty, 0 when stopped
+     */
+    size_t read(uint8_t *left, uint8_t *right, size_t frames, size_t sampleOffset);
+
+private:
+    AsyncRenderThread(const AsyncRenderThread &);
+    AsyncRenderThread &operator=(const AsyncRenderThread &);
+
+    struct Impl;
+    friend void *asyncRenderThreadMain(void *self);
+
+    //! Start the thread running renderLoop()
+    bool createThread();
+    //! Wait until the thread will exit
+    void joinThread();
+    //! Fill the ring buffer until the thread will be stopped
+    void renderLoop();
+    //! Sleep while the ring buffer is full
+    void idle();
+
+    RenderFunc m_func;
+    void      *m_userData;
+    //! Ring buffer of interleaved frames
+    adl_array<uint8_t> m_ring;
+    //! Mask of ring buffer frame indices
+    uint32_t m_mask;
+    //! Size of one sample of one channel in bytes
+    size_t   m_sampleSize;
+    //! Size of one interleaved frame in bytes
+    size_t   m_frameSize;
+    //! Maximum count of frames rendered at once
+    size_t   m_chunkFrames;
+    unsigned m_idleSleepMs;
+    //! Count of frames taken by the reader
+    volatile uint32_t m_readPos;
+    //! Count of frames rendered by the render thread
+    volatile uint32_t m_writePos;
+    //! Set to stop the render thread
+    volatile uint32_t m_quit;
+    //! Set while the render thread is running, the reader takes nothing when it's clear
+    volatile uint32_t m_running;
+    Impl    *p;
+};
+
+#endif // ADLMIDI_ASYNC_RENDER_HPP
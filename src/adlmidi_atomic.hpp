@@ -0,0 +1,126 @@
+/*
+ * libADLMIDI is a free Software MIDI synthesizer library with OPL3 emulation
+ *
+ * Original ADLMIDI code: Copyright (c) 2010-2014 Joel Yliluoma <bisqwit@iki.fi>
+ * ADLMIDI Library API:   Copyright (c) 2015-2026 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * Library is based on the ADLMIDI, a MIDI player for Linux and Windows with OPL3 emulation:
+ * http://iki.fi/bisqwit/source/adlmidi.html
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADLMIDI_ATOMIC_HPP
+#define ADLMIDI_ATOMIC_HPP
+
+#include <stdint.h>
+
+/*
+ * Operations on 32-bit words shared between threads without locks:
+ * loads have acquire, stores have release, exchanges and additions have both semantics
+ */
+#if defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7) || defined(__clang__))
+static inline uint32_t adl_atomicLoad(const volatile uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void adl_atomicStore(volatile uint32_t *p, uint32_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t adl_atomicExchange(volatile uint32_t *p, uint32_t v)
+{
+    return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL);
+}
+
+static inline uint32_t adl_atomicFetchAdd(volatile uint32_t *p, uint32_t v)
+{
+    return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+}
+#elif defined(__GNUC__)
+static inline uint32_t adl_atomicLoad(const volatile uint32_t *p)
+{
+    uint32_t v = *p;
+    __sync_synchronize();
+    return v;
+}
+
+static inline void adl_atomicStore(volatile uint32_t *p, uint32_t v)
+{
+    __sync_synchronize();
+    *p = v;
+}
+
+static inline uint32_t adl_atomicExchange(volatile uint32_t *p, uint32_t v)
+{
+    __sync_synchronize(); // The builtin is an acquire barrier only
+    return __sync_lock_test_and_set(p, v);
+}
+
+static inline uint32_t adl_atomicFetchAdd(volatile uint32_t *p, uint32_t v)
+{
+    return __sync_fetch_and_add(p, v);
+}
+#elif defined(_MSC_VER)
+#   include <intrin.h>
+// Interlocked operations are full barriers on every target
+static inline uint32_t adl_atomicLoad(const volatile uint32_t *p)
+{
+    return (uint32_t)_InterlockedCompareExchange((volatile long *)p, 0, 0);
+}
+
+static inline void adl_atomicStore(volatile uint32_t *p, uint32_t v)
+{
+    _InterlockedExchange((volatile long *)p, (long)v);
+}
+
+static inline uint32_t adl_atomicExchange(volatile uint32_t *p, uint32_t v)
+{
+    return (uint32_t)_InterlockedExchange((volatile long *)p, (long)v);
+}
+
+static inline uint32_t adl_atomicFetchAdd(volatile uint32_t *p, uint32_t v)
+{
+    return (uint32_t)_InterlockedExchangeAdd((volatile long *)p, (long)v);
+}
+#else
+// Platforms without threads: shared words are changed by interrupt handlers at most
+static inline uint32_t adl_atomicLoad(const volatile uint32_t *p)
+{
+    return *p;
+}
+
+static inline void adl_atomicStore(volatile uint32_t *p, uint32_t v)
+{
+    *p = v;
+}
+
+static inline uint32_t adl_atomicExchange(volatile uint32_t *p, uint32_t v)
+{
+    uint32_t old = *p;
+    *p = v;
+    return old;
+}
+
+static inline uint32_t adl_atomicFetchAdd(volatile uint32_t *p, uint32_t v)
+{
+    uint32_t old = *p;
+    *p = old + v;
+    return old;
+}
+#endif
+
+#endif // ADLMIDI_ATOMIC_HPP
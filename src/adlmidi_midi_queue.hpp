@@ -0,0 +1,169 @@
+/*
+ * libADLMIDI is a free Software MIDI synthesizer library with OPL3 emulation
+ *
+ * Original ADLMIDI code: Copyright (c) 2010-2014 Joel Yliluoma <bisqwit@iki.fi>
+ * ADLMIDI Library API:   Copyright (c) 2015-2026 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * Library is based on the ADLMIDI, a MIDI player for Linux and Windows with OPL3 emulation:
+ * http://iki.fi/bisqwit/source/adlmidi.html
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADLMIDI_MIDI_QUEUE_HPP
+#define ADLMIDI_MIDI_QUEUE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include "adlmidi_arr.hpp"
+#include "adlmidi_atomic.hpp"
+
+/**
+ * @brief Wait-free queue of MIDI events between one producer and one consumer thread
+ *
+ * The producer (MIDI input thread) calls push(), the consumer (render call)
+ * calls pop(). Neither of them waits for the other one, events which don't
+ * fit into the full queue are dropped and counted.
+ */
+class MidiInputQueue
+{
+public:
+    /**
+     * @brief MIDI channel message waiting in the queue
+     */
+    struct Event
+    {
+        //! Offset from the start of the block generated after the event is taken from the queue, in output frames
+        uint32_t frameOffset;
+        //! Raw MIDI message
+        uint8_t  data[3];
+        //! Length of the message
+        uint8_t  size;
+    };
+
+    MidiInputQueue() :
+        m_mask(0),
+        m_head(0),
+        m_tail(0),
+        m_overflows(0)
+    {}
+
+    /**
+     * @brief Change the capacity of the queue, queued events are dropped
+     *
+     * Not thread-safe: neither the producer nor the consumer may use the queue meanwhile.
+     *
+     * @param capacity Maximum count of queued events, rounded up to the power of two, 0 to disable the queue
+     * @return true on success, false if capacity is too big
+     */
+    bool setCapacity(size_t capacity)
+    {
+        size_t size = 1;
+
+        if(capacity > 0x40000000)
+            return false;
+
+        while(size < capacity)
+            size <<= 1;
+
+        if(capacity == 0)
+        {
+            m_events.clear();
+            m_mask = 0;
+        }
+        else
+        {
+            m_events.resize(size);
+            m_mask = static_cast<uint32_t>(size - 1);
+        }
+
+        m_head = m_tail = 0;
+        return true;
+    }
+
+    /**
+     * @brief Maximum count of queued events
+     * @return Capacity of the queue, 0 if the queue is disabled
+     */
+    size_t capacity() const
+    {
+        return m_events.size;
+    }
+
+    /**
+     * @brief Put the event into the queue, called by the producer thread only
+     * @param event Event to put
+     * @return true on success, false if the queue is full or disabled
+     */
+    bool push(const Event &event)
+    {
+        if(m_events.size == 0)
+            return false;
+
+        const uint32_t tail = m_tail;
+
+        if(tail - adl_atomicLoad(&m_head) > m_mask)
+        {
+            adl_atomicStore(&m_overflows, m_overflows + 1);
+            return false;
+        }
+
+        m_events.data[tail & m_mask] = event;
+        adl_atomicStore(&m_tail, tail + 1);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest event from the queue, called by the consumer thread only
+     * @param event Destination of the taken event
+     * @return true on success, false if the queue is empty
+     */
+    bool pop(Event &event)
+    {
+        const uint32_t head = m_head;
+
+        if(head == adl_atomicLoad(&m_tail))
+            return false;
+
+        event = m_events.data[head & m_mask];
+        adl_atomicStore(&m_head, head + 1);
+        return true;
+    }
+
+    /**
+     * @brief Count of events dropped because the queue was full
+     * @return Count of dropped events
+     */
+    uint32_t overflows() const
+    {
+        return adl_atomicLoad(&m_overflows);
+    }
+
+private:
+    //! Ring buffer of events
+    adl_array<Event> m_events;
+    //! Mask of ring buffer indices
+    uint32_t m_mask;
+    //! Count of taken events, changed by the consumer
+    volatile uint32_t m_head;
+    //! Count of put events, changed by the producer
+    volatile uint32_t m_tail;
+    //! Count of dropped events, changed by the producer
+    volatile uint32_t m_overflows;
+
+    MidiInputQueue(const MidiInputQueue &);
+    MidiInputQueue &operator=(const MidiInputQueue &);
+};
+
+#endif // ADLMIDI_MIDI_QUEUE_HPP
@@ -24,6 +24,7 @@
 #include "adlmidi_midiplay.hpp"
 #include "adlmidi_opl3.hpp"
 #include "adlmidi_private.hpp"
+#include "adlmidi_async_render.hpp"
 #ifndef ADLMIDI_DISABLE_MIDI_SEQUENCER
 #   define BWMIDI_ENABLE_OPL_MUSIC_SUPPORT
 #   include "midiseq/midi_sequencer.hpp"
@@ -73,7 +74,8 @@ MIDIplay::MIDIplay(unsigned long sampleRate):
     m_cmfPercussionMode(false),
     m_sysExDeviceId(0),
     m_synthMode(Mode_XG),
-    m_arpeggioCounter(0)
+    m_arpeggioCounter(0),
+    m_scheduleClock(0)
 #if defined(ADLMIDI_AUDIO_TICK_HANDLER)
     , m_audioTickCounter(0)
 #endif
@@ -112,6 +114,12 @@ MIDIplay::MIDIplay(unsigned long sampleRate):
     m_setup.carry = 0.0;
     m_setup.tick_skip_samples_delay = 0;
 
+    m_inputQueue.setCapacity(1024);
+    m_asyncFormat = ADLMIDI_AudioFormat();
+    m_asyncPlayMusic = false;
+    std::memset(&m_stagedWriter, 0, sizeof(m_stagedWriter));
+    std::memset(&m_stagedApplied, 0, sizeof(m_stagedApplied));
+
     m_synth.reset(new Synth);
 
 #ifndef ADLMIDI_DISABLE_MIDI_SEQUENCER
@@ -187,6 +195,7 @@ void MIDIplay::partialReset()
 {
     Synth &synth = *m_synth;
     realTime_panic();
+    clearScheduledEvents();
     m_setup.tick_skip_samples_delay = 0;
     synth.m_runAtPcmRate = m_setup.runAtPcmRate;
     chipReset();
@@ -263,12 +272,40 @@ void MIDIplay::resetMIDIDefaults(int offset)
 void MIDIplay::TickIterators(double s)
 {
     Synth &synth = *m_synth;
+    Synth::WriteBatch batch(synth);
+#ifdef ADLMIDI_ENABLE_HW_SERIAL
+    const double elapsed = s;
+#endif
     for(uint32_t c = 0, n = synth.m_numChannels; c < n; ++c)
     {
         AdlChannel &ch = m_chipChannels[c];
         ch.addAge(static_cast<int64_t>(s * 1e6));
     }
 
+    // Let the synth skip chips which have finished the release of all their notes
+    if(synth.m_skipIdleChips)
+    {
+        for(size_t chip = 0, n = synth.m_numChips; chip < n; ++chip)
+        {
+            if(!synth.isChipActive(chip))
+                continue;
+
+            bool released = true;
+            for(size_t c = chip * NUM_OF_CHANNELS, e = c + NUM_OF_CHANNELS; c < e; ++c)
+            {
+                const AdlChannel &ch = m_chipChannels[c];
+                if(!ch.users.empty() || ch.koff_time_until_neglible_us > 0)
+                {
+                    released = false;
+                    break;
+                }
+            }
+
+            if(released)
+                synth.setChipReleased(chip);
+        }
+    }
+
     // Resolve "hell of all times" of too short drum notes
     for(size_t c = 0, n = m_midiChannels.size; c < n; ++c)
     {
@@ -307,6 +344,11 @@ void MIDIplay::TickIterators(double s)
 #   endif
     updateGlide(s);
 #endif
+
+#ifdef ADLMIDI_ENABLE_HW_SERIAL
+    // All register writes of this tick are done, send them to the hardware chip together
+    synth.flushSerial(elapsed);
+#endif
 }
 
 void MIDIplay::realTime_ResetState()
@@ -333,6 +375,7 @@ void MIDIplay::realTime_ResetState()
 bool MIDIplay::realTime_NoteOn(uint8_t channel, uint8_t note, uint8_t velocity)
 {
     Synth &synth = *m_synth;
+    Synth::WriteBatch batch(synth);
 
     if(note > 127)
         note = 127;
@@ -748,6 +791,7 @@ bool MIDIplay::realTime_NoteOn(uint8_t channel, uint8_t note, uint8_t velocity)
 
 void MIDIplay::realTime_NoteOff(uint8_t channel, uint8_t note)
 {
+    Synth::WriteBatch batch(*m_synth);
     if(static_cast<size_t>(channel) > m_midiChannels.size)
         channel = channel % 16;
     noteOff(channel, note);
@@ -785,6 +829,7 @@ void MIDIplay::realTime_ChannelAfterTouch(uint8_t channel, uint8_t atVal)
 void MIDIplay::realTime_Controller(uint8_t channel, uint8_t type, uint8_t value)
 {
     Synth &synth = *m_synth;
+    Synth::WriteBatch batch(synth);
 
     if(value > 127) // Allowed values 0~127 only
         value = 127;
@@ -963,6 +1008,7 @@ void MIDIplay::realTime_PatchChange(uint8_t channel, uint8_t patch)
 
 void MIDIplay::realTime_PitchBend(uint8_t channel, uint16_t pitch)
 {
+    Synth::WriteBatch batch(*m_synth);
     if(static_cast<size_t>(channel) > m_midiChannels.size)
         channel = channel % 16;
     m_midiChannels[channel].bend = int(pitch) - 8192;
@@ -971,6 +1017,7 @@ void MIDIplay::realTime_PitchBend(uint8_t channel, uint16_t pitch)
 
 void MIDIplay::realTime_PitchBend(uint8_t channel, uint8_t msb, uint8_t lsb)
 {
+    Synth::WriteBatch batch(*m_synth);
     if(static_cast<size_t>(channel) > m_midiChannels.size)
         channel = channel % 16;
     m_midiChannels[channel].bend = int(lsb) + int(msb) * 128 - 8192;
@@ -1009,6 +1056,7 @@ bool MIDIplay::realTime_SysEx(const uint8_t *msg, size_t size)
     if(size < 4 || msg[0] != 0xF0 || msg[size - 1] != 0xF7)
         return false;
 
+    Synth::WriteBatch batch(*m_synth);
     unsigned manufacturer = msg[1];
     unsigned dev = msg[2];
     msg += 3;
@@ -1222,6 +1270,7 @@ bool MIDIplay::doYamahaSysEx(unsigned dev, const uint8_t *data, size_t size)
 
 void MIDIplay::realTime_panic()
 {
+    Synth::WriteBatch batch(*m_synth);
     panic();
     killSustainingNotes(-1, -1, AdlChannel::LocationData::Sustain_ANY);
 }
@@ -1289,6 +1338,197 @@ uint32_t MIDIplay::getReservedChipChannels(size_t chipId) const
     return m_reservedChipChannels[chipId];
 }
 
+size_t MIDIplay::channelMessageSize(const uint8_t *msg, size_t size)
+{
+    if(!msg || size < 2 || msg[0] < 0x80 || msg[0] >= 0xF0)
+        return 0; // Channel messages only
+
+    const size_t need = ((msg[0] & 0xF0) == 0xC0 || (msg[0] & 0xF0) == 0xD0) ? 2 : 3;
+    if(size < need)
+        return 0;
+
+    for(size_t i = 1; i < need; ++i)
+    {
+        if(msg[i] >= 0x80)
+            return 0;
+    }
+
+    return need;
+}
+
+bool MIDIplay::realTime_scheduleEvent(uint32_t frameOffset, const uint8_t *msg, size_t size)
+{
+    const size_t need = channelMessageSize(msg, size);
+    if(need == 0)
+        return false;
+
+#ifdef ADLMIDI_HW_OPL
+    // Hardware chips don't generate any output to schedule events at
+    (void)frameOffset;
+    realTime_channelMessage(msg);
+    return true;
+#else
+    const uint64_t frame = m_scheduleClock + frameOffset;
+
+    // Events usually come in order, find the place from the end, events of the same frame keep their order
+    size_t pos = m_scheduledEvents.count();
+    while(pos > 0 && m_scheduledEvents[pos - 1].frame > frame)
+        --pos;
+
+    ScheduledEvent &e = m_scheduledEvents.insert(pos);
+    e.frame = frame;
+    e.size = static_cast<uint8_t>(need);
+    e.data[0] = msg[0];
+    e.data[1] = msg[1];
+    e.data[2] = need > 2 ? msg[2] : 0;
+
+    return true;
+#endif
+}
+
+void MIDIplay::processScheduledEvents(size_t frames)
+{
+    const uint64_t end = m_scheduleClock + frames;
+
+    if(!m_scheduledEvents.empty() && m_scheduledEvents.front().frame < end)
+    {
+        Synth &synth = *m_synth;
+
+        while(!m_scheduledEvents.empty())
+        {
+            const ScheduledEvent &e = m_scheduledEvents.front();
+            if(e.frame >= end)
+                break;
+
+            // Register writes of the event get applied at its frame of the block
+            synth.setWriteTime(static_cast<size_t>(e.frame - m_scheduleClock));
+            realTime_channelMessage(e.data);
+            m_scheduledEvents.pop();
+        }
+
+        synth.setWriteTime(0);
+    }
+
+    m_scheduleClock = end;
+}
+
+void MIDIplay::clearScheduledEvents()
+{
+    m_scheduledEvents.clear();
+}
+
+bool MIDIplay::realTime_enqueueEvent(uint32_t frameOffset, const uint8_t *msg, size_t size)
+{
+    const size_t need = channelMessageSize(msg, size);
+    if(need == 0)
+        return false;
+
+    MidiInputQueue::Event e;
+    e.frameOffset = frameOffset;
+    e.size = static_cast<uint8_t>(need);
+    e.data[0] = msg[0];
+    e.data[1] = msg[1];
+    e.data[2] = need > 2 ? msg[2] : 0;
+
+    return m_inputQueue.push(e);
+}
+
+void MIDIplay::drainInputQueue()
+{
+    MidiInputQueue::Event e;
+
+    while(m_inputQueue.pop(e))
+        realTime_scheduleEvent(e.frameOffset, e.data, e.size);
+}
+
+bool MIDIplay::setInputQueueCapacity(size_t capacity)
+{
+    return m_inputQueue.setCapacity(capacity);
+}
+
+uint32_t MIDIplay::inputQueueOverflows() const
+{
+    return m_inputQueue.overflows();
+}
+
+bool MIDIplay::stageSetting(int setting, int value)
+{
+    if(setting < 0 || setting >= ADLMIDI_Stage_Count)
+        return false;
+
+    m_stagedWriter.mask |= 1u << setting;
+    m_stagedWriter.values[setting] = value;
+    ++m_stagedWriter.serials[setting];
+
+    // Every published block holds all staged settings, so the missed ones aren't lost
+    m_stagedSettings.back() = m_stagedWriter;
+    m_stagedSettings.publish();
+    return true;
+}
+
+bool MIDIplay::takeStagedSettings(StagedSettings &changes)
+{
+    const StagedSettings *staged = m_stagedSettings.take();
+
+    changes.mask = 0;
+
+    if(!staged)
+        return false;
+
+    for(int i = 0; i < ADLMIDI_Stage_Count; ++i)
+    {
+        const uint32_t bit = 1u << i;
+
+        if((staged->mask & bit) == 0)
+            continue;
+
+        // Settings may be changed directly meanwhile, so the same value staged again
+        // must be applied again: compare staging calls, not values
+        if((m_stagedApplied.mask & bit) != 0 && m_stagedApplied.serials[i] == staged->serials[i])
+            continue;
+
+        changes.mask |= bit;
+        changes.values[i] = staged->values[i];
+        m_stagedApplied.mask |= bit;
+        m_stagedApplied.values[i] = staged->values[i];
+        m_stagedApplied.serials[i] = staged->serials[i];
+    }
+
+    return changes.mask != 0;
+}
+
+void MIDIplay::realTime_channelMessage(const uint8_t *msg)
+{
+    const uint8_t channel = msg[0] & 0x0F;
+
+    switch(msg[0] & 0xF0)
+    {
+    case 0x80:
+        realTime_NoteOff(channel, msg[1]);
+        break;
+    case 0x90:
+        realTime_NoteOn(channel, msg[1], msg[2]);
+        break;
+    case 0xA0:
+        realTime_NoteAfterTouch(channel, msg[1], msg[2]);
+        break;
+    case 0xB0:
+        realTime_Controller(channel, msg[1], msg[2]);
+        break;
+    case 0xC0:
+        realTime_PatchChange(channel, msg[1]);
+        break;
+    case 0xD0:
+        realTime_ChannelAfterTouch(channel, msg[1]);
+        break;
+    case 0xE0:
+        realTime_PitchBend(channel, msg[2], msg[1]);
+        break;
+    default:
+        break;
+    }
+}
+
 #if defined(ADLMIDI_AUDIO_TICK_HANDLER)
 void MIDIplay::AudioTick(uint32_t chipId, uint32_t rate)
 {
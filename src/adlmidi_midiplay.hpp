@@ -32,6 +32,8 @@
 #include "adlmidi_private.hpp"
 #include "adlmidi_ptr.hpp"
 #include "adlmidi_arr.hpp"
+#include "adlmidi_midi_queue.hpp"
+#include "adlmidi_staged.hpp"
 #include "structures/pl_list.hpp"
 
 /**
@@ -740,6 +742,49 @@ private:
     //! Counter of arpeggio processing
     size_t m_arpeggioCounter;
 
+    /**
+     * @brief MIDI channel message scheduled at the frame of generated output
+     */
+    struct ScheduledEvent
+    {
+        //! Output frame (counted by m_scheduleClock) to process the event at
+        uint64_t frame;
+        //! Raw MIDI message
+        uint8_t  data[3];
+        //! Length of the message
+        uint8_t  size;
+    };
+    //! Scheduled events in the order of their frames
+    adl_fifo<ScheduledEvent> m_scheduledEvents;
+    //! Count of output frames generated by the real-time generator
+    uint64_t m_scheduleClock;
+    //! Events sent by the MIDI input thread, taken by render calls
+    MidiInputQueue m_inputQueue;
+
+public:
+    /**
+     * @brief Values of settings staged by another thread than render calls
+     */
+    struct StagedSettings
+    {
+        //! Bits of staged settings, indexed by ADLMIDI_StagedSetting
+        uint32_t mask;
+        //! Values of staged settings
+        int values[ADLMIDI_Stage_Count];
+        //! Counts of staging calls of every setting, a new call gets applied even with the same value
+        uint32_t serials[ADLMIDI_Stage_Count];
+    };
+
+private:
+    //! All settings staged so far, changed by the staging thread
+    StagedSettings m_stagedWriter;
+    //! Settings applied by render calls
+    StagedSettings m_stagedApplied;
+    //! Settings published by the staging thread, taken by render calls
+    StagedBlock<StagedSettings> m_stagedSettings;
+
+public:
+
 #if defined(ADLMIDI_AUDIO_TICK_HANDLER)
     //! Audio tick counter
     uint32_t m_audioTickCounter;
@@ -768,6 +813,13 @@ public:
     //! Generator output buffer
     int32_t m_outBuf[1024];
 
+    //! Background render thread, when the asynchronous rendering is started
+    AdlMIDI_UPtr<AsyncRenderThread> m_asyncRender;
+    //! Output format of the asynchronous rendering
+    ADLMIDI_AudioFormat m_asyncFormat;
+    //! Does the asynchronous rendering play the music file, or generate the real-time output only?
+    bool m_asyncPlayMusic;
+
     //! Synthesizer setup
     Setup m_setup;
 
@@ -1016,6 +1068,88 @@ public:
      */
     uint32_t getReservedChipChannels(size_t chipId) const;
 
+    /**
+     * @brief Schedule the MIDI channel message at the frame of the generated output
+     * @param frameOffset Offset from the start of the next generated block, in output frames
+     * @param msg Raw MIDI channel message: the status byte and its data bytes
+     * @param size Length of the message
+     * @return true if message was scheduled, false if it's not a valid channel message
+     */
+    bool realTime_scheduleEvent(uint32_t frameOffset, const uint8_t *msg, size_t size);
+
+    /**
+     * @brief Process scheduled events which fall into the next generated block
+     *
+     * Register writes of events are timed to their frames of the block.
+     *
+     * @param frames Count of frames of the block which is generated next
+     */
+    void processScheduledEvents(size_t frames);
+
+    /**
+     * @brief Drop all scheduled events which are not processed yet
+     */
+    void clearScheduledEvents();
+
+    /**
+     * @brief Put the MIDI channel message into the input queue, may be called by another thread than render calls
+     * @param frameOffset Offset from the start of the block generated after the message is taken from the queue, in output frames
+     * @param msg Raw MIDI channel message: the status byte and its data bytes
+     * @param size Length of the message
+     * @return true if message was queued, false if it's not a valid channel message or the queue is full
+     */
+    bool realTime_enqueueEvent(uint32_t frameOffset, const uint8_t *msg, size_t size);
+
+    /**
+     * @brief Schedule all events waiting in the input queue, called by render calls
+     */
+    void drainInputQueue();
+
+    /**
+     * @brief Change the capacity of the input queue, queued events are dropped
+     * @param capacity Maximum count of queued events, 0 to disable the queue
+     * @return true on success, false if capacity is too big
+     */
+    bool setInputQueueCapacity(size_t capacity);
+
+    /**
+     * @brief Count of events dropped because the input queue was full
+     * @return Count of dropped events
+     */
+    uint32_t inputQueueOverflows() const;
+
+    /**
+     * @brief Stage the change of the setting, may be called by another thread than render calls
+     * @param setting Setting to change (ADLMIDI_StagedSetting)
+     * @param value New value of the setting
+     * @return true on success, false if setting is unknown
+     */
+    bool stageSetting(int setting, int value);
+
+    /**
+     * @brief Take settings staged since the previous take, called by render calls
+     * @param changes Destination of settings to apply
+     * @return true if any setting has to be applied
+     */
+    bool takeStagedSettings(StagedSettings &changes);
+
+private:
+    /**
+     * @brief Length of the MIDI channel message by its status byte
+     * @param msg Raw MIDI channel message: the status byte and its data bytes
+     * @param size Length of the message buffer
+     * @return Length of the message, 0 if it's not a valid channel message
+     */
+    static size_t channelMessageSize(const uint8_t *msg, size_t size);
+
+    /**
+     * @brief Perform the raw MIDI channel message
+     * @param msg Raw MIDI channel message: the status byte and its data bytes
+     */
+    void realTime_channelMessage(const uint8_t *msg);
+
+public:
+
 #if defined(ADLMIDI_AUDIO_TICK_HANDLER)
     // Audio rate tick handler
     void AudioTick(uint32_t chipId, uint32_t rate);
@@ -27,6 +27,11 @@
 #include <cassert>
 
 #include "models/opl_models.h"
+#include "chips/opl_resampler.h"
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+#   include "chips/opl_chip_base.h"
+#endif
+#include "adlmidi_render_threads.hpp"
 
 
 #ifdef ENABLE_HW_OPL_DOS
@@ -49,6 +54,7 @@
 #   ifndef ADLMIDI_DISABLE_NUKED_EMULATOR
 #       include "chips/nuked_opl3.h"
 #       include "chips/nuked_opl3_fast.h"
+#       include "chips/nuked_opl3_simd.h"
 #       include "chips/nuked_opl2.h"
 #       include "chips/nuked_cqm.h"
 #   endif
@@ -101,10 +107,19 @@
 #   endif
 #endif
 
+#if defined(ADLMIDI_SINGLE_EMULATOR) && (defined(ENABLE_HW_OPL_DOS) || defined(ADLMIDI_ENABLE_HW_SERIAL))
+#   error "The single emulator build can't be combined with the hardware OPL3 chip support!"
+#endif
+
+#ifdef ADLMIDI_SINGLE_EMULATOR
+// Only one emulator is available, its chips get called directly
+static const unsigned adl_emulatorSupport = 1u << ADLMIDI_SINGLE_EMULATOR;
+#else
 static const unsigned adl_emulatorSupport = 0
 #ifndef ENABLE_HW_OPL_DOS
 #   ifndef ADLMIDI_DISABLE_NUKED_EMULATOR
     | (1u << ADLMIDI_EMU_NUKED) | (1u << ADLMIDI_EMU_NUKED_FAST) | (1u << ADLMIDI_EMU_NUKED_OPL2_LITE) | (1u << ADLMIDI_EMU_NUKED_CQM)
+    | (1u << ADLMIDI_EMU_NUKED_SIMD)
 #   endif
 
 #   ifndef ADLMIDI_DISABLE_DOSBOX_EMULATOR
@@ -142,6 +157,66 @@ static const unsigned adl_emulatorSupport = 0
 #   endif
 #endif
 ;
+#endif // ADLMIDI_SINGLE_EMULATOR
+
+#ifdef ADLMIDI_SINGLE_EMULATOR
+/**
+ * @brief Class of chips made by the emulator, only emulators built in have it
+ */
+template<int emulator>
+struct OPLChipOfEmulator;
+
+#define ADLMIDI_CHIP_OF_EMULATOR(emulator, chipClass) \
+    template<> struct OPLChipOfEmulator<emulator> { typedef chipClass type; };
+
+#   ifndef ADLMIDI_DISABLE_NUKED_EMULATOR
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_NUKED, NukedOPL3)
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_NUKED_FAST, NukedOPL3v174)
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_NUKED_OPL2_LITE, NukedOPL2)
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_NUKED_CQM, NukedCQM)
+// Chips are either standalone or members of groups, so their class varies
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_NUKED_SIMD, OPLChipBase)
+#   endif
+#   ifndef ADLMIDI_DISABLE_DOSBOX_EMULATOR
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_DOSBOX, DosBoxOPL3)
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_DOSBOX_OPL2, DosBoxOPL2)
+#   endif
+#   ifndef ADLMIDI_DISABLE_OPAL_EMULATOR
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_OPAL, OpalOPL3)
+#   endif
+#   ifndef ADLMIDI_DISABLE_JAVA_EMULATOR
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_JAVA, JavaOPL3)
+#   endif
+#   ifndef ADLMIDI_DISABLE_ESFMU_EMULATOR
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_ESFMu, ESFMuOPL3)
+#   endif
+#   ifndef ADLMIDI_DISABLE_MAME_OPL2_EMULATOR
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_MAME_OPL2, MameOPL2)
+#   endif
+#   ifndef ADLMIDI_DISABLE_YMFM_EMULATOR
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_YMFM_OPL2, YmFmOPL2)
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_YMFM_OPL3, YmFmOPL3)
+#   endif
+#   ifdef ADLMIDI_ENABLE_OPL2_LLE_EMULATOR
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_NUKED_OPL2_LLE, Ym3812LLEOPL2)
+#   endif
+#   ifdef ADLMIDI_ENABLE_OPL3_LLE_EMULATOR
+ADLMIDI_CHIP_OF_EMULATOR(ADLMIDI_EMU_NUKED_OPL3_LLE, Ymf262LLEOPL3)
+#   endif
+
+#undef ADLMIDI_CHIP_OF_EMULATOR
+
+// Emulator classes are final, so calls through this type don't need the virtual dispatch
+typedef OPLChipOfEmulator<ADLMIDI_SINGLE_EMULATOR>::type OPLChipImpl;
+#else
+typedef OPLChipBase OPLChipImpl;
+#endif
+
+//! Chip as the class of the used emulator when it's known at the build time
+static inline OPLChipImpl &chipImpl(const AdlMIDI_SPtr<OPLChipBase> &chip)
+{
+    return static_cast<OPLChipImpl &>(*chip);
+}
 
 //! Check emulator availability
 bool adl_isEmulatorAvailable(int emulator)
@@ -294,20 +369,34 @@ OPL3::OPL3() :
 #ifdef ENABLE_HW_OPL_DOS
     m_dpmi_locker(this),
 #endif
+    m_writeQueueCount(0),
+    m_writeQueueChip(0),
+    m_writeBatchDepth(0),
+    m_writeClock(0),
+    m_writeTime(0),
 #ifdef ADLMIDI_ENABLE_HW_SERIAL
     m_serial(false),
     m_serialBaud(0),
     m_serialProtocol(0),
+    m_serialThrottle(false),
 #endif
     m_softPanningSup(false),
     m_currentChipType((int)OPLChipBase::CHIPTYPE_OPL3),
     m_perChipChannels(OPL3_CHANNELS_RHYTHM_BASE),
+    m_busSampleCnt(0),
+    m_busRateRatio(0),
+    m_busOutputRate(0),
+    m_renderJobFrames(0),
+    m_renderJobNative(false),
     m_numChips(1),
     m_numFourOps(0),
     m_deepTremoloMode(false),
     m_deepVibratoMode(false),
     m_rhythmMode(false),
     m_softPanning(false),
+    m_resampleMixBus(false),
+    m_resamplerQuality(ADLMIDI_Resampler_Linear),
+    m_skipIdleChips(false),
     m_masterVolume(MasterVolumeDefault),
     m_musicMode(MODE_MIDI),
     m_volumeScale(VOLUME_Generic),
@@ -321,6 +410,9 @@ OPL3::OPL3() :
     m_insBankSetup.scaleModulators = false;
     m_insBankSetup.mt32defaults = false;
 
+    m_busOldSamples[0] = m_busOldSamples[1] = 0;
+    m_busSamples[0] = m_busSamples[1] = 0;
+
 #ifdef DISABLE_EMBEDDED_BANKS
     m_embeddedBank = CustomBankTag;
 #else
@@ -492,17 +584,183 @@ void OPL3::clearInstCache()
 
 void OPL3::writeReg(size_t chip, uint16_t address, uint8_t value)
 {
-    m_chips[chip]->writeReg(address, value);
+    if(!shadowReg(chip, address, value))
+        return;
+
+    m_chipActivity.data[chip] = ChipActive;
+
+    if(m_writeTime > 0 || !m_timedWrites.empty())
+    {
+        // Later writes must not overtake writes which are waiting for their frames
+        queueTimedWrite(chip, address, value, false);
+        return;
+    }
+
+    queueWrite(chip, address, value);
+}
+
+void OPL3::queueWrite(size_t chip, uint16_t address, uint8_t value)
+{
+    if(m_writeBatchDepth == 0)
+    {
+        chipImpl(m_chips[chip]).writeReg(address, value);
+        return;
+    }
+
+    if(m_writeQueueCount > 0 && (m_writeQueueChip != chip || m_writeQueueCount == WriteQueueSize))
+        flushWrites();
+
+    m_writeQueueChip = chip;
+    m_writeQueueAddr[m_writeQueueCount] = address;
+    m_writeQueueData[m_writeQueueCount] = value;
+    ++m_writeQueueCount;
 }
 
 void OPL3::writeRegI(size_t chip, uint32_t address, uint32_t value)
 {
-    m_chips[chip]->writeReg(static_cast<uint16_t>(address), static_cast<uint8_t>(value));
+    writeReg(chip, static_cast<uint16_t>(address), static_cast<uint8_t>(value));
+}
+
+void OPL3::writeRegs(size_t chip, const uint16_t *addresses, const uint8_t *values, size_t count)
+{
+    WriteBatch batch(*this);
+
+    for(size_t i = 0; i < count; ++i)
+        writeReg(chip, addresses[i], values[i]);
+}
+
+void OPL3::flushWrites()
+{
+    if(m_writeQueueCount == 0)
+        return;
+
+    chipImpl(m_chips[m_writeQueueChip]).writeRegs(m_writeQueueAddr, m_writeQueueData, m_writeQueueCount);
+    m_writeQueueCount = 0;
+}
+
+void OPL3::setWriteTime(size_t frames)
+{
+#ifdef ENABLE_HW_OPL_DOS
+    frames = 0; // Hardware chips have no time base of the generated output
+#elif defined(ADLMIDI_ENABLE_HW_SERIAL)
+    if(m_serial)
+        frames = 0;
+#endif
+    m_writeTime = frames;
+}
+
+void OPL3::queueTimedWrite(size_t chip, uint16_t address, uint8_t value, bool pan)
+{
+    uint64_t frame = m_writeClock + m_writeTime;
+
+    if(!m_timedWrites.empty() && frame < m_timedWrites.back().frame)
+        frame = m_timedWrites.back().frame;
+
+    TimedWrite &w = m_timedWrites.push();
+    w.frame = frame;
+    w.chip = static_cast<uint32_t>(chip);
+    w.address = address;
+    w.value = value;
+    w.pan = pan;
+}
+
+void OPL3::applyTimedWrites()
+{
+    WriteBatch batch(*this);
+
+    while(!m_timedWrites.empty())
+    {
+        const TimedWrite &w = m_timedWrites.front();
+        if(w.frame > m_writeClock)
+            break;
+
+        m_chipActivity.data[w.chip] = ChipActive;
+        if(w.pan)
+        {
+            flushWrites();
+            chipImpl(m_chips[w.chip]).writePan(w.address, w.value);
+        }
+        else
+            queueWrite(w.chip, w.address, w.value);
+
+        m_timedWrites.pop();
+    }
+}
+
+void OPL3::clearTimedWrites()
+{
+    m_timedWrites.clear();
 }
 
 void OPL3::writePan(size_t chip, uint32_t address, uint32_t value)
 {
-    m_chips[chip]->writePan(static_cast<uint16_t>(address), static_cast<uint8_t>(value));
+    if(m_writeTime > 0 || !m_timedWrites.empty())
+    {
+        m_chipActivity.data[chip] = ChipActive;
+        queueTimedWrite(chip, static_cast<uint16_t>(address), static_cast<uint8_t>(value), true);
+        return;
+    }
+
+    flushWrites(); // Keep the order of writes
+    m_chipActivity.data[chip] = ChipActive;
+    chipImpl(m_chips[chip]).writePan(static_cast<uint16_t>(address), static_cast<uint8_t>(value));
+}
+
+bool OPL3::shadowReg(size_t chip, uint16_t address, uint8_t value)
+{
+    if(address >= RegShadowSize)
+        return true;
+
+    uint8_t *image = m_regShadow.data + chip * RegShadowSize;
+    uint32_t *known = m_regShadowKnown.data + chip * (RegShadowSize / 32);
+
+    if(m_currentChipType == OPLChipBase::CHIPTYPE_OPL2 && address >= 0x100)
+    {
+        // OPL2 has no second bank, the write may land on the register of the first one
+        known[(address & 0xFF) >> 5] &= ~(1u << (address & 31));
+        return true;
+    }
+
+    uint32_t &knownWord = known[address >> 5];
+    const uint32_t knownBit = 1u << (address & 31);
+
+    // Test, timer and mode registers below 0x20 act on every write, so they are never dropped
+    if((address & 0xFF) >= 0x20 && (knownWord & knownBit) && image[address] == value)
+        return false;
+
+    image[address] = value;
+    knownWord |= knownBit;
+    return true;
+}
+
+void OPL3::clearRegShadow(size_t chip)
+{
+    uint32_t *known = m_regShadowKnown.data + chip * (RegShadowSize / 32);
+    std::memset(known, 0, (RegShadowSize / 32) * sizeof(uint32_t));
+}
+
+bool OPL3::isChipKeyedOn(size_t chip) const
+{
+    const uint32_t *keyCache = m_keyBlockFNumCache.data + chip * NUM_OF_CHANNELS;
+
+    for(size_t cc = 0; cc < OPL3_CHANNELS_RHYTHM_BASE; ++cc)
+    {
+        if(keyCache[cc] & 0x20)
+            return true;
+    }
+
+    return m_rhythmMode && (m_regBD.data[chip] & 0x1F) != 0;
+}
+
+void OPL3::setChipReleased(size_t chip)
+{
+#if defined(ADLMIDI_AUDIO_TICK_HANDLER)
+    if(chip == 0)
+        return; // The first chip drives the audio tick handler and must run always
+#endif
+
+    if(m_skipIdleChips && m_chipActivity.data[chip] == ChipActive && !isChipKeyedOn(chip))
+        m_chipActivity.data[chip] = ChipReleased;
 }
 
 
@@ -523,7 +781,8 @@ void OPL3::noteOff(size_t c)
     else if(m_currentChipType == OPLChipBase::CHIPTYPE_OPL2 && cc >= NUM_OF_OPL2_CHANNELS)
         return;
 
-    writeRegI(chip, 0xB0 + g_channelsMap[cc], m_keyBlockFNumCache[c] & 0xDF);
+    m_keyBlockFNumCache[c] &= 0xDF;
+    writeRegI(chip, 0xB0 + g_channelsMap[cc], m_keyBlockFNumCache[c]);
 }
 
 void OPL3::noteOn(size_t c1, size_t c2, double tone)
@@ -717,6 +976,10 @@ void OPL3::setPatch(size_t c, const OplTimbre *instrument)
     uint16_t o1, o2, fbconn_reg = 0x00;
     static const uint8_t data[4] = {0x20, 0x60, 0x80, 0xE0};
     uint8_t fbconn = 0;
+    // Registers of the patch: two 0x40, four pairs of operator registers and 0xC0
+    uint16_t regs[11];
+    uint8_t values[11];
+    size_t count = 0;
 
     if(m_insCache[c] == instrument)
         return; // Already up to date!
@@ -727,6 +990,7 @@ void OPL3::setPatch(size_t c, const OplTimbre *instrument)
     cmf_offset = ((m_musicMode == MODE_CMF) && (cc >= OPL3_CHANNELS_RHYTHM_BASE)) ? 10 : 0;
     o1 = g_operatorsMap[cc * 2 + 0 + cmf_offset];
     o2 = g_operatorsMap[cc * 2 + 1 + cmf_offset];
+    // Operator registers are packed by the timbre at the bank load, one byte per register
     x = instrument->modulator_E862, y = instrument->carrier_E862;
     fbconn_reg = 0x00;
 
@@ -734,19 +998,31 @@ void OPL3::setPatch(size_t c, const OplTimbre *instrument)
     {
         // Also write dummy volume value
         if(o1 != 0xFFF)
-            writeRegI(chip, 0x40 + o1, instrument->modulator_40);
+        {
+            regs[count] = 0x40 + o1;
+            values[count++] = instrument->modulator_40;
+        }
 
         if(o2 != 0xFFF)
-            writeRegI(chip, 0x40 + o2, instrument->carrier_40);
+        {
+            regs[count] = 0x40 + o2;
+            values[count++] = instrument->carrier_40;
+        }
     }
 
     for(size_t a = 0; a < 4; ++a, x >>= 8, y >>= 8)
     {
         if(o1 != 0xFFF)
-            writeRegI(chip, data[a] + o1, x & 0xFF);
+        {
+            regs[count] = data[a] + o1;
+            values[count++] = x & 0xFF;
+        }
 
         if(o2 != 0xFFF)
-            writeRegI(chip, data[a] + o2, y & 0xFF);
+        {
+            regs[count] = data[a] + o2;
+            values[count++] = y & 0xFF;
+        }
     }
 
     if(g_channelsMapFBConn[cc] != 0xFFF)
@@ -763,7 +1039,12 @@ void OPL3::setPatch(size_t c, const OplTimbre *instrument)
     }
 
     if(fbconn_reg != 0x00)
-        writeRegI(chip, fbconn_reg, fbconn);
+    {
+        regs[count] = fbconn_reg;
+        values[count++] = fbconn;
+    }
+
+    writeRegs(chip, regs, values, count);
 }
 
 void OPL3::setPan(size_t c, uint8_t value)
@@ -1041,14 +1322,28 @@ ADLMIDI_VolumeModels OPL3::getVolumeScaleModel()
 
 void OPL3::clearChips()
 {
+    flushWrites();
+    clearTimedWrites();
+
     for(size_t i = 0; i < m_chips.size; i++)
         m_chips[i].reset(NULL);
 
     m_chips.clear();
+
+    // Chips of groups refer to their groups, so groups go last
+    for(size_t i = 0; i < m_chipGroups.size; i++)
+        m_chipGroups[i].reset(NULL);
+
+    m_chipGroups.clear();
 }
 
 void OPL3::reset(int emulator, unsigned long PCM_RATE, void *audioTickHandler)
 {
+    flushWrites(); // Writes to the old state of chips
+    clearTimedWrites();
+    m_writeClock = 0;
+    m_writeTime = 0;
+
     bool rebuild_needed = m_curState.cmp(emulator, m_numChips);
 
     if(rebuild_needed)
@@ -1066,7 +1361,10 @@ void OPL3::reset(int emulator, unsigned long PCM_RATE, void *audioTickHandler)
         m_insCacheModified.clear();
         m_keyBlockFNumCache.clear();
         m_regBD.clear();
+        m_chipActivity.clear();
         m_regC0.clear();
+        m_regShadow.clear();
+        m_regShadowKnown.clear();
         m_channelCategory.clear();
         m_chips.resize(m_numChips);
     }
@@ -1080,6 +1378,7 @@ void OPL3::reset(int emulator, unsigned long PCM_RATE, void *audioTickHandler)
         m_channelCategory.fill(0);
         m_keyBlockFNumCache.fill(0);
         m_regBD.fill(0);
+        m_chipActivity.fill(ChipActive);
         m_regC0.fill(OPL_PANNING_BOTH);
     }
 
@@ -1097,7 +1396,23 @@ void OPL3::reset(int emulator, unsigned long PCM_RATE, void *audioTickHandler)
         m_channelCategory.resize_fill(m_numChannels, 0);
         m_keyBlockFNumCache.resize_fill(m_numChannels, 0);
         m_regBD.resize_fill(m_numChips, 0);
+        m_chipActivity.resize_fill(m_numChips, ChipActive);
         m_regC0.resize_fill(m_numChips * m_numChannels, OPL_PANNING_BOTH);
+        m_regShadow.resize_fill(m_numChips * RegShadowSize, 0);
+        m_regShadowKnown.resize_fill(m_numChips * (RegShadowSize / 32), 0);
+
+#if !defined(ENABLE_HW_OPL_DOS) && !defined(ADLMIDI_DISABLE_NUKED_EMULATOR)
+        // Several chips of the vectorized Nuked get emulated in lock-step by groups
+        if(emulator == ADLMIDI_EMU_NUKED_SIMD && m_numChips > 1)
+        {
+            OPLChipGroup *group = new NukedOPL3SIMDGroup;
+            const size_t groupChips = group->chips();
+            m_chipGroups.resize((m_numChips + groupChips - 1) / groupChips);
+            m_chipGroups[0].reset(group);
+            for(size_t i = 1; i < m_chipGroups.size; ++i)
+                m_chipGroups[i].reset(new NukedOPL3SIMDGroup);
+        }
+#endif
     }
 
     if(!rebuild_needed)
@@ -1119,6 +1434,7 @@ void OPL3::reset(int emulator, unsigned long PCM_RATE, void *audioTickHandler)
         {
             OPL_SerialPort *serial = new OPL_SerialPort;
             serial->connectPort(m_serialName, m_serialBaud, m_serialProtocol);
+            serial->setThrottle(m_serialThrottle);
             m_chips[i].reset(serial);
             initChip(i);
             break; // Only one REAL chip!
@@ -1148,6 +1464,15 @@ void OPL3::reset(int emulator, unsigned long PCM_RATE, void *audioTickHandler)
         case ADLMIDI_EMU_NUKED_CQM: /* Nuked CQM */
             chip = new NukedCQM;
             break;
+        case ADLMIDI_EMU_NUKED_SIMD: /* Nuked OPL3 with vectorized slots */
+            if(!m_chipGroups.empty())
+            {
+                const size_t groupChips = m_chipGroups[0]->chips();
+                chip = m_chipGroups[i / groupChips]->createChip(i % groupChips);
+            }
+            else
+                chip = new NukedOPL3SIMD;
+            break;
 #endif
 #ifndef ADLMIDI_DISABLE_DOSBOX_EMULATOR
         case ADLMIDI_EMU_DOSBOX:
@@ -1215,6 +1540,29 @@ void OPL3::reset(int emulator, unsigned long PCM_RATE, void *audioTickHandler)
         initChip(i);
     }
 
+    // Chips running at the output rate don't need the mix bus resampling
+    m_busRateRatio = 0;
+    m_busOutputRate = (uint32_t)PCM_RATE;
+    if(!m_chips.empty() && m_chips[0].get())
+    {
+        const uint32_t nativeRate = m_chips[0]->effectiveRate();
+        if(PCM_RATE != nativeRate)
+            m_busRateRatio = (int32_t)(((uint64_t)PCM_RATE << 10) / nativeRate);
+
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+        if(!m_busHQResampler.get())
+        {
+            m_busHQResampler.reset(new VResampler);
+            m_busHQCounter.reset(new OPLResamplerCounter);
+        }
+        // The ratio is computed exactly as every chip computes its own one
+        const double ratio = PCM_RATE * (1.0 / nativeRate);
+        m_busHQResampler->setup(ratio, 2, 48);
+        m_busHQCounter->setup(ratio, 48);
+#endif
+    }
+    setResamplerQuality(m_resamplerQuality);
+
     updateChannelCategories();
     silenceAll();
 }
@@ -1274,6 +1622,9 @@ void OPL3::initChip(size_t chip)
         }
     }
 
+    // The chip might be reset, its registers are unknown now
+    clearRegShadow(chip);
+
     /* Clean-up channels from any playing junk sounds */
     for(size_t a = 0; a < m_perChipChannels; ++a)
     {
@@ -1295,6 +1646,507 @@ void OPL3::initChip(size_t chip)
     }
 }
 
+void OPL3::generate32(int32_t *output, size_t frames)
+{
+    // Split the block at frames of timed writes
+    while(!m_timedWrites.empty())
+    {
+        const uint64_t frame = m_timedWrites.front().frame;
+
+        if(frame > m_writeClock)
+        {
+            if(frame - m_writeClock >= frames)
+                break;
+
+            const size_t count = static_cast<size_t>(frame - m_writeClock);
+            generateBlock32(output, count);
+            output += 2 * count;
+            frames -= count;
+            m_writeClock = frame;
+        }
+
+        applyTimedWrites();
+    }
+
+    generateBlock32(output, frames);
+    m_writeClock += frames;
+}
+
+void OPL3::generateBlock32(int32_t *output, size_t frames)
+{
+    const size_t numChips = m_numChips;
+
+    if(m_busResampler.get() && m_busRateRatio != 0)
+    {
+        /* Mix all chips at native rate, and pass the mix through the polyphase resampler */
+        OPLResampler &rsm = *m_busResampler;
+
+        while(frames > 0)
+        {
+            size_t needed = 0;
+            size_t count = rsm.countFrames(frames, MixBusBlockFrames, &needed);
+            // Output rates too low for one block are rejected by setResamplerQuality()
+            assert(count > 0);
+
+            int32_t *native = m_busBuffer;
+            std::memset(native, 0, 2 * needed * sizeof(int32_t));
+            mixChips(native, needed, true);
+
+            rsm.process(native, output, count);
+            output += 2 * count;
+            frames -= count;
+        }
+        return;
+    }
+
+    if(numChips == 1)
+    {
+        if(m_chipActivity.data[0] == ChipActive)
+        {
+            chipImpl(m_chips[0]).generate32(output, frames);
+            return;
+        }
+
+        std::memset(output, 0, 2 * frames * sizeof(int32_t));
+        mixChips(output, frames, false);
+        return;
+    }
+
+    std::memset(output, 0, 2 * frames * sizeof(int32_t));
+
+    if(m_busRateRatio == 0)
+    {
+        /* Chips already run at the output rate, groups of chips render it at native rate */
+        mixChips(output, frames, !m_chipGroups.empty());
+        return;
+    }
+
+    if(!m_resampleMixBus && m_chipGroups.empty())
+    {
+        /* Generate data from every chip and mix result */
+        mixChips(output, frames, false);
+        return;
+    }
+
+    /* Mix all chips at native rate, and resample the mix once: groups of chips always need it */
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+    mixBusHQ(output, frames);
+#else
+    const int32_t rateratio = m_busRateRatio;
+    const int32_t step = 1 << 10; // Must match the OPLChipBaseT::rsm_frac
+
+    while(frames > 0)
+    {
+        // Find how many output frames can be made from one block of native frames
+        int32_t samplecnt = m_busSampleCnt;
+        size_t needed = 0;
+        size_t count = 0;
+        while(count < frames)
+        {
+            size_t steps = (size_t)(samplecnt / rateratio);
+            if(needed + steps > (size_t)MixBusBlockFrames)
+                break;
+            needed += steps;
+            samplecnt -= (int32_t)steps * rateratio;
+            samplecnt += step;
+            ++count;
+        }
+
+        if(count == 0)
+        {
+            // Extremely low output rate, a single frame doesn't fit the block
+            mixBusLowRateFrame(output);
+            output += 2;
+            --frames;
+            continue;
+        }
+
+        int32_t *native = m_busBuffer;
+        std::memset(native, 0, 2 * needed * sizeof(int32_t));
+        mixChips(native, needed, true);
+
+        samplecnt = m_busSampleCnt;
+        for(size_t i = 0; i < count; ++i)
+        {
+            while(samplecnt >= rateratio)
+            {
+                m_busOldSamples[0] = m_busSamples[0];
+                m_busOldSamples[1] = m_busSamples[1];
+                m_busSamples[0] = native[0];
+                m_busSamples[1] = native[1];
+                native += 2;
+                samplecnt -= rateratio;
+            }
+            output[0] = (int32_t)(((int64_t)m_busOldSamples[0] * (rateratio - samplecnt)
+                                   + (int64_t)m_busSamples[0] * samplecnt) / rateratio);
+            output[1] = (int32_t)(((int64_t)m_busOldSamples[1] * (rateratio - samplecnt)
+                                   + (int64_t)m_busSamples[1] * samplecnt) / rateratio);
+            samplecnt += step;
+            output += 2;
+        }
+        m_busSampleCnt = samplecnt;
+        frames -= count;
+    }
+#endif
+}
+
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+void OPL3::mixBusHQ(int32_t *output, size_t frames)
+{
+    VResampler &rsm = *m_busHQResampler;
+    OPLResamplerCounter &counter = *m_busHQCounter;
+    int32_t *native = m_busBuffer;
+    float f_in[2 * MixBusBlockFrames];
+    float f_out[2 * MixBusBlockFrames];
+
+    while(frames > 0)
+    {
+        // Find how many output frames can be made from one block of native frames,
+        // no frame may be rendered ahead of register writes of the next output frames
+        size_t needed = 0;
+        size_t count = 0;
+        while(count < frames && count < (size_t)MixBusBlockFrames)
+        {
+            const size_t next = counter.next();
+            if(needed + next > (size_t)MixBusBlockFrames)
+                break;
+            needed += next;
+            counter.take();
+            ++count;
+        }
+
+        if(count == 0)
+        {
+            // Extremely low output rate, a single frame doesn't fit the block
+            size_t left = counter.next();
+            counter.take();
+            rsm.out_count = 1;
+            rsm.out_data = f_out;
+            while(left > 0)
+            {
+                const size_t chunk = (left < (size_t)MixBusBlockFrames) ? left : (size_t)MixBusBlockFrames;
+                std::memset(native, 0, 2 * chunk * sizeof(int32_t));
+                mixChips(native, chunk, true);
+                for(size_t i = 0; i < 2 * chunk; ++i)
+                    f_in[i] = (float)native[i];
+                rsm.inp_count = (unsigned int)chunk;
+                rsm.inp_data = f_in;
+                rsm.process();
+                left -= chunk;
+            }
+            count = 1;
+        }
+        else
+        {
+            std::memset(native, 0, 2 * needed * sizeof(int32_t));
+            mixChips(native, needed, true);
+            for(size_t i = 0; i < 2 * needed; ++i)
+                f_in[i] = (float)native[i];
+            rsm.inp_count = (unsigned int)needed;
+            rsm.inp_data = f_in;
+            rsm.out_count = (unsigned int)count;
+            rsm.out_data = f_out;
+            rsm.process();
+        }
+
+        // The counter predicts the consumption exactly
+        assert(rsm.inp_count == 0 && rsm.out_count == 0);
+
+        for(size_t i = 0; i < 2 * count; ++i)
+            output[i] = static_cast<int32_t>(lround(f_out[i]));
+        output += 2 * count;
+        frames -= count;
+    }
+}
+#endif
+
+void OPL3::mixBusLowRateFrame(int32_t *output)
+{
+    const int32_t rateratio = m_busRateRatio;
+    int32_t samplecnt = m_busSampleCnt;
+
+    // Only two latest native frames are needed to interpolate the output frame
+    while(samplecnt >= rateratio)
+    {
+        size_t count = (size_t)(samplecnt / rateratio);
+        if(count > (size_t)MixBusBlockFrames)
+            count = (size_t)MixBusBlockFrames;
+
+        int32_t *native = m_busBuffer;
+        std::memset(native, 0, 2 * count * sizeof(int32_t));
+        mixChips(native, count, true);
+
+        m_busOldSamples[0] = (count > 1) ? native[2 * count - 4] : m_busSamples[0];
+        m_busOldSamples[1] = (count > 1) ? native[2 * count - 3] : m_busSamples[1];
+        m_busSamples[0] = native[2 * count - 2];
+        m_busSamples[1] = native[2 * count - 1];
+        samplecnt -= (int32_t)count * rateratio;
+    }
+
+    output[0] = (int32_t)(((int64_t)m_busOldSamples[0] * (rateratio - samplecnt)
+                           + (int64_t)m_busSamples[0] * samplecnt) / rateratio);
+    output[1] = (int32_t)(((int64_t)m_busOldSamples[1] * (rateratio - samplecnt)
+                           + (int64_t)m_busSamples[1] * samplecnt) / rateratio);
+    m_busSampleCnt = samplecnt + (1 << 10); // Must match the OPLChipBaseT::rsm_frac
+}
+
+static bool isBufferSilent(const int32_t *buffer, size_t samples)
+{
+    for(size_t i = 0; i < samples; ++i)
+    {
+        if(buffer[i] != 0)
+            return false;
+    }
+
+    return true;
+}
+
+void OPL3::skipChip(size_t chip, size_t frames, bool native)
+{
+    // Keep timers of the chip running, so it will resume in the same state as it would be emulated
+    if(native)
+        chipImpl(m_chips[chip]).nativeSkip(frames);
+    else
+        chipImpl(m_chips[chip]).resampledSkip(frames);
+}
+
+void OPL3::mixChips(int32_t *output, size_t frames, bool native)
+{
+    const size_t numChips = m_numChips;
+    const size_t scratchSize = 2 * (size_t)MixBusBlockFrames;
+    const bool threaded = m_renderThreads.get() && m_renderThreads->threads() > 1;
+    // Groups render their chips at the native rate only
+    const bool grouped = native && !m_chipGroups.empty();
+
+    if(!grouped && (!threaded || numChips <= 1))
+    {
+        for(size_t card = 0; card < numChips; ++card)
+        {
+            switch(m_chipActivity.data[card])
+            {
+            case ChipSleeping:
+                skipChip(card, frames, native);
+                break;
+            case ChipReleased:
+                mixReleasedChip(card, output, frames, native);
+                break;
+            default:
+                if(native)
+                    chipImpl(m_chips[card]).nativeGenerateAndMix32(output, frames);
+                else
+                    chipImpl(m_chips[card]).generateAndMix32(output, frames);
+                break;
+            }
+        }
+        return;
+    }
+
+    if(m_renderScratch.size < numChips * scratchSize)
+        m_renderScratch.resize(numChips * scratchSize);
+
+    while(frames > 0)
+    {
+        size_t count = (frames < (size_t)MixBusBlockFrames) ? frames : (size_t)MixBusBlockFrames;
+
+        m_renderJobFrames = count;
+        m_renderJobNative = native;
+        if(!grouped)
+            m_renderThreads->run(&OPL3::renderChipJob, this, numChips);
+        else if(threaded && m_chipGroups.size > 1)
+            m_renderThreads->run(&OPL3::renderGroupJob, this, m_chipGroups.size);
+        else
+        {
+            for(size_t group = 0; group < m_chipGroups.size; ++group)
+                renderGroupJob(this, group);
+        }
+
+        // Mix in the fixed order of chips to keep the result identical to the serial rendering
+        for(size_t card = 0; card < numChips; ++card)
+        {
+            uint8_t &activity = m_chipActivity.data[card];
+            const int32_t *src = m_renderScratch.data + card * scratchSize;
+
+            if(activity == ChipSleeping)
+            {
+                skipChip(card, count, native);
+                continue;
+            }
+
+            if(activity == ChipReleased && updateReleasedChip(card, src, count, native))
+                continue; // Silent output, nothing to mix
+
+            for(size_t i = 0; i < 2 * count; ++i)
+                output[i] += src[i];
+        }
+
+        output += 2 * count;
+        frames -= count;
+    }
+}
+
+void OPL3::mixReleasedChip(size_t chip, int32_t *output, size_t frames, bool native)
+{
+    const size_t scratchSize = 2 * (size_t)MixBusBlockFrames;
+    OPLChipImpl &c = chipImpl(m_chips[chip]);
+
+    if(m_renderScratch.size < scratchSize)
+        m_renderScratch.resize(scratchSize);
+
+    while(frames > 0)
+    {
+        size_t count = (frames < (size_t)MixBusBlockFrames) ? frames : (size_t)MixBusBlockFrames;
+        int32_t *buf = m_renderScratch.data;
+
+        if(m_chipActivity.data[chip] == ChipSleeping)
+        {
+            skipChip(chip, count, native);
+        }
+        else
+        {
+            std::memset(buf, 0, 2 * count * sizeof(int32_t));
+            if(native)
+                c.nativeGenerateAndMix32(buf, count);
+            else
+                c.generateAndMix32(buf, count);
+
+            if(!updateReleasedChip(chip, buf, count, native))
+            {
+                for(size_t i = 0; i < 2 * count; ++i)
+                    output[i] += buf[i];
+            }
+        }
+
+        output += 2 * count;
+        frames -= count;
+    }
+}
+
+bool OPL3::updateReleasedChip(size_t chip, const int32_t *buffer, size_t frames, bool native)
+{
+    if(!isBufferSilent(buffer, 2 * frames))
+        return false;
+
+    // Sleep only when the emulator proves the silence: skipping keeps the output bit-identical
+    if(chipImpl(m_chips[chip]).outputFinished(native))
+        m_chipActivity.data[chip] = ChipSleeping;
+
+    return true;
+}
+
+void OPL3::renderChipJob(void *self, size_t chip)
+{
+    OPL3 *synth = static_cast<OPL3 *>(self);
+    const size_t frames = synth->m_renderJobFrames;
+    int32_t *out = synth->m_renderScratch.data + chip * 2 * (size_t)MixBusBlockFrames;
+
+    if(synth->m_chipActivity.data[chip] == ChipSleeping)
+        return;
+
+    std::memset(out, 0, 2 * frames * sizeof(int32_t));
+    if(synth->m_renderJobNative)
+        chipImpl(synth->m_chips[chip]).nativeGenerateAndMix32(out, frames);
+    else
+        chipImpl(synth->m_chips[chip]).generateAndMix32(out, frames);
+}
+
+void OPL3::renderGroupJob(void *self, size_t group)
+{
+    OPL3 *synth = static_cast<OPL3 *>(self);
+    OPLChipGroup &g = *synth->m_chipGroups[group];
+    const size_t scratchSize = 2 * (size_t)MixBusBlockFrames;
+    const size_t first = group * g.chips();
+    uint32_t mask = 0;
+
+    // Sleeping chips stay out of the lock-step, their scratch buffers are not mixed
+    for(size_t c = 0; c < g.chips() && first + c < synth->m_numChips; ++c)
+    {
+        if(synth->m_chipActivity.data[first + c] != ChipSleeping)
+            mask |= 1u << c;
+    }
+
+    if(mask == 0)
+        return;
+
+    g.nativeGenerateChips(synth->m_renderScratch.data + first * scratchSize, scratchSize, mask, synth->m_renderJobFrames);
+}
+
+void OPL3::setSkipIdleChips(bool skip)
+{
+    m_skipIdleChips = skip;
+    if(skip)
+        return;
+
+    m_chipActivity.fill(ChipActive);
+}
+
+bool OPL3::setRenderThreads(unsigned threads)
+{
+    if(threads <= 1)
+    {
+        m_renderThreads.reset(NULL);
+        m_renderScratch.clear();
+        return true;
+    }
+
+    if(!m_renderThreads.get())
+        m_renderThreads.reset(new ChipRenderThreads);
+
+    if(!m_renderThreads->setThreads(threads))
+    {
+        m_renderThreads.reset(NULL);
+        return false;
+    }
+
+    return true;
+}
+
+unsigned OPL3::renderThreads() const
+{
+    return m_renderThreads.get() ? m_renderThreads->threads() : 1;
+}
+
+void OPL3::resetMixBus()
+{
+    m_busOldSamples[0] = m_busOldSamples[1] = 0;
+    m_busSamples[0] = m_busSamples[1] = 0;
+    m_busSampleCnt = 0;
+
+    if(m_busResampler.get())
+        m_busResampler->reset();
+
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+    if(m_busHQResampler.get())
+    {
+        m_busHQResampler->reset();
+        m_busHQCounter->reset();
+    }
+#endif
+}
+
+void OPL3::setResamplerQuality(int quality)
+{
+    m_resamplerQuality = quality;
+
+    // The polyphase filter makes every output frame from one block of native frames,
+    // the linear interpolation handles lower output rates
+    if(quality == ADLMIDI_Resampler_Linear || m_busRateRatio == 0 ||
+       (uint64_t)m_busOutputRate * (MixBusBlockFrames - 1) < (uint64_t)m_chips[0]->effectiveRate())
+    {
+        m_busResampler.reset(NULL);
+        resetMixBus();
+        return;
+    }
+
+    if(!m_busResampler.get())
+        m_busResampler.reset(new OPLResampler);
+
+    m_busResampler->setup(m_chips[0]->effectiveRate(), m_busOutputRate,
+                          quality == ADLMIDI_Resampler_High ?
+                          OPLResampler::QUALITY_HIGH :
+                          OPLResampler::QUALITY_MEDIUM);
+    resetMixBus();
+}
+
 #ifdef ADLMIDI_ENABLE_HW_SERIAL
 void OPL3::resetSerial(const std::string &serialName, unsigned int baud, unsigned int protocol)
 {
@@ -1306,4 +2158,18 @@ void OPL3::resetSerial(const std::string &serialName, unsigned int baud, unsigne
     m_softPanning = false; // Soft-panning doesn't work on hardware
     reset(-1, 0, NULL);
 }
+
+void OPL3::setSerialThrottle(bool throttle)
+{
+    m_serialThrottle = throttle;
+    if(m_serial && !m_chips.empty() && m_chips[0].get())
+        static_cast<OPL_SerialPort *>(m_chips[0].get())->setThrottle(throttle);
+}
+
+void OPL3::flushSerial(double seconds)
+{
+    flushWrites();
+    if(m_serial && !m_chips.empty() && m_chips[0].get())
+        static_cast<OPL_SerialPort *>(m_chips[0].get())->flushWrites(seconds);
+}
 #endif
@@ -66,6 +66,8 @@ public:
     uint32_t m_numChannels;
     //! Just a padding. Reserved.
     char _padding[4];
+    //! Emulators advancing several chips in lock-step, empty when every chip is emulated alone
+    adl_array<AdlMIDI_SPtr<OPLChipGroup >, true> m_chipGroups;
     //! Running chip emulators
     adl_array<AdlMIDI_SPtr<OPLChipBase >, true> m_chips;
 
@@ -81,12 +83,69 @@ private:
     adl_array<uint32_t>   m_regBD;
     //! Cached C0 register value (primarily for the panning state)
     adl_array<uint8_t>    m_regC0;
+    //! Size of the register image of one chip
+    enum { RegShadowSize = 0x200 };
+    //! Last values written to registers of every chip, writes of same values are dropped
+    adl_array<uint8_t>    m_regShadow;
+    //! Bit masks of registers whose values in the register image are known
+    adl_array<uint32_t>   m_regShadowKnown;
+
+    //! Capacity of the queue of register writes
+    enum { WriteQueueSize = 64 };
+    //! Register writes of the current batch waiting to be passed to the chip
+    uint16_t m_writeQueueAddr[WriteQueueSize];
+    uint8_t  m_writeQueueData[WriteQueueSize];
+    //! Count of queued register writes
+    size_t   m_writeQueueCount;
+    //! Chip of queued register writes
+    size_t   m_writeQueueChip;
+    //! Depth of nested write batches, writes are queued while it's above zero
+    unsigned m_writeBatchDepth;
+
+    /**
+     * @brief Register write applied at the given output frame
+     */
+    struct TimedWrite
+    {
+        //! Output frame (counted by m_writeClock) to apply the write at
+        uint64_t frame;
+        //! Index of chip
+        uint32_t chip;
+        //! Register address
+        uint16_t address;
+        //! Value to write
+        uint8_t  value;
+        //! Is this a write to the soft panning control
+        bool     pan;
+    };
+    //! Timed register writes of all chips in the order of their frames
+    adl_fifo<TimedWrite> m_timedWrites;
+    //! Count of output frames generated since the reset
+    uint64_t m_writeClock;
+    //! Offset of following register writes from the start of the next generated block, in output frames
+    size_t   m_writeTime;
+
+    /**
+     * @brief Activity state of the chip
+     */
+    enum ChipActivity
+    {
+        //! Chip is running, any register write sets this state
+        ChipActive = 0,
+        //! All notes were released, chip gets emulated until the emulator proves its output stays silent
+        ChipReleased,
+        //! Chip is proven to produce silence, its emulation gets skipped
+        ChipSleeping
+    };
+    //! Activity state of every chip (#ChipActivity)
+    adl_array<uint8_t>    m_chipActivity;
 
 #ifdef ADLMIDI_ENABLE_HW_SERIAL
     bool        m_serial;
     std::string m_serialName;
     unsigned    m_serialBaud;
     unsigned    m_serialProtocol;
+    bool        m_serialThrottle;
 #endif
     //! Does loaded emulator supports soft panning?
     bool m_softPanningSup;
@@ -95,6 +154,37 @@ private:
     //! Number channels per chip
     size_t m_perChipChannels;
 
+    //! Size of the native-rate mixing buffer of the mix bus resampler (in frames)
+    enum { MixBusBlockFrames = 512 };
+    //! Mix bus resampler: previous and current frames of the native-rate mix
+    int32_t m_busOldSamples[2];
+    int32_t m_busSamples[2];
+    //! Mix bus resampler: fractional position counter
+    int32_t m_busSampleCnt;
+    //! Mix bus resampler: ratio between output and native rates, 0 when chips already run at output rate
+    int32_t m_busRateRatio;
+    //! Native-rate mix of all chips
+    int32_t m_busBuffer[2 * MixBusBlockFrames];
+    //! Output rate of the mix bus
+    uint32_t m_busOutputRate;
+    //! Polyphase resampler of the mix bus, used at medium and high qualities
+    AdlMIDI_UPtr<OPLResampler> m_busResampler;
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+    //! HQ resampler of the mix bus, used instead of the linear interpolation
+    AdlMIDI_UPtr<VResampler> m_busHQResampler;
+    //! Native frames taken by the HQ resampler of the mix bus before every output frame
+    AdlMIDI_UPtr<OPLResamplerCounter> m_busHQCounter;
+#endif
+
+    //! Worker threads to render chips concurrently, NULL when chips are rendered on the calling thread
+    AdlMIDI_UPtr<ChipRenderThreads> m_renderThreads;
+    //! Per-chip output buffers of worker threads, mixed in the order of chips
+    adl_array<int32_t> m_renderScratch;
+    //! Count of frames to render by the current job of worker threads
+    size_t m_renderJobFrames;
+    //! Render chips at native rate by the current job of worker threads
+    bool m_renderJobNative;
+
     /*!
      * \brief Current state of the synth (if values matched to setup, chips and arrays won't be fully re-created)
      */
@@ -141,6 +231,28 @@ private:
     } m_curState;
 
 public:
+    /**
+     * @brief Collects register writes done during its lifetime, such as writes of one MIDI event,
+     * and passes them to chips by bursts once the outermost batch ends
+     */
+    class WriteBatch
+    {
+        OPL3 &m_synth;
+        WriteBatch(const WriteBatch &);
+        WriteBatch &operator=(const WriteBatch &);
+    public:
+        explicit WriteBatch(OPL3 &synth) : m_synth(synth)
+        {
+            ++m_synth.m_writeBatchDepth;
+        }
+
+        ~WriteBatch()
+        {
+            if(--m_synth.m_writeBatchDepth == 0)
+                m_synth.flushWrites();
+        }
+    };
+
     /**
      * @brief MIDI bank entry
      */
@@ -176,11 +288,17 @@ public:
     bool m_runAtPcmRate;
     //! Enable soft panning
     bool m_softPanning;
+    //! Mix output of all chips at native rate and resample the mix once instead of resampling every chip
+    bool m_resampleMixBus;
+    //! Quality of the output resampling (#ADLMIDI_ResamplerQuality)
+    int m_resamplerQuality;
+    //! Skip the emulation of chips that produce silence
+    bool m_skipIdleChips;
     //! Master volume, controlled via SysEx (0...127)
     uint8_t m_masterVolume;
 
     //! Just a padding. Reserved.
-    char _padding2[3];
+    char _padding2[1];
 
     /**
      * @brief Music playing mode
@@ -338,6 +456,15 @@ public:
      */
     void writeRegI(size_t chip, uint32_t address, uint32_t value);
 
+    /**
+     * @brief Write the burst of values to OPL3 chip registers in the given order
+     * @param chip Index of emulated chip. In hardware OPL3 builds, this parameter is ignored
+     * @param addresses Register addresses to write
+     * @param values Values to write
+     * @param count Count of registers to write
+     */
+    void writeRegs(size_t chip, const uint16_t *addresses, const uint8_t *values, size_t count);
+
     /**
      * @brief Write to soft panning control of OPL3 chip emulator
      * @param chip Index of emulated chip.
@@ -346,6 +473,75 @@ public:
      */
     void writePan(size_t chip, uint32_t address, uint32_t value);
 
+    /**
+     * @brief Pass queued register writes to the chip
+     */
+    void flushWrites();
+
+    /**
+     * @brief Set the time of following register writes
+     *
+     * Writes with non-zero offset are applied by generate32() at the exact frame of
+     * the generated block, writes are never applied before writes done earlier.
+     * In hardware OPL3 builds and with hardware chips, writes are always immediate.
+     *
+     * @param frames Offset from the start of the next generated block, in output frames, 0 to write immediately
+     */
+    void setWriteTime(size_t frames);
+
+    /**
+     * @brief Current time of register writes
+     * @return Offset from the start of the next generated block, in output frames
+     */
+    size_t writeTime() const
+    {
+        return m_writeTime;
+    }
+
+    /**
+     * @brief Record the write into the register image of the chip
+     * @param chip Index of emulated chip
+     * @param address Register address to write
+     * @param value Value to write
+     * @return true if the write changes the chip state and must be passed to the chip
+     */
+    bool shadowReg(size_t chip, uint16_t address, uint8_t value);
+
+    /**
+     * @brief Forget register values of the chip, so next writes will be passed to it
+     * @param chip Index of emulated chip
+     */
+    void clearRegShadow(size_t chip);
+
+    /**
+     * @brief Check are any notes keyed on at the chip
+     * @param chip Index of emulated chip
+     * @return true if any of chip channels is keyed on
+     */
+    bool isChipKeyedOn(size_t chip) const;
+
+    /**
+     * @brief Is chip running without waiting for the silence?
+     * @param chip Index of emulated chip
+     * @return true if chip is in the active state
+     */
+    bool isChipActive(size_t chip) const
+    {
+        return m_chipActivity.data[chip] == ChipActive;
+    }
+
+    /**
+     * @brief Mark that release of all notes at the chip is done, so it may be skipped once it will produce silence
+     * @param chip Index of emulated chip
+     */
+    void setChipReleased(size_t chip);
+
+    /**
+     * @brief Enable or disable skipping of the emulation of silent chips
+     * @param skip Skip silent chips
+     */
+    void setSkipIdleChips(bool skip);
+
     /**
      * @brief Off the note in specified chip channel
      * @param c Channel of chip (Emulated chip choosing by next formula: [c = ch + (chipId * 23)])
@@ -437,6 +633,138 @@ public:
 
     void initChip(size_t chip);
 
+    /**
+     * @brief Generate output of all running chips and mix it together
+     * @param output Output buffer of interleaved stereo frames (will be overwritten)
+     * @param frames Count of frames to generate
+     */
+    void generate32(int32_t *output, size_t frames);
+
+    /**
+     * @brief Reset the state of the mix bus resampler
+     */
+    void resetMixBus();
+
+    /**
+     * @brief Set the count of threads used to render chips
+     * @param threads Total count of threads including the calling thread, 1 to render chips serially
+     * @return true on success, false if threads can't be started
+     */
+    bool setRenderThreads(unsigned threads);
+
+    /**
+     * @brief Count of threads used to render chips
+     * @return Total count of threads including the calling thread
+     */
+    unsigned renderThreads() const;
+
+private:
+    /**
+     * @brief Pass the register write to the chip, or into the queue of the current write batch
+     * @param chip Index of emulated chip
+     * @param address Register address to write
+     * @param value Value to write
+     */
+    void queueWrite(size_t chip, uint16_t address, uint8_t value);
+
+    /**
+     * @brief Put the register write into the queue of timed writes at the current write time
+     * @param chip Index of emulated chip
+     * @param address Register address to write
+     * @param value Value to write
+     * @param pan Write to the soft panning control
+     */
+    void queueTimedWrite(size_t chip, uint16_t address, uint8_t value, bool pan);
+
+    /**
+     * @brief Apply timed writes whose frames are already reached by the write clock
+     */
+    void applyTimedWrites();
+
+    /**
+     * @brief Drop all timed writes which are not applied yet
+     */
+    void clearTimedWrites();
+
+    /**
+     * @brief Generate output of all running chips and mix it together, without applying timed writes
+     * @param output Output buffer of interleaved stereo frames (will be overwritten)
+     * @param frames Count of frames to generate
+     */
+    void generateBlock32(int32_t *output, size_t frames);
+
+    /**
+     * @brief Mix the single output frame of the linear mix bus, when it takes more native frames than one block
+     * @param output Output buffer of the interleaved stereo frame
+     */
+    void mixBusLowRateFrame(int32_t *output);
+
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+    /**
+     * @brief Mix all chips at native rate and pass the mix through the HQ resampler of the mix bus
+     * @param output Output buffer of interleaved stereo frames
+     * @param frames Count of frames to generate
+     */
+    void mixBusHQ(int32_t *output, size_t frames);
+#endif
+
+    /**
+     * @brief Generate output of every chip and add it into the output buffer
+     * @param output Output buffer of interleaved stereo frames
+     * @param frames Count of frames to generate
+     * @param native Generate chips at their native rate without resampling
+     */
+    void mixChips(int32_t *output, size_t frames, bool native);
+
+    /**
+     * @brief Skip frames of the sleeping chip instead of generating them
+     * @param chip Index of chip
+     * @param frames Count of frames to skip
+     * @param native Frames are at the native rate of the chip
+     */
+    void skipChip(size_t chip, size_t frames, bool native);
+
+    /**
+     * @brief Generate the chip which has released all notes, and put it asleep once it produces silence
+     * @param chip Index of chip
+     * @param output Output buffer of interleaved stereo frames
+     * @param frames Count of frames to generate
+     * @param native Generate the chip at its native rate without resampling
+     */
+    void mixReleasedChip(size_t chip, int32_t *output, size_t frames, bool native);
+
+    /**
+     * @brief Check the output of the released chip, and put the chip asleep once it's proven to be silent
+     * @param chip Index of chip
+     * @param buffer Generated output of the chip
+     * @param frames Count of generated frames
+     * @param native Frames are at the native rate of the chip
+     * @return true if the output is silent and needs no mixing
+     */
+    bool updateReleasedChip(size_t chip, const int32_t *buffer, size_t frames, bool native);
+
+    /**
+     * @brief Job of worker threads: render one chip into its own scratch buffer
+     * @param self Pointer to the OPL3 instance
+     * @param chip Index of chip
+     */
+    static void renderChipJob(void *self, size_t chip);
+
+    /**
+     * @brief Job of worker threads: render all awake chips of the group into their scratch buffers
+     * @param self Pointer to the OPL3 instance
+     * @param group Index of chip group
+     */
+    static void renderGroupJob(void *self, size_t group);
+
+public:
+
+    /**
+     * @brief Set the quality of the output resampling
+     * @param quality Resampler quality (#ADLMIDI_ResamplerQuality)
+     */
+    void setResamplerQuality(int quality);
+
 #ifdef ADLMIDI_ENABLE_HW_SERIAL
     /**
      * @brief Reset chip properties for hardware use
@@ -445,6 +773,18 @@ public:
      * @param audioTickHandler
      */
     void resetSerial(const std::string &serialName, unsigned int baud, unsigned int protocol);
+
+    /**
+     * @brief Limit the data sent to the hardware chip by the bandwidth of the serial port
+     * @param throttle Send at most the data which the port can take by the time passed
+     */
+    void setSerialThrottle(bool throttle);
+
+    /**
+     * @brief Send register writes buffered since the previous call to the hardware chip
+     * @param seconds Time passed since the previous call
+     */
+    void flushSerial(double seconds);
 #endif
 
 #if defined(__DJGPP__)
@@ -133,6 +133,14 @@ typedef struct BW_MidiRtInterface BW_MidiRtInterface;
 
 class OPL3;
 class OPLChipBase;
+class OPLChipGroup;
+class OPLResampler;
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+class VResampler;
+class OPLResamplerCounter;
+#endif
+class ChipRenderThreads;
+class AsyncRenderThread;
 
 typedef class OPL3 Synth;
 
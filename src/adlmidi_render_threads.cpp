@@ -0,0 +1,417 @@
+/*
+ * libADLMIDI is a free Software MIDI synthesizer library with OPL3 emulation
+ *
+ * Original ADLMIDI code: Copyright (c) 2010-2014 Joel Yliluoma <bisqwit@iki.fi>
+ * ADLMIDI Library API:   Copyright (c) 2015-2026 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * Library is based on the ADLMIDI, a MIDI player for Linux and Windows with OPL3 emulation:
+ * http://iki.fi/bisqwit/source/adlmidi.html
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "adlmidi_render_threads.hpp"
+#include "adlmidi_atomic.hpp"
+
+#if !defined(ADLMIDI_DISABLE_RENDER_THREADS)
+#   if defined(_WIN32)
+#       include <windows.h>
+#   else
+#       include <pthread.h>
+#   endif
+#endif
+
+
+#if defined(ADLMIDI_DISABLE_RENDER_THREADS) // No threads, everything runs on the calling thread
+
+struct ChipRenderThreads::Impl
+{};
+
+bool ChipRenderThreads::isSupported()
+{
+    return false;
+}
+
+bool ChipRenderThreads::setThreads(unsigned count)
+{
+    return count <= 1;
+}
+
+void ChipRenderThreads::stopThreads()
+{}
+
+void ChipRenderThreads::run(JobFunc func, void *userData, size_t jobs, bool balanced)
+{
+    (void)balanced;
+
+    for(size_t j = 0; j < jobs; ++j)
+        func(userData, j);
+}
+
+#elif !defined(_WIN32) // pthread
+
+struct ChipRenderThreads::Worker
+{
+    ChipRenderThreads *self;
+    unsigned index;
+    pthread_t thread;
+};
+
+struct ChipRenderThreads::Impl
+{
+    pthread_mutex_t lock;
+    //! Held by the calling thread for the whole run, runs of other callers wait for it
+    pthread_mutex_t runLock;
+    //! Signaled by the calling thread when new jobs are available
+    pthread_cond_t  wake;
+    //! Signaled by the last worker which finished its share
+    pthread_cond_t  done;
+    //! Incremented on every run, workers compare it with the last seen value
+    unsigned generation;
+    //! Count of workers still processing their shares
+    unsigned pending;
+    bool quit;
+    Worker workers[MaxThreads];
+};
+
+void *chipRenderThreadMain(void *worker)
+{
+    ChipRenderThreads::Worker *w = static_cast<ChipRenderThreads::Worker *>(worker);
+    ChipRenderThreads::Impl *p = w->self->p;
+    unsigned seen = 0; // The generation counter is reset before workers get started
+
+    pthread_mutex_lock(&p->lock);
+
+    for(;;)
+    {
+        while(!p->quit && p->generation == seen)
+            pthread_cond_wait(&p->wake, &p->lock);
+
+        if(p->quit)
+            break;
+
+        seen = p->generation;
+        pthread_mutex_unlock(&p->lock);
+
+        w->self->runShare(w->index);
+
+        pthread_mutex_lock(&p->lock);
+        if(--p->pending == 0)
+            pthread_cond_signal(&p->done);
+    }
+
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+bool ChipRenderThreads::isSupported()
+{
+    return true;
+}
+
+bool ChipRenderThreads::setThreads(unsigned count)
+{
+    if(count < 1)
+        count = 1;
+    if(count > (unsigned)MaxThreads)
+        return false;
+
+    if(count == m_threads)
+        return true;
+
+    stopThreads();
+
+    if(count == 1)
+        return true;
+
+    if(!p)
+    {
+        p = new Impl;
+        pthread_mutex_init(&p->lock, NULL);
+        pthread_mutex_init(&p->runLock, NULL);
+        pthread_cond_init(&p->wake, NULL);
+        pthread_cond_init(&p->done, NULL);
+    }
+
+    p->generation = 0;
+    p->pending = 0;
+    p->quit = false;
+
+    // Worker 0 is the calling thread
+    for(unsigned i = 1; i < count; ++i)
+    {
+        Worker &w = p->workers[i];
+        w.self = this;
+        w.index = i;
+        if(pthread_create(&w.thread, NULL, &chipRenderThreadMain, &w) != 0)
+        {
+            stopThreads();
+            return false;
+        }
+        m_threads = i + 1;
+    }
+
+    return true;
+}
+
+void ChipRenderThreads::stopThreads()
+{
+    if(!p || m_threads <= 1)
+    {
+        m_threads = 1;
+        return;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->quit = true;
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+
+    for(unsigned i = 1; i < m_threads; ++i)
+        pthread_join(p->workers[i].thread, NULL);
+
+    m_threads = 1;
+}
+
+void ChipRenderThreads::run(JobFunc func, void *userData, size_t jobs, bool balanced)
+{
+    if(m_threads <= 1 || jobs <= 1)
+    {
+        for(size_t j = 0; j < jobs; ++j)
+            func(userData, j);
+        return;
+    }
+
+    pthread_mutex_lock(&p->runLock);
+
+    pthread_mutex_lock(&p->lock);
+    m_func = func;
+    m_userData = userData;
+    m_jobs = jobs;
+    m_balanced = balanced;
+    m_nextJob = 0;
+    p->pending = m_threads - 1;
+    ++p->generation;
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+
+    runShare(0);
+
+    pthread_mutex_lock(&p->lock);
+    while(p->pending > 0)
+        pthread_cond_wait(&p->done, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+
+    pthread_mutex_unlock(&p->runLock);
+}
+
+#else // Win32
+
+struct ChipRenderThreads::Worker
+{
+    ChipRenderThreads *self;
+    unsigned index;
+    HANDLE thread;
+    //! Auto-reset event, signaled by the calling thread when new jobs are available
+    HANDLE start;
+};
+
+struct ChipRenderThreads::Impl
+{
+    //! Held by the calling thread for the whole run, runs of other callers wait for it
+    CRITICAL_SECTION runLock;
+    //! Auto-reset event, signaled by the last worker which finished its share
+    HANDLE done;
+    //! Count of workers still processing their shares
+    volatile LONG pending;
+    volatile LONG quit;
+    Worker workers[MaxThreads];
+};
+
+void *chipRenderThreadMain(void *worker)
+{
+    ChipRenderThreads::Worker *w = static_cast<ChipRenderThreads::Worker *>(worker);
+    ChipRenderThreads::Impl *p = w->self->p;
+
+    for(;;)
+    {
+        WaitForSingleObject(w->start, INFINITE);
+
+        if(p->quit)
+            break;
+
+        w->self->runShare(w->index);
+
+        if(InterlockedDecrement(&p->pending) == 0)
+            SetEvent(p->done);
+    }
+
+    return NULL;
+}
+
+static DWORD WINAPI chipRenderThreadWin32(LPVOID worker)
+{
+    chipRenderThreadMain(worker);
+    return 0;
+}
+
+bool ChipRenderThreads::isSupported()
+{
+    return true;
+}
+
+bool ChipRenderThreads::setThreads(unsigned count)
+{
+    if(count < 1)
+        count = 1;
+    if(count > (unsigned)MaxThreads)
+        return false;
+
+    if(count == m_threads)
+        return true;
+
+    stopThreads();
+
+    if(count == 1)
+        return true;
+
+    if(!p)
+    {
+        p = new Impl;
+        InitializeCriticalSection(&p->runLock);
+        p->done = CreateEventW(NULL, FALSE, FALSE, NULL);
+    }
+
+    p->pending = 0;
+    p->quit = 0;
+
+    // Worker 0 is the calling thread
+    for(unsigned i = 1; i < count; ++i)
+    {
+        Worker &w = p->workers[i];
+        w.self = this;
+        w.index = i;
+        w.start = CreateEventW(NULL, FALSE, FALSE, NULL);
+        w.thread = CreateThread(NULL, 0, &chipRenderThreadWin32, &w, 0, NULL);
+        if(!w.thread)
+        {
+            CloseHandle(w.start);
+            stopThreads();
+            return false;
+        }
+        m_threads = i + 1;
+    }
+
+    return true;
+}
+
+void ChipRenderThreads::stopThreads()
+{
+    if(!p || m_threads <= 1)
+    {
+        m_threads = 1;
+        return;
+    }
+
+    InterlockedExchange(&p->quit, 1);
+    for(unsigned i = 1; i < m_threads; ++i)
+        SetEvent(p->workers[i].start);
+
+    for(unsigned i = 1; i < m_threads; ++i)
+    {
+        WaitForSingleObject(p->workers[i].thread, INFINITE);
+        CloseHandle(p->workers[i].thread);
+        CloseHandle(p->workers[i].start);
+    }
+
+    m_threads = 1;
+}
+
+void ChipRenderThreads::run(JobFunc func, void *userData, size_t jobs, bool balanced)
+{
+    if(m_threads <= 1 || jobs <= 1)
+    {
+        for(size_t j = 0; j < jobs; ++j)
+            func(userData, j);
+        return;
+    }
+
+    EnterCriticalSection(&p->runLock);
+
+    m_func = func;
+    m_userData = userData;
+    m_jobs = jobs;
+    m_balanced = balanced;
+    m_nextJob = 0;
+    InterlockedExchange(&p->pending, (LONG)(m_threads - 1));
+
+    for(unsigned i = 1; i < m_threads; ++i)
+        SetEvent(p->workers[i].start);
+
+    runShare(0);
+
+    WaitForSingleObject(p->done, INFINITE);
+
+    LeaveCriticalSection(&p->runLock);
+}
+
+#endif
+
+
+ChipRenderThreads::ChipRenderThreads() :
+    m_threads(1),
+    m_func(NULL),
+    m_userData(NULL),
+    m_jobs(0),
+    m_balanced(false),
+    m_nextJob(0),
+    p(NULL)
+{}
+
+ChipRenderThreads::~ChipRenderThreads()
+{
+    stopThreads();
+
+#if !defined(ADLMIDI_DISABLE_RENDER_THREADS)
+    if(p)
+    {
+#   if !defined(_WIN32)
+        pthread_cond_destroy(&p->done);
+        pthread_cond_destroy(&p->wake);
+        pthread_mutex_destroy(&p->runLock);
+        pthread_mutex_destroy(&p->lock);
+#   else
+        CloseHandle(p->done);
+        DeleteCriticalSection(&p->runLock);
+#   endif
+    }
+#endif
+
+    delete p;
+}
+
+void ChipRenderThreads::runShare(unsigned worker)
+{
+    const size_t threads = m_threads;
+
+    if(m_balanced)
+    {
+        for(size_t j = adl_atomicFetchAdd(&m_nextJob, 1); j < m_jobs; j = adl_atomicFetchAdd(&m_nextJob, 1))
+            m_func(m_userData, j);
+        return;
+    }
+
+    for(size_t j = worker; j < m_jobs; j += threads)
+        m_func(m_userData, j);
+}
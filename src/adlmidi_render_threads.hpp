@@ -0,0 +1,124 @@
+/*
+ * libADLMIDI is a free Software MIDI synthesizer library with OPL3 emulation
+ *
+ * Original ADLMIDI code: Copyright (c) 2010-2014 Joel Yliluoma <bisqwit@iki.fi>
+ * ADLMIDI Library API:   Copyright (c) 2015-2026 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * Library is based on the ADLMIDI, a MIDI player for Linux and Windows with OPL3 emulation:
+ * http://iki.fi/bisqwit/source/adlmidi.html
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADLMIDI_RENDER_THREADS_HPP
+#define ADLMIDI_RENDER_THREADS_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Worker threads are unavailable on platforms without a threading library,
+ * and when the audio tick handler calls the sequencer from the chip's generator.
+ */
+#if defined(ENABLE_HW_OPL_DOS) || defined(__DJGPP__) || defined(__WATCOMC__) || \
+    defined(DOSBOX_NO_MUTEX) || defined(USE_LIBOGC_MUTEX) || defined(USE_WUT_MUTEX) || \
+    (defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)) || \
+    defined(ADLMIDI_AUDIO_TICK_HANDLER)
+#   ifndef ADLMIDI_DISABLE_RENDER_THREADS
+#       define ADLMIDI_DISABLE_RENDER_THREADS
+#   endif
+#endif
+
+/**
+ * @brief Pool of worker threads that render chips concurrently
+ *
+ * Jobs are distributed between workers in a fixed order: job N is always
+ * processed by the worker (N % threads), the calling thread is the worker 0.
+ * Balanced runs let every worker take the next free job instead, for jobs
+ * of unequal cost which don't benefit from staying on the same worker.
+ */
+class ChipRenderThreads
+{
+public:
+    //! Maximum count of threads including the calling thread
+    enum { MaxThreads = 64 };
+
+    /**
+     * @brief Job function
+     * @param userData Pointer to the user data
+     * @param job Index of the job to process
+     */
+    typedef void (*JobFunc)(void *userData, size_t job);
+
+    ChipRenderThreads();
+    ~ChipRenderThreads();
+
+    /**
+     * @brief Are worker threads supported on this platform?
+     * @return true when worker threads can be started
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Start or stop worker threads
+     * @param count Total count of threads including the calling thread
+     * @return true on success, false if threads can't be started
+     */
+    bool setThreads(unsigned count);
+
+    /**
+     * @brief Count of threads including the calling thread
+     * @return Count of threads
+     */
+    unsigned threads() const
+    {
+        return m_threads;
+    }
+
+    /**
+     * @brief Process jobs by all threads and wait until all of them will be done
+     *
+     * Runs requested by several threads at once are processed one after another.
+     *
+     * @param func Job function
+     * @param userData Pointer to the user data passed into the job function
+     * @param jobs Count of jobs
+     * @param balanced Take the next free job by every worker instead of the fixed order
+     */
+    void run(JobFunc func, void *userData, size_t jobs, bool balanced = false);
+
+private:
+    ChipRenderThreads(const ChipRenderThreads &);
+    ChipRenderThreads &operator=(const ChipRenderThreads &);
+
+    struct Worker;
+    struct Impl;
+    friend void *chipRenderThreadMain(void *worker);
+
+    //! Process the share of jobs of the given worker
+    void runShare(unsigned worker);
+    //! Stop and join all worker threads
+    void stopThreads();
+
+    unsigned m_threads;
+    JobFunc  m_func;
+    void    *m_userData;
+    size_t   m_jobs;
+    bool     m_balanced;
+    //! Index of the next free job of the balanced run
+    volatile uint32_t m_nextJob;
+    Impl    *p;
+};
+
+#endif // ADLMIDI_RENDER_THREADS_HPP
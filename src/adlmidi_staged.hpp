@@ -0,0 +1,104 @@
+/*
+ * libADLMIDI is a free Software MIDI synthesizer library with OPL3 emulation
+ *
+ * Original ADLMIDI code: Copyright (c) 2010-2014 Joel Yliluoma <bisqwit@iki.fi>
+ * ADLMIDI Library API:   Copyright (c) 2015-2026 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * Library is based on the ADLMIDI, a MIDI player for Linux and Windows with OPL3 emulation:
+ * http://iki.fi/bisqwit/source/adlmidi.html
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADLMIDI_STAGED_HPP
+#define ADLMIDI_STAGED_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include "adlmidi_atomic.hpp"
+
+/**
+ * @brief Block of data published by one thread and taken by another one without waiting
+ *
+ * Three copies of the block are rotated: the writer fills its own copy and
+ * exchanges it with the shared one, the reader exchanges its own copy with
+ * the shared one once it has been published. Only the latest published
+ * block is taken, older ones which the reader has missed are overwritten.
+ */
+template<class T>
+class StagedBlock
+{
+public:
+    StagedBlock() :
+        m_state(1),
+        m_back(0),
+        m_front(2)
+    {}
+
+    /**
+     * @brief Copy of the block owned by the writer, to fill before publish()
+     * @return Copy of the writer
+     */
+    T &back()
+    {
+        return m_slots[m_back];
+    }
+
+    /**
+     * @brief Publish the copy of the writer, called by the writer thread only
+     */
+    void publish()
+    {
+        uint32_t old = adl_atomicExchange(&m_state, m_back | Fresh);
+        m_back = old & IndexMask;
+    }
+
+    /**
+     * @brief Take the latest published block, called by the reader thread only
+     * @return Block owned by the reader until the next call, NULL if nothing new was published
+     */
+    const T *take()
+    {
+        if((adl_atomicLoad(&m_state) & Fresh) == 0)
+            return NULL;
+
+        // Only the writer may change the state meanwhile, and it keeps the fresh flag
+        uint32_t old = adl_atomicExchange(&m_state, m_front);
+        m_front = old & IndexMask;
+        return &m_slots[m_front];
+    }
+
+private:
+    enum
+    {
+        //! Mask of the index of the shared copy in the state
+        IndexMask = 3,
+        //! Flag of the state: shared copy was published and not taken yet
+        Fresh = 4
+    };
+
+    //! Copies of the block
+    T m_slots[3];
+    //! Index of the shared copy and the fresh flag
+    volatile uint32_t m_state;
+    //! Index of the copy of the writer
+    uint32_t m_back;
+    //! Index of the copy of the reader
+    uint32_t m_front;
+
+    StagedBlock(const StagedBlock &);
+    StagedBlock &operator=(const StagedBlock &);
+};
+
+#endif // ADLMIDI_STAGED_HPP
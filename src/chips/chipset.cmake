@@ -21,6 +21,8 @@
 set(CHIPS_SOURCES
     "${CMAKE_CURRENT_LIST_DIR}/opl_chip_base.h"
     "${CMAKE_CURRENT_LIST_DIR}/opl_chip_base.tcc"
+    "${CMAKE_CURRENT_LIST_DIR}/opl_resampler.cpp"
+    "${CMAKE_CURRENT_LIST_DIR}/opl_resampler.h"
 )
 
 if(OPL_CHIPSET_DOS_HARDWARE_MODE)
@@ -79,6 +81,12 @@ if(OPL_CHIPSET_ENABLE_SW_EMULATORS)
         "${CMAKE_CURRENT_LIST_DIR}/nuked_fast/nukedopl3_fast.c"
         "${CMAKE_CURRENT_LIST_DIR}/nuked_fast/nukedopl3_fast.h"
         "${CMAKE_CURRENT_LIST_DIR}/nuked_fast/wf_rom.h"
+        "${CMAKE_CURRENT_LIST_DIR}/nuked_opl3_simd.cpp"
+        "${CMAKE_CURRENT_LIST_DIR}/nuked_opl3_simd.h"
+        "${CMAKE_CURRENT_LIST_DIR}/nuked_simd/nukedopl3_simd.c"
+        "${CMAKE_CURRENT_LIST_DIR}/nuked_simd/nukedopl3_simd.h"
+        "${CMAKE_CURRENT_LIST_DIR}/nuked_simd/nukedopl3_simd_lanes.h"
+        "${CMAKE_CURRENT_LIST_DIR}/nuked_simd/nukedopl3_simd_chip.h"
     )
 endif()
 
@@ -1,4 +1,5 @@
 SOURCES+= \
+    $$PWD/opl_resampler.cpp \
     $$PWD/dosbox_opl3.cpp \
     $$PWD/esfmu_opl3.cpp \
     $$PWD/java_opl3.cpp \
@@ -15,6 +16,8 @@ SOURCES+= \
     $$PWD/nuked/nukedopl2.c \
     $$PWD/nuked_opl3_fast.cpp \
     $$PWD/nuked_fast/nukedopl3_fast.c \
+    $$PWD/nuked_opl3_simd.cpp \
+    $$PWD/nuked_simd/nukedopl3_simd.c \
     $$PWD/nuked_cqm.cpp \
     $$PWD/nuked_cqm/cqm.c \
     $$PWD/vpc_opl3_emu.cpp \
@@ -29,6 +32,7 @@ SOURCES+= \
 HEADERS+= \
     $$PWD/opl_chip_base.h \
     $$PWD/opl_chip_base.tcc \
+    $$PWD/opl_resampler.h \
     $$PWD/dosbox_opl3.h \
     $$PWD/esfmu_opl3.h \
     $$PWD/java_opl3.h \
@@ -47,6 +51,10 @@ HEADERS+= \
     $$PWD/nuked_opl3_fast.h \
     $$PWD/nuked_fast/nukedopl3_fast.h \
     $$PWD/nuked_fast/wf_rom.h \
+    $$PWD/nuked_opl3_simd.h \
+    $$PWD/nuked_simd/nukedopl3_simd.h \
+    $$PWD/nuked_simd/nukedopl3_simd_lanes.h \
+    $$PWD/nuked_simd/nukedopl3_simd_chip.h \
     $$PWD/nuked_cqm.h \
     $$PWD/nuked_cqm/cqm.h \
     $$PWD/vpc_opl3_emu.h \
@@ -208,6 +208,11 @@ void DOS_HW_OPL::nativeGenerate(int16_t *frame)
     frame[1] = 0;
 }
 
+void DOS_HW_OPL::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    memset(output, 0, 2 * frames * sizeof(int16_t));
+}
+
 const char *DOS_HW_OPL::emulatorName()
 {
     return s_devName;
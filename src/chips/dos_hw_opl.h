@@ -46,6 +46,7 @@ public:
     void nativePreGenerate() override {}
     void nativePostGenerate() override {}
     void nativeGenerate(int16_t *frame) override;
+    void nativeGenerateBlock(int16_t *output, size_t frames) override;
     const char *emulatorName() override;
     ChipType chipType() override;
     bool hasFullPanning() override;
@@ -1183,6 +1183,13 @@ static const uint8_t eg_incstep[4][4] = {
 	{ 1, 1, 1, 0 }
 };
 
+/*
+ * Slots attenuated at least by this envelope level output nothing but zero:
+ * the exponent gets shifted out for any phase of any waveform. Their table
+ * lookups are skipped unless _ESFMU_DISABLE_SILENT_SLOT_SKIP is defined.
+ */
+#define ESFM_SILENT_ENVELOPE 0x180
+
 /* ------------------------------------------------------------------------- */
 static /*inline*/ int13
 ESFM_envelope_wavegen(uint3 waveform, int16 phase, uint10 envelope)
@@ -1693,6 +1700,13 @@ static void
 ESFM_slot_generate(esfm_slot *slot)
 {
 	int16 phase = slot->in.phase_out;
+#ifndef _ESFMU_DISABLE_SILENT_SLOT_SKIP
+	if (slot->in.eg_output >= ESFM_SILENT_ENVELOPE)
+	{
+		slot->in.output = 0;
+		return;
+	}
+#endif
 	if (slot->mod_in_level)
 	{
 		if (slot->slot_idx == 3 && slot->rhy_noise == 3)
@@ -1724,6 +1738,13 @@ ESFM_slot_generate_emu(esfm_slot *slot)
 	int16 phase = slot->in.phase_out;
 	int14 output_value;
 
+#ifndef _ESFMU_DISABLE_SILENT_SLOT_SKIP
+	if (slot->in.eg_output >= ESFM_SILENT_ENVELOPE)
+	{
+		slot->in.output = 0;
+		return;
+	}
+#endif
 	phase += *slot->in.mod_input & slot->in.emu_mod_enable;
 	slot->in.output = ESFM_envelope_wavegen(waveform, phase, slot->in.eg_output);
 	output_value = (slot->in.output & slot->in.emu_output_enable) << rhythm_slot_double_volume;
@@ -1769,6 +1790,14 @@ ESFM_process_feedback(esfm_chip *chip)
 
 		if (slot->mod_in_level && (chip->native_mode || (slot->in.mod_input == &slot->in.feedback_buf)))
 		{
+#ifndef _ESFMU_DISABLE_SILENT_SLOT_SKIP
+			/* Every iteration of the silent slot outputs zero, so does the feedback */
+			if (slot->in.eg_output >= ESFM_SILENT_ENVELOPE)
+			{
+				slot->in.feedback_buf = 0;
+				continue;
+			}
+#endif
 			if (chip->native_mode)
 			{
 				waveform = slot->waveform;
@@ -57,6 +57,13 @@ void ESFMuOPL3::writeReg(uint16_t addr, uint8_t data)
     ESFM_write_reg_buffered_fast(chip_r, addr, data);
 }
 
+void ESFMuOPL3::writeRegs(const uint16_t *addr, const uint8_t *data, size_t n)
+{
+    esfm_chip *chip_r = reinterpret_cast<esfm_chip*>(m_chip);
+    for(size_t i = 0; i < n; ++i)
+        ESFM_write_reg_buffered_fast(chip_r, addr[i], data[i]);
+}
+
 void ESFMuOPL3::writePan(uint16_t addr, uint8_t data)
 {
     esfm_chip *chip_r = reinterpret_cast<esfm_chip*>(m_chip);
@@ -69,6 +76,12 @@ void ESFMuOPL3::nativeGenerate(int16_t *frame)
     ESFM_generate(chip_r, frame);
 }
 
+void ESFMuOPL3::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    esfm_chip *chip_r = reinterpret_cast<esfm_chip*>(m_chip);
+    ESFM_generate_stream(chip_r, output, static_cast<uint32_t>(frames));
+}
+
 const char *ESFMuOPL3::emulatorName()
 {
     return "ESFMu";
@@ -898,6 +898,16 @@ static void OPL3_SlotGenerate(opl3_slot *slot)
     }
 
     neg = (int32_t)((uint32_t)phase << slot->signpos) >> 31;
+
+#if OPL_SKIP_SILENT_SLOTS
+    /* Fully attenuated slots: the exponent gets shifted out, only the sign is left */
+    if (slot->eg_out == (0x1ff << 3))
+    {
+        slot->out = (int16_t)neg;
+        return;
+    }
+#endif
+
     phaseshift = slot->phaseshift;
     level = slot->eg_out;
 
@@ -47,6 +47,10 @@ extern "C" {
 #define OPL_FAST_WAVEGEN 1 /* optimized waveform generation */
 #endif
 
+#ifndef OPL_SKIP_SILENT_SLOTS
+#define OPL_SKIP_SILENT_SLOTS 1 /* no table lookups for fully attenuated slots, needs OPL_FAST_WAVEGEN */
+#endif
+
 #define OPL_WRITEBUF_SIZE   2048
 #define OPL_WRITEBUF_DELAY  2
 
@@ -57,18 +57,237 @@ void NukedOPL3::writeReg(uint16_t addr, uint8_t data)
     OPL3_WriteRegBuffered(chip_r, addr, data);
 }
 
+void NukedOPL3::writeRegs(const uint16_t *addr, const uint8_t *data, size_t n)
+{
+    opl3_chip *chip_r = reinterpret_cast<opl3_chip*>(m_chip);
+    for(size_t i = 0; i < n; ++i)
+        OPL3_WriteRegBuffered(chip_r, addr[i], data[i]);
+}
+
 void NukedOPL3::writePan(uint16_t addr, uint8_t data)
 {
     opl3_chip *chip_r = reinterpret_cast<opl3_chip*>(m_chip);
     OPL3_WritePan(chip_r, addr, data);
 }
 
+#if OPL_FAST_WAVEGEN
+// Frequency multipliers of the phase generator, multiplied by 2
+static const uint8_t s_phaseMult[16] =
+{
+    1, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 20, 24, 24, 30, 30
+};
+
+static uint32_t slotPhaseIncrement(const opl3_slot *slot)
+{
+    const opl3_chip *chip = slot->chip;
+    uint16_t f_num = slot->channel->f_num;
+
+    if(slot->reg_vib)
+    {
+        int8_t range = (f_num >> 7) & 7;
+        const uint8_t vibpos = chip->vibpos;
+
+        if(!(vibpos & 3))
+            range = 0;
+        else if(vibpos & 1)
+            range >>= 1;
+        range >>= chip->vibshift;
+
+        if(vibpos & 4)
+            range = -range;
+        f_num += range;
+    }
+
+    const uint32_t basefreq = (f_num << slot->channel->block) >> 1;
+    return (basefreq * s_phaseMult[slot->reg_mult]) >> 1;
+}
+
+static void skipChipTimers(opl3_chip *chip_r, uint64_t frames)
+{
+    const uint64_t timer = chip_r->timer;
+
+    // Tremolo steps every 64 frames, vibrato steps every 1024 frames
+    const uint64_t tremoloSteps = ((timer + frames) >> 6) - (timer >> 6);
+    const uint64_t vibratoSteps = ((timer + frames) >> 10) - (timer >> 10);
+
+    chip_r->tremolopos = (uint8_t)((chip_r->tremolopos + tremoloSteps % 210) % 210);
+    if(chip_r->tremolopos < 105)
+        chip_r->tremolo = chip_r->tremolopos >> chip_r->tremoloshift;
+    else
+        chip_r->tremolo = (210 - chip_r->tremolopos) >> chip_r->tremoloshift;
+    chip_r->vibpos = (uint8_t)((chip_r->vibpos + vibratoSteps) & 7);
+    chip_r->timer = (uint16_t)(timer + frames);
+
+    // Envelope clock ticks every second frame, it's a 36-bit counter
+    const uint64_t egMask = ((uint64_t)1 << 36) - 1;
+    const uint64_t egSteps = chip_r->eg_state ? (frames + 1) / 2 : frames / 2;
+    chip_r->eg_timer = (chip_r->eg_timer + egSteps) & egMask;
+    chip_r->eg_timerrem = 0;
+    chip_r->eg_state ^= (uint8_t)(frames & 1);
+
+    // Restore the envelope increment computed at the last ticking frame
+    if(egSteps > 0)
+    {
+        const uint64_t egLast = (chip_r->eg_timer - 1) & egMask;
+        uint8_t shift = 0;
+        while(shift < 13 && ((egLast >> shift) & 1) == 0)
+            shift++;
+        chip_r->eg_add = (shift > 12) ? 0 : (uint8_t)(shift + 1);
+        chip_r->eg_timer_lo = (uint8_t)(egLast & 0x3u);
+    }
+
+    // Noise generator steps once per slot, new bits don't reach the tap 14 during the first 9 steps
+    uint32_t noise = chip_r->noise;
+    for(uint64_t steps = frames * 36; steps > 0;)
+    {
+        const uint32_t count = steps > 8 ? 8 : (uint32_t)steps;
+        const uint32_t bits = (noise ^ (noise >> 14)) & ((1u << count) - 1);
+        noise = (noise >> count) | (bits << (23 - count));
+        steps -= count;
+    }
+    chip_r->noise = noise;
+
+    chip_r->writebuf_samplecnt += frames;
+}
+
+/*
+ * Advance the chip proven silent by envelopesFinished(): envelopes stay at the total
+ * attenuation, so every slot outputs only the sign of its phase. Phases of slots get
+ * advanced at once, except of the feedback slots: their phase gets shifted by their
+ * own past outputs, so they get stepped frame by frame. Outputs of other slots depend
+ * on the current frame only, the caller recomputes them by emulating the last frames.
+ */
+static void skipSilentFrames(opl3_chip *chip_r, uint64_t frames)
+{
+    while(frames > 0)
+    {
+        // Vibrato steps every 1024 frames
+        uint64_t count = 1024 - (chip_r->timer & 0x3ff);
+        if(count > frames)
+            count = frames;
+
+        for(size_t i = 0; i < 36; ++i)
+        {
+            opl3_slot *slot = &chip_r->slot[i];
+            const uint32_t inc = slotPhaseIncrement(slot);
+            const uint8_t fb = slot->channel->fb;
+
+            if(slot->mod != &slot->fbmod || fb == 0)
+            {
+                slot->pg_phase += (uint32_t)(inc * count);
+                continue;
+            }
+
+            uint32_t pg_phase = slot->pg_phase;
+            int16_t out = slot->out, prout = slot->prout, fbmod = slot->fbmod;
+            for(uint64_t f = 0; f < count; ++f)
+            {
+                fbmod = (int16_t)((prout + out) >> (0x09 - fb));
+                prout = out;
+                const uint16_t phase = (uint16_t)((uint16_t)(pg_phase >> 9) + fbmod);
+                pg_phase += inc;
+                if(phase & slot->maskzero)
+                    out = 0;
+                else
+                    out = (int16_t)((int32_t)((uint32_t)phase << slot->signpos) >> 31);
+            }
+            slot->pg_phase = pg_phase;
+            slot->out = out;
+            slot->prout = prout;
+            slot->fbmod = fbmod;
+        }
+
+        skipChipTimers(chip_r, count);
+        frames -= count;
+    }
+}
+#endif
+
+void NukedOPL3::nativeSkip(uint64_t frames)
+{
+    opl3_chip *chip_r = reinterpret_cast<opl3_chip*>(m_chip);
+    int16_t frame[2];
+
+#if OPL_FAST_WAVEGEN
+    // Feedback of slots reaches back two frames, the last frames are emulated to restore outputs
+    const uint64_t emulated = frames < 3 ? frames : 3;
+    skipSilentFrames(chip_r, frames - emulated);
+#else
+    const uint64_t emulated = frames;
+#endif
+
+    for(uint64_t i = 0; i < emulated; ++i)
+        OPL3_Generate(chip_r, frame);
+}
+
+bool NukedOPL3::envelopesFinished() const
+{
+#if OPL_FAST_WAVEGEN
+    const opl3_chip *chip_r = reinterpret_cast<const opl3_chip*>(m_chip);
+
+    // Pending buffered writes may key-on slots
+    if(chip_r->writebuf[chip_r->writebuf_cur].reg & 0x200)
+        return false;
+
+    // The right side of the mix gets output one frame later
+    if(chip_r->mixbuff[1] != 0 || chip_r->mixbuff[3] != 0)
+        return false;
+
+    for(size_t i = 0; i < 36; ++i)
+    {
+        const opl3_slot &slot = chip_r->slot[i];
+        // Released to the total attenuation, slots output 0 or -1 only
+        if(slot.key || slot.eg_rout != 0x1ff || slot.eg_gen != 3 || slot.eg_out != (0x1ff << 3))
+            return false;
+    }
+
+    // Sums of those outputs must be scaled to zero by every panning of the channel
+    for(size_t i = 0; i < 18; ++i)
+    {
+        const opl3_channel &ch = chip_r->channel[i];
+        uint32_t outs = 0;
+        for(size_t j = 0; j < 4; ++j)
+        {
+            if(ch.out[j] != &chip_r->zeromod)
+                ++outs;
+        }
+
+        if(outs == 0)
+            continue;
+#if OPL_ENABLE_STEREOEXT
+        if(ch.leftpan != 0 || ch.rightpan != 0)
+            return false;
+#else
+        if((ch.cha != 0 && outs * ch.chl >= 65535) || (ch.chb != 0 && outs * ch.chr >= 65535))
+            return false;
+#endif
+        if(ch.chc != 0 || ch.chd != 0)
+            return false;
+    }
+
+    return true;
+#else
+    return false; // The silent output of slots is not guaranteed
+#endif
+}
+
 void NukedOPL3::nativeGenerate(int16_t *frame)
 {
     opl3_chip *chip_r = reinterpret_cast<opl3_chip*>(m_chip);
     OPL3_Generate(chip_r, frame);
 }
 
+void NukedOPL3::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    // OPL3_GenerateStream() can't be used here: it runs the internal resampler
+    opl3_chip *chip_r = reinterpret_cast<opl3_chip*>(m_chip);
+    for(size_t i = 0; i < frames; ++i)
+    {
+        OPL3_Generate(chip_r, output);
+        output += 2;
+    }
+}
+
 const char *NukedOPL3::emulatorName()
 {
     return "Nuked OPL3 (v 1.8)";
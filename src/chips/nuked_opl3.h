@@ -34,10 +34,14 @@ public:
     void setRate(uint32_t rate) override;
     void reset() override;
     void writeReg(uint16_t addr, uint8_t data) override;
+    void writeRegs(const uint16_t *addr, const uint8_t *data, size_t n) override;
     void writePan(uint16_t addr, uint8_t data) override;
+    void nativeSkip(uint64_t frames) override;
+    bool envelopesFinished() const override;
     void nativePreGenerate() override {}
     void nativePostGenerate() override {}
     void nativeGenerate(int16_t *frame) override;
+    void nativeGenerateBlock(int16_t *output, size_t frames) override;
     const char *emulatorName() override;
     ChipType chipType() override;
     bool hasFullPanning() override;
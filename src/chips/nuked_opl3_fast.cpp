@@ -57,6 +57,13 @@ void NukedOPL3Fast::writeReg(uint16_t addr, uint8_t data)
     OPL3Fast_WriteRegBuffered(chip_r, addr, data);
 }
 
+void NukedOPL3Fast::writeRegs(const uint16_t *addr, const uint8_t *data, size_t n)
+{
+    opl3_chip *chip_r = reinterpret_cast<opl3_chip*>(m_chip);
+    for(size_t i = 0; i < n; ++i)
+        OPL3Fast_WriteRegBuffered(chip_r, addr[i], data[i]);
+}
+
 void NukedOPL3Fast::writePan(uint16_t addr, uint8_t data)
 {
     opl3_chip *chip_r = reinterpret_cast<opl3_chip*>(m_chip);
@@ -69,6 +76,16 @@ void NukedOPL3Fast::nativeGenerate(int16_t *frame)
     OPL3Fast_Generate(chip_r, frame);
 }
 
+void NukedOPL3Fast::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    opl3_chip *chip_r = reinterpret_cast<opl3_chip*>(m_chip);
+    for(size_t i = 0; i < frames; ++i)
+    {
+        OPL3Fast_Generate(chip_r, output);
+        output += 2;
+    }
+}
+
 const char *NukedOPL3Fast::emulatorName()
 {
     return "Nuked OPL3 Fast (by tgies)";
@@ -0,0 +1,213 @@
+/*
+ * Interfaces over Yamaha OPL2 (YM3812) and Yamaha OPL3 (YMF262) chip emulators
+ *
+ * Copyright (c) 2017-2026 Vitaly Novichkov (Wohlstand)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "nuked_opl3_simd.h"
+#include "nuked_simd/nukedopl3_simd.h"
+#include <cstring>
+
+NukedOPL3SIMD::NukedOPL3SIMD() :
+    OPLChipBaseT()
+{
+    m_chip = new opl3_simd_chip;
+    NukedOPL3SIMD::setRate(m_rate);
+}
+
+NukedOPL3SIMD::~NukedOPL3SIMD()
+{
+    opl3_simd_chip *chip_r = reinterpret_cast<opl3_simd_chip*>(m_chip);
+    delete chip_r;
+}
+
+void NukedOPL3SIMD::setRate(uint32_t rate)
+{
+    OPLChipBaseT::setRate(rate);
+    opl3_simd_chip *chip_r = reinterpret_cast<opl3_simd_chip*>(m_chip);
+    OPL3SIMD_Reset(chip_r, rate);
+}
+
+void NukedOPL3SIMD::reset()
+{
+    OPLChipBaseT::reset();
+    opl3_simd_chip *chip_r = reinterpret_cast<opl3_simd_chip*>(m_chip);
+    OPL3SIMD_Reset(chip_r, m_rate);
+}
+
+void NukedOPL3SIMD::writeReg(uint16_t addr, uint8_t data)
+{
+    opl3_simd_chip *chip_r = reinterpret_cast<opl3_simd_chip*>(m_chip);
+    OPL3SIMD_WriteRegBuffered(chip_r, addr, data);
+}
+
+void NukedOPL3SIMD::writeRegs(const uint16_t *addr, const uint8_t *data, size_t n)
+{
+    opl3_simd_chip *chip_r = reinterpret_cast<opl3_simd_chip*>(m_chip);
+    for(size_t i = 0; i < n; ++i)
+        OPL3SIMD_WriteRegBuffered(chip_r, addr[i], data[i]);
+}
+
+void NukedOPL3SIMD::writePan(uint16_t addr, uint8_t data)
+{
+    opl3_simd_chip *chip_r = reinterpret_cast<opl3_simd_chip*>(m_chip);
+    OPL3SIMD_WritePan(chip_r, addr, data);
+}
+
+void NukedOPL3SIMD::nativeGenerate(int16_t *frame)
+{
+    opl3_simd_chip *chip_r = reinterpret_cast<opl3_simd_chip*>(m_chip);
+    OPL3SIMD_Generate(chip_r, frame);
+}
+
+void NukedOPL3SIMD::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    opl3_simd_chip *chip_r = reinterpret_cast<opl3_simd_chip*>(m_chip);
+    for(size_t i = 0; i < frames; ++i)
+    {
+        OPL3SIMD_Generate(chip_r, output);
+        output += 2;
+    }
+}
+
+const char *NukedOPL3SIMD::emulatorName()
+{
+    return "Nuked OPL3 SIMD (v 1.8)";
+}
+
+bool NukedOPL3SIMD::hasFullPanning()
+{
+    return true;
+}
+
+OPLChipBase::ChipType NukedOPL3SIMD::chipType()
+{
+    return CHIPTYPE_OPL3;
+}
+
+NukedOPL3SIMDGroup::NukedOPL3SIMDGroup() :
+    OPLChipGroup()
+{
+    opl3_simd_group *group_r = new opl3_simd_group;
+    OPL3SIMD_GroupInit(group_r, OPLChipBase::nativeRate);
+    m_group = group_r;
+}
+
+NukedOPL3SIMDGroup::~NukedOPL3SIMDGroup()
+{
+    opl3_simd_group *group_r = reinterpret_cast<opl3_simd_group*>(m_group);
+    delete group_r;
+}
+
+size_t NukedOPL3SIMDGroup::chips() const
+{
+    return OPL3SIMD_GROUP_CHIPS;
+}
+
+OPLChipBase *NukedOPL3SIMDGroup::createChip(size_t index)
+{
+    return new NukedOPL3SIMDGroupChip(m_group, (uint32_t)index);
+}
+
+void NukedOPL3SIMDGroup::nativeGenerateChips(int32_t *output, size_t stride, uint32_t mask, size_t frames)
+{
+    opl3_simd_group *group_r = reinterpret_cast<opl3_simd_group*>(m_group);
+    int16_t frame[2 * OPL3SIMD_GROUP_CHIPS];
+
+    for(size_t i = 0; i < frames; ++i)
+    {
+        OPL3SIMD_GroupGenerate(group_r, mask, frame);
+        for(size_t c = 0; c < OPL3SIMD_GROUP_CHIPS; ++c)
+        {
+            if(mask & (1u << c))
+            {
+                output[c * stride + 2 * i] = frame[2 * c];
+                output[c * stride + 2 * i + 1] = frame[2 * c + 1];
+            }
+        }
+    }
+}
+
+NukedOPL3SIMDGroupChip::NukedOPL3SIMDGroupChip(void *group, uint32_t index) :
+    OPLChipBaseT(),
+    m_group(group),
+    m_index(index)
+{
+    NukedOPL3SIMDGroupChip::setRate(m_rate);
+}
+
+NukedOPL3SIMDGroupChip::~NukedOPL3SIMDGroupChip()
+{}
+
+void NukedOPL3SIMDGroupChip::setRate(uint32_t rate)
+{
+    OPLChipBaseT::setRate(rate);
+    opl3_simd_group *group_r = reinterpret_cast<opl3_simd_group*>(m_group);
+    OPL3SIMD_GroupReset(group_r, m_index, rate);
+}
+
+void NukedOPL3SIMDGroupChip::reset()
+{
+    OPLChipBaseT::reset();
+    opl3_simd_group *group_r = reinterpret_cast<opl3_simd_group*>(m_group);
+    OPL3SIMD_GroupReset(group_r, m_index, m_rate);
+}
+
+void NukedOPL3SIMDGroupChip::writeReg(uint16_t addr, uint8_t data)
+{
+    opl3_simd_group *group_r = reinterpret_cast<opl3_simd_group*>(m_group);
+    OPL3SIMD_GroupWriteRegBuffered(group_r, m_index, addr, data);
+}
+
+void NukedOPL3SIMDGroupChip::writePan(uint16_t addr, uint8_t data)
+{
+    opl3_simd_group *group_r = reinterpret_cast<opl3_simd_group*>(m_group);
+    OPL3SIMD_GroupWritePan(group_r, m_index, addr, data);
+}
+
+void NukedOPL3SIMDGroupChip::nativeGenerate(int16_t *frame)
+{
+    opl3_simd_group *group_r = reinterpret_cast<opl3_simd_group*>(m_group);
+    int16_t frames[2 * OPL3SIMD_GROUP_CHIPS];
+    OPL3SIMD_GroupGenerate(group_r, 1u << m_index, frames);
+    frame[0] = frames[2 * m_index];
+    frame[1] = frames[2 * m_index + 1];
+}
+
+void NukedOPL3SIMDGroupChip::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    for(size_t i = 0; i < frames; ++i)
+    {
+        nativeGenerate(output);
+        output += 2;
+    }
+}
+
+const char *NukedOPL3SIMDGroupChip::emulatorName()
+{
+    return "Nuked OPL3 SIMD (v 1.8)";
+}
+
+bool NukedOPL3SIMDGroupChip::hasFullPanning()
+{
+    return true;
+}
+
+OPLChipBase::ChipType NukedOPL3SIMDGroupChip::chipType()
+{
+    return CHIPTYPE_OPL3;
+}
@@ -0,0 +1,83 @@
+/*
+ * Interfaces over Yamaha OPL2 (YM3812) and Yamaha OPL3 (YMF262) chip emulators
+ *
+ * Copyright (c) 2017-2026 Vitaly Novichkov (Wohlstand)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef NUKED_OPL3_SIMD_H
+#define NUKED_OPL3_SIMD_H
+
+#include "opl_chip_base.h"
+
+class NukedOPL3SIMD final : public OPLChipBaseT<NukedOPL3SIMD>
+{
+    void *m_chip;
+public:
+    NukedOPL3SIMD();
+    ~NukedOPL3SIMD() override;
+
+    bool canRunAtPcmRate() const override { return false; }
+    void setRate(uint32_t rate) override;
+    void reset() override;
+    void writeReg(uint16_t addr, uint8_t data) override;
+    void writeRegs(const uint16_t *addr, const uint8_t *data, size_t n) override;
+    void writePan(uint16_t addr, uint8_t data) override;
+    void nativePreGenerate() override {}
+    void nativePostGenerate() override {}
+    void nativeGenerate(int16_t *frame) override;
+    void nativeGenerateBlock(int16_t *output, size_t frames) override;
+    const char *emulatorName() override;
+    ChipType chipType() override;
+    bool hasFullPanning() override;
+};
+
+class NukedOPL3SIMDGroup final : public OPLChipGroup
+{
+    void *m_group;
+public:
+    NukedOPL3SIMDGroup();
+    ~NukedOPL3SIMDGroup() override;
+
+    size_t chips() const override;
+    OPLChipBase *createChip(size_t index) override;
+    void nativeGenerateChips(int32_t *output, size_t stride, uint32_t mask, size_t frames) override;
+};
+
+// One chip of the group, it gets generated alone when used as a standalone chip
+class NukedOPL3SIMDGroupChip final : public OPLChipBaseT<NukedOPL3SIMDGroupChip>
+{
+    void *m_group;
+    uint32_t m_index;
+public:
+    NukedOPL3SIMDGroupChip(void *group, uint32_t index);
+    ~NukedOPL3SIMDGroupChip() override;
+
+    bool canRunAtPcmRate() const override { return false; }
+    void setRate(uint32_t rate) override;
+    void reset() override;
+    void writeReg(uint16_t addr, uint8_t data) override;
+    void writePan(uint16_t addr, uint8_t data) override;
+    void nativePreGenerate() override {}
+    void nativePostGenerate() override {}
+    void nativeGenerate(int16_t *frame) override;
+    void nativeGenerateBlock(int16_t *output, size_t frames) override;
+    const char *emulatorName() override;
+    ChipType chipType() override;
+    bool hasFullPanning() override;
+};
+
+#endif // NUKED_OPL3_SIMD_H
@@ -0,0 +1,493 @@
+/* Nuked OPL3
+ * Copyright (C) 2013-2020 Nuke.YKT
+ *
+ * This file is part of Nuked OPL3.
+ *
+ * Nuked OPL3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * Nuked OPL3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuked OPL3. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Nuked OPL3 emulator, structure-of-arrays variant.
+ *
+ *  The per-slot pipeline of the original core is split into passes over
+ *  all slots: feedback, envelope and phase generators are independent
+ *  between slots, the waveform generator runs once per depth of the
+ *  modulation chain (the modulator of any slot is always processed
+ *  earlier within a sample), the rhythm phases and the noise generator
+ *  are done by the scalar code in the slot order of the original core.
+ *
+ * version: 1.8
+ */
+
+#include <string.h>
+#include "nukedopl3_simd.h"
+
+#if !OPL_FAST_WAVEGEN
+#error "The structure-of-arrays Nuked OPL3 implements the OPL_FAST_WAVEGEN path only"
+#endif
+
+/* Quirk: Some FM channels are output one sample later on the left side than the right. */
+#ifndef OPL_QUIRK_CHANNELSAMPLEDELAY
+#define OPL_QUIRK_CHANNELSAMPLEDELAY (!OPL_ENABLE_STEREOEXT)
+#endif
+
+#if !defined(OPL3SIMD_NO_AVX2) && !defined(__DJGPP__) && !defined(__WATCOMC__) && \
+    (defined(__x86_64__) || defined(__i386__)) && !defined(__AVX2__) && \
+    (defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define OPL3SIMD_AVX2_KERNEL
+#endif
+
+enum {
+    envelope_gen_num_attack = 0,
+    envelope_gen_num_decay = 1,
+    envelope_gen_num_sustain = 2,
+    envelope_gen_num_release = 3
+};
+
+/* Chip-wide values which are constant during one sample, one entry per chip of the state */
+typedef struct _opl3_simd_globals {
+    int32_t enabled[OPL3SIMD_GROUP_CHIPS];
+    int32_t tremolo[OPL3SIMD_GROUP_CHIPS];
+    int32_t eg_add[OPL3SIMD_GROUP_CHIPS];
+    int32_t eg_state[OPL3SIMD_GROUP_CHIPS];
+    int32_t eg_incbits[OPL3SIMD_GROUP_CHIPS];
+    int32_t vib_on[OPL3SIMD_GROUP_CHIPS];
+    int32_t vib_shift[OPL3SIMD_GROUP_CHIPS];
+    int32_t vib_neg[OPL3SIMD_GROUP_CHIPS];
+} opl3_simd_globals;
+
+/*
+    logsin table (widened to 32 bits for vector gathers)
+*/
+
+static const int32_t opl3simd_logsin[512] = {
+    0x859, 0x6c3, 0x607, 0x58b, 0x52e, 0x4e4, 0x4a6, 0x471,
+    0x443, 0x41a, 0x3f5, 0x3d3, 0x3b5, 0x398, 0x37e, 0x365,
+    0x34e, 0x339, 0x324, 0x311, 0x2ff, 0x2ed, 0x2dc, 0x2cd,
+    0x2bd, 0x2af, 0x2a0, 0x293, 0x286, 0x279, 0x26d, 0x261,
+    0x256, 0x24b, 0x240, 0x236, 0x22c, 0x222, 0x218, 0x20f,
+    0x206, 0x1fd, 0x1f5, 0x1ec, 0x1e4, 0x1dc, 0x1d4, 0x1cd,
+    0x1c5, 0x1be, 0x1b7, 0x1b0, 0x1a9, 0x1a2, 0x19b, 0x195,
+    0x18f, 0x188, 0x182, 0x17c, 0x177, 0x171, 0x16b, 0x166,
+    0x160, 0x15b, 0x155, 0x150, 0x14b, 0x146, 0x141, 0x13c,
+    0x137, 0x133, 0x12e, 0x129, 0x125, 0x121, 0x11c, 0x118,
+    0x114, 0x10f, 0x10b, 0x107, 0x103, 0x0ff, 0x0fb, 0x0f8,
+    0x0f4, 0x0f0, 0x0ec, 0x0e9, 0x0e5, 0x0e2, 0x0de, 0x0db,
+    0x0d7, 0x0d4, 0x0d1, 0x0cd, 0x0ca, 0x0c7, 0x0c4, 0x0c1,
+    0x0be, 0x0bb, 0x0b8, 0x0b5, 0x0b2, 0x0af, 0x0ac, 0x0a9,
+    0x0a7, 0x0a4, 0x0a1, 0x09f, 0x09c, 0x099, 0x097, 0x094,
+    0x092, 0x08f, 0x08d, 0x08a, 0x088, 0x086, 0x083, 0x081,
+    0x07f, 0x07d, 0x07a, 0x078, 0x076, 0x074, 0x072, 0x070,
+    0x06e, 0x06c, 0x06a, 0x068, 0x066, 0x064, 0x062, 0x060,
+    0x05e, 0x05c, 0x05b, 0x059, 0x057, 0x055, 0x053, 0x052,
+    0x050, 0x04e, 0x04d, 0x04b, 0x04a, 0x048, 0x046, 0x045,
+    0x043, 0x042, 0x040, 0x03f, 0x03e, 0x03c, 0x03b, 0x039,
+    0x038, 0x037, 0x035, 0x034, 0x033, 0x031, 0x030, 0x02f,
+    0x02e, 0x02d, 0x02b, 0x02a, 0x029, 0x028, 0x027, 0x026,
+    0x025, 0x024, 0x023, 0x022, 0x021, 0x020, 0x01f, 0x01e,
+    0x01d, 0x01c, 0x01b, 0x01a, 0x019, 0x018, 0x017, 0x017,
+    0x016, 0x015, 0x014, 0x014, 0x013, 0x012, 0x011, 0x011,
+    0x010, 0x00f, 0x00f, 0x00e, 0x00d, 0x00d, 0x00c, 0x00c,
+    0x00b, 0x00a, 0x00a, 0x009, 0x009, 0x008, 0x008, 0x007,
+    0x007, 0x007, 0x006, 0x006, 0x005, 0x005, 0x005, 0x004,
+    0x004, 0x004, 0x003, 0x003, 0x003, 0x002, 0x002, 0x002,
+    0x002, 0x001, 0x001, 0x001, 0x001, 0x001, 0x001, 0x001,
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,
+    0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000, 0x000,
+    0x001, 0x001, 0x001, 0x001, 0x001, 0x001, 0x001, 0x002,
+    0x002, 0x002, 0x002, 0x003, 0x003, 0x003, 0x004, 0x004,
+    0x004, 0x005, 0x005, 0x005, 0x006, 0x006, 0x007, 0x007,
+    0x007, 0x008, 0x008, 0x009, 0x009, 0x00a, 0x00a, 0x00b,
+    0x00c, 0x00c, 0x00d, 0x00d, 0x00e, 0x00f, 0x00f, 0x010,
+    0x011, 0x011, 0x012, 0x013, 0x014, 0x014, 0x015, 0x016,
+    0x017, 0x017, 0x018, 0x019, 0x01a, 0x01b, 0x01c, 0x01d,
+    0x01e, 0x01f, 0x020, 0x021, 0x022, 0x023, 0x024, 0x025,
+    0x026, 0x027, 0x028, 0x029, 0x02a, 0x02b, 0x02d, 0x02e,
+    0x02f, 0x030, 0x031, 0x033, 0x034, 0x035, 0x037, 0x038,
+    0x039, 0x03b, 0x03c, 0x03e, 0x03f, 0x040, 0x042, 0x043,
+    0x045, 0x046, 0x048, 0x04a, 0x04b, 0x04d, 0x04e, 0x050,
+    0x052, 0x053, 0x055, 0x057, 0x059, 0x05b, 0x05c, 0x05e,
+    0x060, 0x062, 0x064, 0x066, 0x068, 0x06a, 0x06c, 0x06e,
+    0x070, 0x072, 0x074, 0x076, 0x078, 0x07a, 0x07d, 0x07f,
+    0x081, 0x083, 0x086, 0x088, 0x08a, 0x08d, 0x08f, 0x092,
+    0x094, 0x097, 0x099, 0x09c, 0x09f, 0x0a1, 0x0a4, 0x0a7,
+    0x0a9, 0x0ac, 0x0af, 0x0b2, 0x0b5, 0x0b8, 0x0bb, 0x0be,
+    0x0c1, 0x0c4, 0x0c7, 0x0ca, 0x0cd, 0x0d1, 0x0d4, 0x0d7,
+    0x0db, 0x0de, 0x0e2, 0x0e5, 0x0e9, 0x0ec, 0x0f0, 0x0f4,
+    0x0f8, 0x0fb, 0x0ff, 0x103, 0x107, 0x10b, 0x10f, 0x114,
+    0x118, 0x11c, 0x121, 0x125, 0x129, 0x12e, 0x133, 0x137,
+    0x13c, 0x141, 0x146, 0x14b, 0x150, 0x155, 0x15b, 0x160,
+    0x166, 0x16b, 0x171, 0x177, 0x17c, 0x182, 0x188, 0x18f,
+    0x195, 0x19b, 0x1a2, 0x1a9, 0x1b0, 0x1b7, 0x1be, 0x1c5,
+    0x1cd, 0x1d4, 0x1dc, 0x1e4, 0x1ec, 0x1f5, 0x1fd, 0x206,
+    0x20f, 0x218, 0x222, 0x22c, 0x236, 0x240, 0x24b, 0x256,
+    0x261, 0x26d, 0x279, 0x286, 0x293, 0x2a0, 0x2af, 0x2bd,
+    0x2cd, 0x2dc, 0x2ed, 0x2ff, 0x311, 0x324, 0x339, 0x34e,
+    0x365, 0x37e, 0x398, 0x3b5, 0x3d3, 0x3f5, 0x41a, 0x443,
+    0x471, 0x4a6, 0x4e4, 0x52e, 0x58b, 0x607, 0x6c3, 0x859
+};
+
+/*
+    exp table (widened to 32 bits for vector gathers)
+*/
+
+static const int32_t opl3simd_exp[256] = {
+    0xff4, 0xfea, 0xfde, 0xfd4, 0xfc8, 0xfbe, 0xfb4, 0xfa8,
+    0xf9e, 0xf92, 0xf88, 0xf7e, 0xf72, 0xf68, 0xf5c, 0xf52,
+    0xf48, 0xf3e, 0xf32, 0xf28, 0xf1e, 0xf14, 0xf08, 0xefe,
+    0xef4, 0xeea, 0xee0, 0xed4, 0xeca, 0xec0, 0xeb6, 0xeac,
+    0xea2, 0xe98, 0xe8e, 0xe84, 0xe7a, 0xe70, 0xe66, 0xe5c,
+    0xe52, 0xe48, 0xe3e, 0xe34, 0xe2a, 0xe20, 0xe16, 0xe0c,
+    0xe04, 0xdfa, 0xdf0, 0xde6, 0xddc, 0xdd2, 0xdca, 0xdc0,
+    0xdb6, 0xdac, 0xda4, 0xd9a, 0xd90, 0xd88, 0xd7e, 0xd74,
+    0xd6a, 0xd62, 0xd58, 0xd50, 0xd46, 0xd3c, 0xd34, 0xd2a,
+    0xd22, 0xd18, 0xd10, 0xd06, 0xcfe, 0xcf4, 0xcec, 0xce2,
+    0xcda, 0xcd0, 0xcc8, 0xcbe, 0xcb6, 0xcae, 0xca4, 0xc9c,
+    0xc92, 0xc8a, 0xc82, 0xc78, 0xc70, 0xc68, 0xc60, 0xc56,
+    0xc4e, 0xc46, 0xc3c, 0xc34, 0xc2c, 0xc24, 0xc1c, 0xc12,
+    0xc0a, 0xc02, 0xbfa, 0xbf2, 0xbea, 0xbe0, 0xbd8, 0xbd0,
+    0xbc8, 0xbc0, 0xbb8, 0xbb0, 0xba8, 0xba0, 0xb98, 0xb90,
+    0xb88, 0xb80, 0xb78, 0xb70, 0xb68, 0xb60, 0xb58, 0xb50,
+    0xb48, 0xb40, 0xb38, 0xb32, 0xb2a, 0xb22, 0xb1a, 0xb12,
+    0xb0a, 0xb02, 0xafc, 0xaf4, 0xaec, 0xae4, 0xade, 0xad6,
+    0xace, 0xac6, 0xac0, 0xab8, 0xab0, 0xaa8, 0xaa2, 0xa9a,
+    0xa92, 0xa8c, 0xa84, 0xa7c, 0xa76, 0xa6e, 0xa68, 0xa60,
+    0xa58, 0xa52, 0xa4a, 0xa44, 0xa3c, 0xa36, 0xa2e, 0xa28,
+    0xa20, 0xa18, 0xa12, 0xa0c, 0xa04, 0x9fe, 0x9f6, 0x9f0,
+    0x9e8, 0x9e2, 0x9da, 0x9d4, 0x9ce, 0x9c6, 0x9c0, 0x9b8,
+    0x9b2, 0x9ac, 0x9a4, 0x99e, 0x998, 0x990, 0x98a, 0x984,
+    0x97c, 0x976, 0x970, 0x96a, 0x962, 0x95c, 0x956, 0x950,
+    0x948, 0x942, 0x93c, 0x936, 0x930, 0x928, 0x922, 0x91c,
+    0x916, 0x910, 0x90a, 0x904, 0x8fc, 0x8f6, 0x8f0, 0x8ea,
+    0x8e4, 0x8de, 0x8d8, 0x8d2, 0x8cc, 0x8c6, 0x8c0, 0x8ba,
+    0x8b4, 0x8ae, 0x8a8, 0x8a2, 0x89c, 0x896, 0x890, 0x88a,
+    0x884, 0x87e, 0x878, 0x872, 0x86c, 0x866, 0x860, 0x85a,
+    0x854, 0x850, 0x84a, 0x844, 0x83e, 0x838, 0x832, 0x82c,
+    0x828, 0x822, 0x81c, 0x816, 0x810, 0x80c, 0x806, 0x800
+};
+
+/*
+    freq mult table multiplied by 2
+
+    1/2, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 10, 12, 12, 15, 15
+*/
+
+static const uint8_t mt[16] = {
+    1, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 20, 24, 24, 30, 30
+};
+
+static const uint8_t kslshift[4] = {
+    8, 1, 2, 0
+};
+
+/*
+    envelope generator constants
+*/
+
+static const uint8_t eg_incstep[4][4] = {
+    { 0, 0, 0, 0 },
+    { 1, 0, 0, 0 },
+    { 1, 0, 1, 0 },
+    { 1, 1, 1, 0 }
+};
+
+/*
+    Lane kernels
+*/
+
+typedef void (*opl3simd_prepare_func)(opl3_simd_chip *chip, const opl3_simd_globals *g);
+typedef void (*opl3simd_generate_func)(opl3_simd_chip *chip, const opl3_simd_globals *g, int32_t depth);
+typedef void (*opl3simd_group_prepare_func)(opl3_simd_group *group, const opl3_simd_globals *g);
+typedef void (*opl3simd_group_generate_func)(opl3_simd_group *group, const opl3_simd_globals *g, int32_t depth);
+
+#define OPL3SIMD_TARGET
+#define OPL3SIMD_STATE_T opl3_simd_chip
+#define OPL3SIMD_SLOTS OPL3SIMD_LANES
+#define OPL3SIMD_WIDTH 1
+#define OPL3SIMD_KERNEL(name) OPL3SIMD_##name##Generic
+#include "nukedopl3_simd_lanes.h"
+#undef OPL3SIMD_KERNEL
+#undef OPL3SIMD_STATE_T
+#undef OPL3SIMD_SLOTS
+#undef OPL3SIMD_WIDTH
+#define OPL3SIMD_STATE_T opl3_simd_group
+#define OPL3SIMD_SLOTS 36
+#define OPL3SIMD_WIDTH OPL3SIMD_GROUP_CHIPS
+#define OPL3SIMD_KERNEL(name) OPL3SIMD_Group##name##Generic
+#include "nukedopl3_simd_lanes.h"
+#undef OPL3SIMD_KERNEL
+#undef OPL3SIMD_STATE_T
+#undef OPL3SIMD_SLOTS
+#undef OPL3SIMD_WIDTH
+#undef OPL3SIMD_TARGET
+
+#ifdef OPL3SIMD_AVX2_KERNEL
+#define OPL3SIMD_TARGET __attribute__((target("avx2")))
+#define OPL3SIMD_STATE_T opl3_simd_chip
+#define OPL3SIMD_SLOTS OPL3SIMD_LANES
+#define OPL3SIMD_WIDTH 1
+#define OPL3SIMD_KERNEL(name) OPL3SIMD_##name##AVX2
+#include "nukedopl3_simd_lanes.h"
+#undef OPL3SIMD_KERNEL
+#undef OPL3SIMD_STATE_T
+#undef OPL3SIMD_SLOTS
+#undef OPL3SIMD_WIDTH
+#define OPL3SIMD_STATE_T opl3_simd_group
+#define OPL3SIMD_SLOTS 36
+#define OPL3SIMD_WIDTH OPL3SIMD_GROUP_CHIPS
+#define OPL3SIMD_KERNEL(name) OPL3SIMD_Group##name##AVX2
+#include "nukedopl3_simd_lanes.h"
+#undef OPL3SIMD_KERNEL
+#undef OPL3SIMD_STATE_T
+#undef OPL3SIMD_SLOTS
+#undef OPL3SIMD_WIDTH
+#undef OPL3SIMD_TARGET
+
+static int OPL3SIMD_HasAVX2(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}
+#endif
+
+static opl3simd_prepare_func opl3simd_prepare = NULL;
+static opl3simd_generate_func opl3simd_generate = NULL;
+static opl3simd_group_prepare_func opl3simd_group_prepare = NULL;
+static opl3simd_group_generate_func opl3simd_group_generate = NULL;
+static const char *opl3simd_kernel_name = "Generic";
+
+static void OPL3SIMD_SelectKernel(void)
+{
+    if (opl3simd_prepare)
+    {
+        return;
+    }
+#ifdef OPL3SIMD_AVX2_KERNEL
+    if (OPL3SIMD_HasAVX2())
+    {
+        opl3simd_kernel_name = "AVX2";
+        opl3simd_group_generate = OPL3SIMD_GroupGenerateAVX2;
+        opl3simd_group_prepare = OPL3SIMD_GroupPrepareAVX2;
+        opl3simd_generate = OPL3SIMD_GenerateAVX2;
+        opl3simd_prepare = OPL3SIMD_PrepareAVX2;
+        return;
+    }
+#endif
+#if defined(__AVX2__)
+    opl3simd_kernel_name = "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    opl3simd_kernel_name = "SSE2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    opl3simd_kernel_name = "NEON";
+#endif
+    opl3simd_group_generate = OPL3SIMD_GroupGenerateGeneric;
+    opl3simd_group_prepare = OPL3SIMD_GroupPrepareGeneric;
+    opl3simd_generate = OPL3SIMD_GenerateGeneric;
+    opl3simd_prepare = OPL3SIMD_PrepareGeneric;
+}
+
+const char *OPL3SIMD_KernelName(void)
+{
+    OPL3SIMD_SelectKernel();
+    return opl3simd_kernel_name;
+}
+
+/*
+    Noise generator
+*/
+
+static uint32_t OPL3SIMD_NoiseAdvance(uint32_t noise, uint32_t steps)
+{
+    uint32_t count, bits;
+
+    /* New bits don't reach the tap 14 during the first 9 steps */
+    while (steps > 0)
+    {
+        count = steps > 8 ? 8 : steps;
+        bits = (noise ^ (noise >> 14)) & ((1u << count) - 1);
+        noise = (noise >> count) | (bits << (23 - count));
+        steps -= count;
+    }
+
+    return noise;
+}
+
+static int16_t OPL3SIMD_ClipSample(int32_t sample)
+{
+    if (sample > 32767)
+    {
+        sample = 32767;
+    }
+    else if (sample < -32768)
+    {
+        sample = -32768;
+    }
+    return (int16_t)sample;
+}
+
+/*
+    Scalar parts of chips
+*/
+
+#define OPL3SIMD_STATE_T opl3_simd_chip
+#define OPL3SIMD_SLOTS OPL3SIMD_LANES
+#define OPL3SIMD_WIDTH 1
+#define OPL3SIMD_FUNC(name) OPL3SIMD_Chip##name
+#include "nukedopl3_simd_chip.h"
+#undef OPL3SIMD_FUNC
+#undef OPL3SIMD_STATE_T
+#undef OPL3SIMD_SLOTS
+#undef OPL3SIMD_WIDTH
+#define OPL3SIMD_STATE_T opl3_simd_group
+#define OPL3SIMD_SLOTS 36
+#define OPL3SIMD_WIDTH OPL3SIMD_GROUP_CHIPS
+#define OPL3SIMD_FUNC(name) OPL3SIMD_GroupChip##name
+#include "nukedopl3_simd_chip.h"
+#undef OPL3SIMD_FUNC
+#undef OPL3SIMD_STATE_T
+#undef OPL3SIMD_SLOTS
+#undef OPL3SIMD_WIDTH
+
+/*
+    Single chip
+*/
+
+void OPL3SIMD_Generate4Ch(opl3_simd_chip *chip, int16_t *buf4)
+{
+    opl3_simd_globals g;
+    int32_t depth;
+
+    OPL3SIMD_ChipBegin(chip, 0, &g, buf4);
+    if (chip->rows_dirty)
+    {
+        OPL3SIMD_ChipSyncRows(chip, 1);
+    }
+    opl3simd_prepare(chip, &g);
+    OPL3SIMD_ChipRhythm(chip, 0);
+    for (depth = 0; depth <= chip->rows_max_depth; depth++)
+    {
+        opl3simd_generate(chip, &g, depth);
+    }
+    OPL3SIMD_ChipFinish(chip, 0, buf4);
+}
+
+void OPL3SIMD_Generate(opl3_simd_chip *chip, int16_t *buf)
+{
+    int16_t samples[4];
+    OPL3SIMD_Generate4Ch(chip, samples);
+    buf[0] = samples[0];
+    buf[1] = samples[1];
+}
+
+void OPL3SIMD_Reset(opl3_simd_chip *chip, uint32_t samplerate)
+{
+    OPL3SIMD_SelectKernel();
+    memset(chip, 0, sizeof(opl3_simd_chip));
+    OPL3SIMD_ChipReset(chip, 0, samplerate);
+}
+
+void OPL3SIMD_WriteRegBuffered(opl3_simd_chip *chip, uint16_t reg, uint8_t v)
+{
+    /* A write gets applied immediately when the buffer is overflown */
+    OPL3_WriteRegBuffered(&chip->regs[0], reg, v);
+    chip->dirty[0] = 1;
+}
+
+void OPL3SIMD_WritePan(opl3_simd_chip *chip, uint16_t reg, uint8_t v)
+{
+    OPL3_WritePan(&chip->regs[0], reg, v);
+}
+
+/*
+    Group of chips
+*/
+
+void OPL3SIMD_GroupGenerate(opl3_simd_group *group, uint32_t mask, int16_t *buf)
+{
+    opl3_simd_globals g;
+    int16_t buf4[4];
+    int32_t depth;
+    uint32_t c;
+
+    memset(&g, 0, sizeof(g));
+
+    for (c = 0; c < OPL3SIMD_GROUP_CHIPS; c++)
+    {
+        buf[c * 2] = 0;
+        buf[c * 2 + 1] = 0;
+        if (mask & (1u << c))
+        {
+            OPL3SIMD_GroupChipBegin(group, c, &g, buf4);
+            buf[c * 2 + 1] = buf4[1];
+        }
+    }
+
+    /* Depth lists only cover enabled chips, so rebuild them when the mask changes */
+    if (group->rows_dirty || group->rows_mask != mask)
+    {
+        OPL3SIMD_GroupChipSyncRows(group, mask);
+    }
+
+    if (group->rows_max_depth < 0)
+    {
+        return;
+    }
+
+    opl3simd_group_prepare(group, &g);
+    for (c = 0; c < OPL3SIMD_GROUP_CHIPS; c++)
+    {
+        if (mask & (1u << c))
+        {
+            OPL3SIMD_GroupChipRhythm(group, c);
+        }
+    }
+    for (depth = 0; depth <= group->rows_max_depth; depth++)
+    {
+        opl3simd_group_generate(group, &g, depth);
+    }
+    for (c = 0; c < OPL3SIMD_GROUP_CHIPS; c++)
+    {
+        if (mask & (1u << c))
+        {
+            OPL3SIMD_GroupChipFinish(group, c, buf4);
+            buf[c * 2] = buf4[0];
+        }
+    }
+}
+
+void OPL3SIMD_GroupInit(opl3_simd_group *group, uint32_t samplerate)
+{
+    uint32_t c;
+
+    OPL3SIMD_SelectKernel();
+    memset(group, 0, sizeof(opl3_simd_group));
+    for (c = 0; c < OPL3SIMD_GROUP_CHIPS; c++)
+    {
+        OPL3SIMD_GroupChipReset(group, c, samplerate);
+    }
+}
+
+void OPL3SIMD_GroupReset(opl3_simd_group *group, uint32_t chip, uint32_t samplerate)
+{
+    OPL3SIMD_GroupChipReset(group, chip, samplerate);
+}
+
+void OPL3SIMD_GroupWriteRegBuffered(opl3_simd_group *group, uint32_t chip, uint16_t reg, uint8_t v)
+{
+    OPL3_WriteRegBuffered(&group->regs[chip], reg, v);
+    group->dirty[chip] = 1;
+}
+
+void OPL3SIMD_GroupWritePan(opl3_simd_group *group, uint32_t chip, uint16_t reg, uint8_t v)
+{
+    OPL3_WritePan(&group->regs[chip], reg, v);
+}
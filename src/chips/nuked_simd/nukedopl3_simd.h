@@ -0,0 +1,138 @@
+/* Nuked OPL3
+ * Copyright (C) 2013-2020 Nuke.YKT
+ *
+ * This file is part of Nuked OPL3.
+ *
+ * Nuked OPL3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * Nuked OPL3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuked OPL3. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Nuked OPL3 emulator, structure-of-arrays variant.
+ *
+ *  Register decoding, timers and the write buffer are shared with the
+ *  original core (nuked/nukedopl3.c), slot parameters get copied into
+ *  lane arrays after every register change, and the envelope, phase and
+ *  waveform of all slots are computed by lane loops that are compiled for
+ *  the vector units (SSE2, AVX2 or NEON). The output is bit-exact with
+ *  the original core.
+ *
+ *  The group keeps the state of several chips interleaved by slots and
+ *  advances all of them in lock-step, one vector lane per chip.
+ *
+ * version: 1.8
+ */
+
+#ifndef OPL_OPL3_SIMD_H
+#define OPL_OPL3_SIMD_H
+
+#include "../nuked/nukedopl3.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Count of slot lanes of the single chip: 36 slots padded to the multiple of 8 */
+#define OPL3SIMD_LANES      40
+
+/* Count of chips of the group, every slot of them gets computed by one vector */
+#define OPL3SIMD_GROUP_CHIPS    8
+#define OPL3SIMD_GROUP_LANES    (36 * OPL3SIMD_GROUP_CHIPS)
+
+/* Count of lanes in rows of the waveform generator */
+#define OPL3SIMD_ROW            8
+/* Depths of modulation chains: 4-operator channels have the longest chains */
+#define OPL3SIMD_DEPTHS         4
+
+/* Offsets of signals in the sig array of n lanes */
+#define OPL3SIMD_SIG_OUT(n)     0
+#define OPL3SIMD_SIG_FBMOD(n)   (n)
+#define OPL3SIMD_SIG_PROUT(n)   ((n) * 2)
+#define OPL3SIMD_SIG_ZERO(n)    ((n) * 3)
+#define OPL3SIMD_SIG_SIZE(n)    ((n) * 3 + 8)
+
+/*
+ *  State of chips which are computed together, the slot s of the chip c
+ *  is kept at the lane s * chips + c of every lane array.
+ */
+#define OPL3SIMD_STATE(chips, lanes) \
+    /* Register files, global timers and write buffers */ \
+    opl3_chip regs[chips]; \
+    uint8_t dirty[chips]; \
+    /* Rows having slots at every depth, built for chips of rows_mask */ \
+    uint8_t rows_dirty; \
+    uint32_t rows_mask; \
+    int32_t rows_max_depth; \
+    uint8_t depth_rows[OPL3SIMD_DEPTHS][(lanes) / OPL3SIMD_ROW]; \
+    uint8_t depth_row_count[OPL3SIMD_DEPTHS]; \
+    /* Slot parameters, decoded from register files */ \
+    int32_t eg_base[lanes]; \
+    int32_t trem[lanes]; \
+    int32_t key[lanes]; \
+    int32_t rate_ar[lanes]; \
+    int32_t rate_dr[lanes]; \
+    int32_t rate_sr[lanes]; \
+    int32_t rate_rr[lanes]; \
+    int32_t sl[lanes]; \
+    int32_t ks[lanes]; \
+    int32_t vib[lanes]; \
+    int32_t f_num[lanes]; \
+    int32_t block[lanes]; \
+    int32_t mult[lanes]; \
+    int32_t fb_shift[lanes]; \
+    int32_t fb_on[lanes]; \
+    int32_t maskzero[lanes]; \
+    int32_t signpos[lanes]; \
+    int32_t phaseshift[lanes]; \
+    int32_t mod[lanes]; \
+    int32_t depth[lanes]; \
+    /* Channel outputs: indices in the sig array as seen by left and right mixers */ \
+    int32_t ch_left[chips][18][4]; \
+    int32_t ch_right[chips][18][4]; \
+    /* Slot state */ \
+    int32_t eg_rout[lanes]; \
+    int32_t eg_gen[lanes]; \
+    int32_t eg_out[lanes]; \
+    int32_t pg_reset[lanes]; \
+    uint32_t pg_phase[lanes]; \
+    int32_t pg_phase_out[lanes]; \
+    int32_t sig[OPL3SIMD_SIG_SIZE(lanes)];
+
+typedef struct _opl3_simd_chip opl3_simd_chip;
+typedef struct _opl3_simd_group opl3_simd_group;
+
+struct _opl3_simd_chip {
+    OPL3SIMD_STATE(1, OPL3SIMD_LANES)
+};
+
+struct _opl3_simd_group {
+    OPL3SIMD_STATE(OPL3SIMD_GROUP_CHIPS, OPL3SIMD_GROUP_LANES)
+};
+
+void OPL3SIMD_Reset(opl3_simd_chip *chip, uint32_t samplerate);
+void OPL3SIMD_WriteRegBuffered(opl3_simd_chip *chip, uint16_t reg, uint8_t v);
+void OPL3SIMD_WritePan(opl3_simd_chip *chip, uint16_t reg, uint8_t v);
+void OPL3SIMD_Generate(opl3_simd_chip *chip, int16_t *buf);
+void OPL3SIMD_Generate4Ch(opl3_simd_chip *chip, int16_t *buf4);
+
+void OPL3SIMD_GroupInit(opl3_simd_group *group, uint32_t samplerate);
+void OPL3SIMD_GroupReset(opl3_simd_group *group, uint32_t chip, uint32_t samplerate);
+void OPL3SIMD_GroupWriteRegBuffered(opl3_simd_group *group, uint32_t chip, uint16_t reg, uint8_t v);
+void OPL3SIMD_GroupWritePan(opl3_simd_group *group, uint32_t chip, uint16_t reg, uint8_t v);
+/* Generates the frame of chips set in the mask, buf receives stereo frames of all chips */
+void OPL3SIMD_GroupGenerate(opl3_simd_group *group, uint32_t mask, int16_t *buf);
+const char *OPL3SIMD_KernelName(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,401 @@
+/* Nuked OPL3
+ * Copyright (C) 2013-2020 Nuke.YKT
+ *
+ * This file is part of Nuked OPL3.
+ *
+ * Nuked OPL3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * Nuked OPL3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuked OPL3. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Scalar parts of the structure-of-arrays Nuked OPL3: slot parameters,
+ *  rhythm, mixing and timers of one chip of the state.
+ *
+ *  This file gets included by nukedopl3_simd.c once per state layout:
+ *  OPL3SIMD_FUNC(name) gives the function name, OPL3SIMD_STATE_T is the
+ *  type of the state, it has OPL3SIMD_SLOTS rows of OPL3SIMD_WIDTH chips.
+ */
+
+#define OPL3SIMD_LANES_N (OPL3SIMD_SLOTS * OPL3SIMD_WIDTH)
+#define OPL3SIMD_LANE(slot, c) ((slot) * OPL3SIMD_WIDTH + (c))
+
+/*
+    Slot parameters
+*/
+
+static int32_t OPL3SIMD_FUNC(SignalIndex)(OPL3SIMD_STATE_T *chip, uint32_t c, const int16_t *signal, uint8_t slot_num)
+{
+    const opl3_chip *regs = &chip->regs[c];
+    uint32_t src;
+
+    if (signal == &regs->zeromod)
+    {
+        return OPL3SIMD_SIG_ZERO(OPL3SIMD_LANES_N);
+    }
+
+    src = (uint32_t)(((const char *)signal - (const char *)regs->slot) / sizeof(opl3_slot));
+    if (signal == &regs->slot[src].fbmod)
+    {
+        return OPL3SIMD_SIG_FBMOD(OPL3SIMD_LANES_N) + OPL3SIMD_LANE(src, c);
+    }
+
+    /* Outputs of slots which are processed later within a sample are taken from the previous sample */
+    if (src < slot_num)
+    {
+        return OPL3SIMD_SIG_OUT(OPL3SIMD_LANES_N) + OPL3SIMD_LANE(src, c);
+    }
+    return OPL3SIMD_SIG_PROUT(OPL3SIMD_LANES_N) + OPL3SIMD_LANE(src, c);
+}
+
+static int32_t OPL3SIMD_FUNC(MixIndex)(OPL3SIMD_STATE_T *chip, uint32_t c, const int16_t *signal, uint8_t processed)
+{
+    const opl3_chip *regs = &chip->regs[c];
+    uint32_t src;
+
+    if (signal == &regs->zeromod)
+    {
+        return OPL3SIMD_SIG_ZERO(OPL3SIMD_LANES_N);
+    }
+
+    src = (uint32_t)(((const char *)signal - (const char *)regs->slot) / sizeof(opl3_slot));
+    if (src < processed)
+    {
+        return OPL3SIMD_SIG_OUT(OPL3SIMD_LANES_N) + OPL3SIMD_LANE(src, c);
+    }
+    return OPL3SIMD_SIG_PROUT(OPL3SIMD_LANES_N) + OPL3SIMD_LANE(src, c);
+}
+
+static void OPL3SIMD_FUNC(SyncParams)(OPL3SIMD_STATE_T *chip, uint32_t c)
+{
+    opl3_chip *regs = &chip->regs[c];
+    opl3_slot *slot;
+    opl3_channel *channel;
+    int32_t src, lane;
+    uint8_t ii, jj;
+
+    for (ii = 0; ii < 36; ii++)
+    {
+        slot = &regs->slot[ii];
+        channel = slot->channel;
+        lane = OPL3SIMD_LANE(ii, c);
+        chip->eg_base[lane] = (slot->reg_tl << 2) + (slot->eg_ksl >> kslshift[slot->reg_ksl]);
+        chip->trem[lane] = (slot->trem == &regs->tremolo) ? -1 : 0;
+        chip->key[lane] = slot->key != 0;
+        chip->rate_ar[lane] = slot->reg_ar;
+        chip->rate_dr[lane] = slot->reg_dr;
+        chip->rate_sr[lane] = slot->reg_type ? 0 : slot->reg_rr;
+        chip->rate_rr[lane] = slot->reg_rr;
+        chip->sl[lane] = slot->reg_sl;
+        chip->ks[lane] = channel->ksv >> ((slot->reg_ksr ^ 1) << 1);
+        chip->vib[lane] = slot->reg_vib ? -1 : 0;
+        chip->f_num[lane] = channel->f_num;
+        chip->block[lane] = channel->block;
+        chip->mult[lane] = mt[slot->reg_mult];
+        chip->fb_shift[lane] = channel->fb ? 0x09 - channel->fb : 0;
+        chip->fb_on[lane] = channel->fb ? -1 : 0;
+        chip->maskzero[lane] = slot->maskzero;
+        chip->signpos[lane] = slot->signpos;
+        chip->phaseshift[lane] = slot->phaseshift;
+
+        src = OPL3SIMD_FUNC(SignalIndex)(chip, c, slot->mod, ii);
+        chip->mod[lane] = src;
+        chip->depth[lane] = (src < OPL3SIMD_SIG_FBMOD(OPL3SIMD_LANES_N)) ? chip->depth[src] + 1 : 0;
+    }
+
+    for (ii = 0; ii < 18; ii++)
+    {
+        channel = &regs->channel[ii];
+        for (jj = 0; jj < 4; jj++)
+        {
+#if OPL_QUIRK_CHANNELSAMPLEDELAY
+            chip->ch_left[c][ii][jj] = OPL3SIMD_FUNC(MixIndex)(chip, c, channel->out[jj], 15);
+            chip->ch_right[c][ii][jj] = OPL3SIMD_FUNC(MixIndex)(chip, c, channel->out[jj], 33);
+#else
+            chip->ch_left[c][ii][jj] = OPL3SIMD_FUNC(MixIndex)(chip, c, channel->out[jj], 36);
+            chip->ch_right[c][ii][jj] = chip->ch_left[c][ii][jj];
+#endif
+        }
+    }
+
+    chip->dirty[c] = 0;
+    chip->rows_dirty = 1;
+}
+
+/*
+    Lists rows of the waveform generator per depth, for chips of the mask
+*/
+
+static void OPL3SIMD_FUNC(SyncRows)(OPL3SIMD_STATE_T *chip, uint32_t mask)
+{
+    int32_t lane, row, depth, max_depth = -1;
+    uint32_t depths;
+
+    memset(chip->depth_row_count, 0, sizeof(chip->depth_row_count));
+
+    for (row = 0; row < OPL3SIMD_LANES_N / OPL3SIMD_ROW; row++)
+    {
+        depths = 0;
+        for (lane = row * OPL3SIMD_ROW; lane < (row + 1) * OPL3SIMD_ROW; lane++)
+        {
+            if (mask & (1u << (lane % OPL3SIMD_WIDTH)))
+            {
+                depths |= 1u << chip->depth[lane];
+            }
+        }
+
+        for (depth = 0; depth < OPL3SIMD_DEPTHS; depth++)
+        {
+            if (depths & (1u << depth))
+            {
+                chip->depth_rows[depth][chip->depth_row_count[depth]++] = (uint8_t)row;
+                max_depth = depth > max_depth ? depth : max_depth;
+            }
+        }
+    }
+
+    chip->rows_dirty = 0;
+    chip->rows_mask = mask;
+    chip->rows_max_depth = max_depth;
+}
+
+/*
+    Rhythm
+*/
+
+static void OPL3SIMD_FUNC(Rhythm)(OPL3SIMD_STATE_T *chip, uint32_t c)
+{
+    opl3_chip *regs = &chip->regs[c];
+    int32_t *phase_hh = &chip->pg_phase_out[OPL3SIMD_LANE(13, c)];
+    int32_t *phase_sd = &chip->pg_phase_out[OPL3SIMD_LANE(16, c)];
+    int32_t *phase_tc = &chip->pg_phase_out[OPL3SIMD_LANE(17, c)];
+    uint32_t noise = regs->noise;
+    uint32_t phase;
+    uint8_t rm_xor;
+
+    /* hh */
+    noise = OPL3SIMD_NoiseAdvance(noise, 13);
+    phase = (uint32_t)*phase_hh;
+    regs->rm_hh_bit2 = (phase >> 2) & 1;
+    regs->rm_hh_bit3 = (phase >> 3) & 1;
+    regs->rm_hh_bit7 = (phase >> 7) & 1;
+    regs->rm_hh_bit8 = (phase >> 8) & 1;
+    if (regs->rhy & 0x20)
+    {
+        rm_xor = (regs->rm_hh_bit2 ^ regs->rm_hh_bit7)
+               | (regs->rm_hh_bit3 ^ regs->rm_tc_bit5)
+               | (regs->rm_tc_bit3 ^ regs->rm_tc_bit5);
+        *phase_hh = rm_xor << 9;
+        if (rm_xor ^ (noise & 1))
+        {
+            *phase_hh |= 0xd0;
+        }
+        else
+        {
+            *phase_hh |= 0x34;
+        }
+    }
+
+    /* sd */
+    noise = OPL3SIMD_NoiseAdvance(noise, 3);
+    if (regs->rhy & 0x20)
+    {
+        *phase_sd = (regs->rm_hh_bit8 << 9)
+                  | ((regs->rm_hh_bit8 ^ (noise & 1)) << 8);
+    }
+
+    /* tc */
+    if (regs->rhy & 0x20)
+    {
+        phase = (uint32_t)*phase_tc;
+        regs->rm_tc_bit3 = (phase >> 3) & 1;
+        regs->rm_tc_bit5 = (phase >> 5) & 1;
+        rm_xor = (regs->rm_hh_bit2 ^ regs->rm_hh_bit7)
+               | (regs->rm_hh_bit3 ^ regs->rm_tc_bit5)
+               | (regs->rm_tc_bit3 ^ regs->rm_tc_bit5);
+        *phase_tc = (rm_xor << 9) | 0x80;
+    }
+
+    regs->noise = OPL3SIMD_NoiseAdvance(noise, 20);
+}
+
+/*
+    Sample start: outputs the right side mixed by the previous sample
+    and sets chip-wide values of the lane kernels
+*/
+
+static void OPL3SIMD_FUNC(Begin)(OPL3SIMD_STATE_T *chip, uint32_t c, opl3_simd_globals *g, int16_t *buf4)
+{
+    opl3_chip *regs = &chip->regs[c];
+    uint8_t ii;
+
+    buf4[1] = OPL3SIMD_ClipSample(regs->mixbuff[1]);
+    buf4[3] = OPL3SIMD_ClipSample(regs->mixbuff[3]);
+
+    if (chip->dirty[c])
+    {
+        OPL3SIMD_FUNC(SyncParams)(chip, c);
+    }
+
+    g->enabled[c] = -1;
+    g->tremolo[c] = regs->tremolo;
+    g->eg_add[c] = regs->eg_add;
+    g->eg_state[c] = regs->eg_state;
+    g->eg_incbits[c] = 0;
+    for (ii = 0; ii < 4; ii++)
+    {
+        g->eg_incbits[c] |= eg_incstep[ii][regs->eg_timer_lo] << ii;
+    }
+    g->vib_on[c] = (regs->vibpos & 3) ? -1 : 0;
+    g->vib_shift[c] = (regs->vibpos & 1) + regs->vibshift;
+    g->vib_neg[c] = (regs->vibpos & 4) ? -1 : 0;
+}
+
+/*
+    Sample end: mixes channels and advances timers
+*/
+
+static void OPL3SIMD_FUNC(Finish)(OPL3SIMD_STATE_T *chip, uint32_t c, int16_t *buf4)
+{
+    opl3_chip *regs = &chip->regs[c];
+    opl3_channel *channel;
+    opl3_writebuf *writebuf;
+    const int32_t *idx;
+    int32_t mix[2];
+    uint8_t ii;
+    int16_t accm;
+    uint8_t shift = 0;
+
+    mix[0] = mix[1] = 0;
+    for (ii = 0; ii < 18; ii++)
+    {
+        channel = &regs->channel[ii];
+        idx = chip->ch_left[c][ii];
+        accm = (int16_t)(chip->sig[idx[0]] + chip->sig[idx[1]] + chip->sig[idx[2]] + chip->sig[idx[3]]);
+        mix[0] += (int16_t)((accm * channel->chl / 65535) & channel->cha);
+        mix[1] += (int16_t)(accm & channel->chc);
+    }
+    regs->mixbuff[0] = mix[0];
+    regs->mixbuff[2] = mix[1];
+
+    buf4[0] = OPL3SIMD_ClipSample(regs->mixbuff[0]);
+    buf4[2] = OPL3SIMD_ClipSample(regs->mixbuff[2]);
+
+    mix[0] = mix[1] = 0;
+    for (ii = 0; ii < 18; ii++)
+    {
+        channel = &regs->channel[ii];
+        idx = chip->ch_right[c][ii];
+        accm = (int16_t)(chip->sig[idx[0]] + chip->sig[idx[1]] + chip->sig[idx[2]] + chip->sig[idx[3]]);
+        mix[0] += (int16_t)((accm * channel->chr / 65535) & channel->chb);
+        mix[1] += (int16_t)(accm & channel->chd);
+    }
+    regs->mixbuff[1] = mix[0];
+    regs->mixbuff[3] = mix[1];
+
+    if ((regs->timer & 0x3f) == 0x3f)
+    {
+        regs->tremolopos = (regs->tremolopos + 1) % 210;
+    }
+    if (regs->tremolopos < 105)
+    {
+        regs->tremolo = regs->tremolopos >> regs->tremoloshift;
+    }
+    else
+    {
+        regs->tremolo = (210 - regs->tremolopos) >> regs->tremoloshift;
+    }
+
+    if ((regs->timer & 0x3ff) == 0x3ff)
+    {
+        regs->vibpos = (regs->vibpos + 1) & 7;
+    }
+
+    regs->timer++;
+
+    if (regs->eg_state)
+    {
+        while (shift < 13 && ((regs->eg_timer >> shift) & 1) == 0)
+        {
+            shift++;
+        }
+        if (shift > 12)
+        {
+            regs->eg_add = 0;
+        }
+        else
+        {
+            regs->eg_add = shift + 1;
+        }
+        regs->eg_timer_lo = (uint8_t)(regs->eg_timer & 0x3u);
+    }
+
+    if (regs->eg_timerrem || regs->eg_state)
+    {
+        if (regs->eg_timer == UINT64_C(0xfffffffff))
+        {
+            regs->eg_timer = 0;
+            regs->eg_timerrem = 1;
+        }
+        else
+        {
+            regs->eg_timer++;
+            regs->eg_timerrem = 0;
+        }
+    }
+
+    regs->eg_state ^= 1;
+
+    while ((writebuf = &regs->writebuf[regs->writebuf_cur]), writebuf->time <= regs->writebuf_samplecnt)
+    {
+        if (!(writebuf->reg & 0x200))
+        {
+            break;
+        }
+        writebuf->reg &= 0x1ff;
+        OPL3_WriteReg(regs, writebuf->reg, writebuf->data);
+        regs->writebuf_cur = (regs->writebuf_cur + 1) % OPL_WRITEBUF_SIZE;
+        chip->dirty[c] = 1;
+    }
+    regs->writebuf_samplecnt++;
+}
+
+/*
+    Reset of one chip of the state
+*/
+
+static void OPL3SIMD_FUNC(Reset)(OPL3SIMD_STATE_T *chip, uint32_t c, uint32_t samplerate)
+{
+    int32_t lane;
+    uint8_t ii;
+
+    memset(&chip->regs[c], 0, sizeof(opl3_chip));
+    OPL3_Reset(&chip->regs[c], samplerate);
+
+    for (ii = 0; ii < OPL3SIMD_SLOTS; ii++)
+    {
+        lane = OPL3SIMD_LANE(ii, c);
+        chip->eg_rout[lane] = 0x1ff;
+        chip->eg_out[lane] = 0x1ff << 3;
+        chip->eg_gen[lane] = envelope_gen_num_release;
+        chip->pg_phase[lane] = 0;
+        chip->mod[lane] = OPL3SIMD_SIG_ZERO(OPL3SIMD_LANES_N);
+        chip->depth[lane] = 0;
+        chip->sig[OPL3SIMD_SIG_OUT(OPL3SIMD_LANES_N) + lane] = 0;
+        chip->sig[OPL3SIMD_SIG_FBMOD(OPL3SIMD_LANES_N) + lane] = 0;
+        chip->sig[OPL3SIMD_SIG_PROUT(OPL3SIMD_LANES_N) + lane] = 0;
+    }
+
+    chip->dirty[c] = 1;
+    chip->rows_dirty = 1;
+}
+
+#undef OPL3SIMD_LANE
+#undef OPL3SIMD_LANES_N
@@ -0,0 +1,207 @@
+/* Nuked OPL3
+ * Copyright (C) 2013-2020 Nuke.YKT
+ *
+ * This file is part of Nuked OPL3.
+ *
+ * Nuked OPL3 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * Nuked OPL3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Nuked OPL3. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Lane kernels of the structure-of-arrays Nuked OPL3.
+ *
+ *  This file gets included by nukedopl3_simd.c once per instruction set
+ *  and state layout: OPL3SIMD_KERNEL(name) gives the function name,
+ *  OPL3SIMD_TARGET gives the target attribute, OPL3SIMD_STATE_T is the type
+ *  of the state, it has OPL3SIMD_SLOTS rows of OPL3SIMD_WIDTH chips. Loops
+ *  have no branches and no dependencies between lanes, so compilers turn
+ *  every lane loop into vector code.
+ */
+
+#define OPL3SIMD_LANES_N (OPL3SIMD_SLOTS * OPL3SIMD_WIDTH)
+
+/*
+    Feedback, envelope and phase generators of all slots
+*/
+
+static OPL3SIMD_TARGET void OPL3SIMD_KERNEL(Prepare)(OPL3SIMD_STATE_T *chip, const opl3_simd_globals *globals)
+{
+    opl3_simd_globals g_copy;
+    const opl3_simd_globals *g = &g_copy;
+    int32_t s, c, i;
+
+    /* The local copy can't alias the state, so compilers don't need checks for it */
+    g_copy = *globals;
+
+    /* Feedback: uses the last two outputs of the slot */
+    for (s = 0; s < OPL3SIMD_SLOTS; s++)
+    {
+        for (c = 0; c < OPL3SIMD_WIDTH; c++)
+        {
+            int32_t out, prout;
+            i = s * OPL3SIMD_WIDTH + c;
+            out = chip->sig[OPL3SIMD_SIG_OUT(OPL3SIMD_LANES_N) + i];
+            prout = chip->sig[OPL3SIMD_SIG_PROUT(OPL3SIMD_LANES_N) + i];
+            chip->sig[OPL3SIMD_SIG_FBMOD(OPL3SIMD_LANES_N) + i] = ((prout + out) >> chip->fb_shift[i]) & chip->fb_on[i];
+            chip->sig[OPL3SIMD_SIG_PROUT(OPL3SIMD_LANES_N) + i] = (out & g->enabled[c]) | (prout & ~g->enabled[c]);
+        }
+    }
+
+    /*
+     * Envelope generator: conditions are turned into masks of all ones or
+     * all zeros, so the loop has no selects that compilers could branch on
+     */
+    for (s = 0; s < OPL3SIMD_SLOTS; s++)
+    {
+        for (c = 0; c < OPL3SIMD_WIDTH; c++)
+        {
+            int32_t rout, gen, key, attack, decay, sustain, release, sustained, eg_off, enabled;
+            int32_t level, reset, reg_rate, rate, rate_hi, rate_lo, rate_max, eg_shift;
+            int32_t shift_lo, shift_hi, shift, inc_attack, inc_decay, inc, new_rout, new_gen;
+
+            i = s * OPL3SIMD_WIDTH + c;
+            rout = chip->eg_rout[i];
+            gen = chip->eg_gen[i];
+            key = -chip->key[i];
+            attack = -(gen == envelope_gen_num_attack);
+            decay = -(gen == envelope_gen_num_decay);
+            sustain = -(gen == envelope_gen_num_sustain);
+            release = -(gen == envelope_gen_num_release);
+            sustained = -((rout >> 4) == chip->sl[i]);
+            eg_off = -((rout & 0x1f8) == 0x1f8);
+            enabled = g->enabled[c];
+
+            level = rout + chip->eg_base[i] + (chip->trem[i] & g->tremolo[c]);
+            level = level > 0x1ff ? 0x1ff : level;
+            chip->eg_out[i] = level << 3;
+
+            reset = release & key;
+            chip->pg_reset[i] = reset;
+            reg_rate = (chip->rate_ar[i] & (attack | reset))
+                     | (chip->rate_dr[i] & decay)
+                     | (chip->rate_sr[i] & sustain)
+                     | (chip->rate_rr[i] & release & ~reset);
+
+            rate = chip->ks[i] + (reg_rate << 2);
+            rate_hi = rate >> 2;
+            rate_lo = rate & 0x03;
+            rate_max = -((rate_hi >> 4) & 0x01);
+            rate_hi = (rate_hi & ~rate_max) | (0x0f & rate_max);
+            rate_max = -(rate_hi == 0x0f);
+            eg_shift = rate_hi + g->eg_add[c];
+
+            shift_lo = (-(eg_shift == 12))
+                     | (((rate_lo >> 1) & 0x01) & -(eg_shift == 13))
+                     | ((rate_lo & 0x01) & -(eg_shift == 14));
+            shift_lo &= -g->eg_state[c] & 0x01;
+            shift_hi = (rate_hi & 0x03) + ((g->eg_incbits[c] >> rate_lo) & 0x01);
+            shift_hi -= shift_hi >> 2;
+            shift_hi |= g->eg_state[c] & -(shift_hi == 0);
+            shift = (shift_lo & -(rate_hi < 12)) | (shift_hi & -(rate_hi >= 12));
+            shift &= -(reg_rate != 0);
+
+            new_rout = rout & ~(reset & rate_max);
+            new_rout |= 0x1ff & eg_off & ~attack & ~reset;
+
+            inc_attack = (~rout >> ((4 - shift) & 0x07)) & key & ~rate_max & -(rout != 0);
+            inc_decay = (1 << ((shift - 1) & 0x03)) & ~eg_off & ~reset;
+            inc = (inc_attack & attack) | (inc_decay & ~attack & ~(decay & sustained));
+            inc &= -(shift > 0);
+
+            new_gen = gen + (0x01 & ((attack & -(rout == 0)) | (decay & sustained)));
+            new_gen &= ~reset;
+            new_gen |= envelope_gen_num_release & ~key;
+
+            chip->eg_rout[i] = (((new_rout + inc) & 0x1ff) & enabled) | (rout & ~enabled);
+            chip->eg_gen[i] = (new_gen & enabled) | (gen & ~enabled);
+        }
+    }
+
+    /* Phase generator, rhythm phases get patched later */
+    for (s = 0; s < OPL3SIMD_SLOTS; s++)
+    {
+        for (c = 0; c < OPL3SIMD_WIDTH; c++)
+        {
+            int32_t f_num, range;
+            uint32_t basefreq, phase, new_phase;
+
+            i = s * OPL3SIMD_WIDTH + c;
+            f_num = chip->f_num[i];
+            range = ((f_num >> 7) & 0x07) >> g->vib_shift[c];
+            range = (range ^ g->vib_neg[c]) - g->vib_neg[c];
+            f_num += range & g->vib_on[c] & chip->vib[i];
+            basefreq = ((uint32_t)f_num << chip->block[i]) >> 1;
+            phase = chip->pg_phase[i];
+            chip->pg_phase_out[i] = (int32_t)((phase >> 9) & 0xffff);
+            new_phase = (phase & ~(uint32_t)chip->pg_reset[i]) + ((basefreq * (uint32_t)chip->mult[i]) >> 1);
+            chip->pg_phase[i] = (new_phase & (uint32_t)g->enabled[c]) | (phase & ~(uint32_t)g->enabled[c]);
+        }
+    }
+}
+
+/*
+    Waveform generator of slots at the given depth of the modulation chain,
+    only rows which have such slots are computed
+*/
+
+static OPL3SIMD_TARGET void OPL3SIMD_KERNEL(Generate)(OPL3SIMD_STATE_T *chip, const opl3_simd_globals *globals, int32_t depth)
+{
+    const uint8_t *rows = chip->depth_rows[depth];
+    const int32_t count = chip->depth_row_count[depth];
+    int32_t enabled[OPL3SIMD_ROW];
+    int32_t modval[OPL3SIMD_ROW];
+    int32_t out[OPL3SIMD_ROW];
+    int32_t r, k, i;
+
+    /* Rows start at multiples of OPL3SIMD_ROW, so every row has the same order of chips */
+    for (k = 0; k < OPL3SIMD_ROW; k++)
+    {
+        enabled[k] = globals->enabled[k % OPL3SIMD_WIDTH];
+    }
+
+    for (r = 0; r < count; r++)
+    {
+        const int32_t base = rows[r] * OPL3SIMD_ROW;
+
+        for (k = 0; k < OPL3SIMD_ROW; k++)
+        {
+            modval[k] = chip->sig[chip->mod[base + k]];
+        }
+
+        for (k = 0; k < OPL3SIMD_ROW; k++)
+        {
+            int32_t phase, neg, phaseshift, shifted, level, sine, other;
+
+            i = base + k;
+            phase = (chip->pg_phase_out[i] + modval[k]) & 0xffff;
+            neg = (int32_t)((uint32_t)phase << chip->signpos[i]) >> 31;
+            phaseshift = chip->phaseshift[i];
+
+            /* Shifts are done modulo 32 as the scalar core does on x86 and AArch64 */
+            shifted = (phase << (phaseshift & 31)) & 0xffff;
+            sine = opl3simd_logsin[shifted & 0x1ff];
+            other = ((shifted ^ neg) & 0x3ff) << 3;
+            level = chip->eg_out[i] + (phaseshift <= 1 ? sine : other);
+            out[k] = (opl3simd_exp[level & 0xff] >> ((level >> 8) & 31)) ^ neg;
+            out[k] = (phase & chip->maskzero[i]) ? 0 : out[k];
+        }
+
+        for (k = 0; k < OPL3SIMD_ROW; k++)
+        {
+            int32_t update;
+            i = base + k;
+            update = -(chip->depth[i] == depth) & enabled[k];
+            chip->sig[OPL3SIMD_SIG_OUT(OPL3SIMD_LANES_N) + i] = (out[k] & update) | (chip->sig[OPL3SIMD_SIG_OUT(OPL3SIMD_LANES_N) + i] & ~update);
+        }
+    }
+}
+
+#undef OPL3SIMD_LANES_N
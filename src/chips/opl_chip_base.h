@@ -68,19 +68,61 @@ public:
     virtual uint32_t effectiveRate() const = 0;
     virtual void reset() = 0;
     virtual void writeReg(uint16_t addr, uint8_t data) = 0;
+    /**
+     * @brief Write several registers in the given order
+     * @param addr Register addresses
+     * @param data Values to write
+     * @param n Count of registers to write
+     */
+    virtual void writeRegs(const uint16_t *addr, const uint8_t *data, size_t n) = 0;
 
     // extended
     virtual void writePan(uint16_t addr, uint8_t data) { (void)addr; (void)data; }
+    /**
+     * @brief Advance the state of the silent chip whose emulation was skipped,
+     * so it stays the same as if the chip had been emulated
+     * @param frames Count of skipped frames at the native rate
+     */
+    virtual void nativeSkip(uint64_t frames) { (void)frames; }
+    /**
+     * @brief Are envelopes of all operators at the total attenuation, so the chip outputs
+     * the exact silence until the next register write, and nativeSkip() can replace its emulation?
+     * @return true if the chip is proven to be silent, false if unknown
+     */
+    virtual bool envelopesFinished() const { return false; }
+    /**
+     * @brief Is the output proven to stay silent until the next register write, including the resampler?
+     * @param native Chip gets rendered at its native rate without the resampler
+     * @return true if the chip may be skipped without changing the output
+     */
+    virtual bool outputFinished(bool native) const = 0;
 
     virtual void nativePreGenerate() = 0;
     virtual void nativePostGenerate() = 0;
     virtual void nativeGenerate(int16_t *frame) = 0;
+    /**
+     * @brief Generate the block of frames at the native rate of the emulator
+     * @param output Output buffer of interleaved stereo frames
+     * @param frames Count of frames to generate
+     */
+    virtual void nativeGenerateBlock(int16_t *output, size_t frames) = 0;
     virtual void resampledGenerate(int32_t *frame) = 0;
+    /**
+     * @brief Skip frames at the output rate of the silent chip instead of generating them
+     * @param frames Count of frames to skip
+     */
+    virtual void resampledSkip(uint64_t frames) = 0;
 
     virtual void generate(int16_t *output, size_t frames) = 0;
     virtual void generateAndMix(int16_t *output, size_t frames) = 0;
     virtual void generate32(int32_t *output, size_t frames) = 0;
     virtual void generateAndMix32(int32_t *output, size_t frames) = 0;
+    /**
+     * @brief Generate frames at the effective rate without resampling and mix them into the output
+     * @param output Output buffer of interleaved stereo frames to mix into
+     * @param frames Count of frames to generate
+     */
+    virtual void nativeGenerateAndMix32(int32_t *output, size_t frames) = 0;
 
     virtual const char* emulatorName() = 0;
     virtual ChipType chipType() = 0;
@@ -94,6 +136,66 @@ private:
     OPLChipBase &operator=(const OPLChipBase &c);
 };
 
+// An emulator which keeps the state of several chips together and advances
+// them in lock-step. Every chip gets controlled through its own OPLChipBase
+// made by createChip(), the group renders all of them at once.
+class OPLChipGroup
+{
+public:
+    OPLChipGroup() {}
+    virtual ~OPLChipGroup() {}
+
+    /**
+     * @brief Maximum count of chips in the group
+     */
+    virtual size_t chips() const = 0;
+    /**
+     * @brief Make the interface of the chip of the group, it must not outlive the group
+     * @param index Index of chip in the group
+     * @return New chip interface, owned by the caller
+     */
+    virtual OPLChipBase *createChip(size_t index) = 0;
+    /**
+     * @brief Generate frames of chips at the native rate, every chip into its own buffer
+     * @param output Output buffers of interleaved stereo frames, one after another
+     * @param stride Distance between buffers of neighbour chips in samples
+     * @param mask Bit mask of chips to generate, other chips and their buffers are left untouched
+     * @param frames Count of frames to generate
+     */
+    virtual void nativeGenerateChips(int32_t *output, size_t stride, uint32_t mask, size_t frames) = 0;
+private:
+    OPLChipGroup(const OPLChipGroup &c);
+    OPLChipGroup &operator=(const OPLChipGroup &c);
+};
+
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+// Predicts how many native frames the HQ resampler takes before making every
+// output frame. The count doesn't depend on the data, so a copy of the resampler
+// fed with the silence gives it exactly. It must be set up and reset together
+// with the resampler it counts for.
+class OPLResamplerCounter
+{
+public:
+    OPLResamplerCounter();
+    ~OPLResamplerCounter();
+
+    void setup(double ratio, unsigned hlen);
+    void reset();
+    // count of native frames to pass before the next output frame
+    unsigned next();
+    // the next output frame was made
+    void take() { m_known = false; }
+    // takes "frames" output frames, returns the count of native frames passed before them
+    uint64_t skip(unsigned frames);
+private:
+    OPLResamplerCounter(const OPLResamplerCounter &);
+    OPLResamplerCounter &operator=(const OPLResamplerCounter &);
+    VResampler *m_counter;
+    unsigned m_next;
+    bool m_known;
+};
+#endif
+
 // A base class providing F-bounded generic and efficient implementations,
 // supporting resampling of chip outputs
 template <class T>
@@ -112,21 +214,38 @@ public:
     virtual void setRate(uint32_t rate) override;
     uint32_t effectiveRate() const override;
     virtual void reset() override;
+    // generic implementation calling writeReg() of the emulator directly, emulators may redefine it
+    void writeRegs(const uint16_t *addr, const uint8_t *data, size_t n) override;
     void generate(int16_t *output, size_t frames) override;
     void generateAndMix(int16_t *output, size_t frames) override;
     void generate32(int32_t *output, size_t frames) override;
     void generateAndMix32(int32_t *output, size_t frames) override;
+    void nativeGenerateAndMix32(int32_t *output, size_t frames) override;
+    // generic block implementation, emulators having a stream routine may redefine it
+    void nativeGenerateBlock(int16_t *output, size_t frames) override;
+    void resampledSkip(uint64_t frames) override;
+    bool outputFinished(bool native) const override;
 private:
     bool m_runningAtPcmRate;
 #if defined(ADLMIDI_AUDIO_TICK_HANDLER)
     void *m_audioTickHandlerInstance;
 #endif
     void nativeTick(int16_t *frame);
+    void nativeTickBlock(int16_t *output, size_t frames);
     void setupResampler(uint32_t rate);
     void resetResampler();
     void resampledGenerate(int32_t *output) override;
+    void resampledGenerateBlock(int32_t *output, size_t frames);
+    // size of the intermediate native-rate block used by the block-wise rendering
+    enum { nativeBlockFrames = 512 };
+    int16_t m_nativeBlock[2 * nativeBlockFrames];
 #if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
     VResampler *m_resampler;
+    // native frames which the resampler takes before every output frame
+    OPLResamplerCounter m_counter;
+    // count of the latest silent frames passed into the resampler
+    uint64_t m_silentInputs;
+    void countSilentInputs(const int16_t *input, size_t frames);
 #else
     int32_t m_oldsamples[2];
     int32_t m_samples[2];
@@ -153,6 +272,7 @@ public:
 public:
     void reset() override;
     void nativeGenerate(int16_t *frame) override;
+    void nativeGenerateBlock(int16_t *output, size_t frames) override;
 protected:
     virtual void nativeGenerateN(int16_t *output, size_t frames) = 0;
 private:
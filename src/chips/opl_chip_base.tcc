@@ -20,6 +20,7 @@
 
 #include "opl_chip_base.h"
 #include <cmath>
+#include <cassert>
 
 #if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
 #include <zita-resampler/vresampler.h>
@@ -49,6 +50,76 @@ inline OPLChipBase::~OPLChipBase()
 {
 }
 
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+/* OPLResamplerCounter */
+
+inline OPLResamplerCounter::OPLResamplerCounter() :
+    m_counter(new VResampler),
+    m_next(0),
+    m_known(false)
+{
+}
+
+inline OPLResamplerCounter::~OPLResamplerCounter()
+{
+    delete m_counter;
+}
+
+inline void OPLResamplerCounter::setup(double ratio, unsigned hlen)
+{
+    // The count of channels doesn't change the consumption, one is the cheapest
+    m_counter->setup(ratio, 1, hlen);
+    m_known = false;
+}
+
+inline void OPLResamplerCounter::reset()
+{
+    m_counter->reset();
+    m_known = false;
+}
+
+inline unsigned OPLResamplerCounter::next()
+{
+    if(!m_known)
+    {
+        const unsigned int available = ~0u;
+        m_counter->inp_count = available;
+        m_counter->inp_data = NULL;
+        m_counter->out_count = 1;
+        m_counter->out_data = NULL;
+        m_counter->process();
+        m_next = available - m_counter->inp_count;
+        m_known = true;
+    }
+    return m_next;
+}
+
+inline uint64_t OPLResamplerCounter::skip(unsigned frames)
+{
+    uint64_t ticks = 0;
+
+    if(frames > 0 && m_known)
+    {
+        ticks += m_next;
+        m_known = false;
+        --frames;
+    }
+
+    if(frames > 0)
+    {
+        const unsigned int available = ~0u;
+        m_counter->inp_count = available;
+        m_counter->inp_data = NULL;
+        m_counter->out_count = frames;
+        m_counter->out_data = NULL;
+        m_counter->process();
+        ticks += available - m_counter->inp_count;
+    }
+
+    return ticks;
+}
+#endif
+
 /* OPLChipBaseT */
 
 template <class T>
@@ -124,21 +195,32 @@ void OPLChipBaseT<T>::reset()
     resetResampler();
 }
 
+template <class T>
+void OPLChipBaseT<T>::writeRegs(const uint16_t *addr, const uint8_t *data, size_t n)
+{
+    T *self = static_cast<T *>(this);
+    for(size_t i = 0; i < n; ++i)
+        self->writeReg(addr[i], data[i]);
+}
+
 template <class T>
 void OPLChipBaseT<T>::generate(int16_t *output, size_t frames)
 {
     static_cast<T *>(this)->nativePreGenerate();
-    for(size_t i = 0; i < frames; ++i)
+    while(frames > 0)
     {
-        int32_t frame[2];
-        static_cast<T *>(this)->resampledGenerate(frame);
-        for (unsigned c = 0; c < 2; ++c) {
-            int32_t temp = frame[c];
+        int32_t buffer[2 * nativeBlockFrames];
+        size_t count = (frames < (size_t)nativeBlockFrames) ? frames : (size_t)nativeBlockFrames;
+        resampledGenerateBlock(buffer, count);
+        for(size_t i = 0; i < 2 * count; ++i)
+        {
+            int32_t temp = buffer[i];
             temp = (temp > -32768) ? temp : -32768;
             temp = (temp < 32767) ? temp : 32767;
-            output[c] = (int16_t)temp;
+            output[i] = (int16_t)temp;
         }
-        output += 2;
+        output += 2 * count;
+        frames -= count;
     }
     static_cast<T *>(this)->nativePostGenerate();
 }
@@ -147,17 +229,20 @@ template <class T>
 void OPLChipBaseT<T>::generateAndMix(int16_t *output, size_t frames)
 {
     static_cast<T *>(this)->nativePreGenerate();
-    for(size_t i = 0; i < frames; ++i)
+    while(frames > 0)
     {
-        int32_t frame[2];
-        static_cast<T *>(this)->resampledGenerate(frame);
-        for (unsigned c = 0; c < 2; ++c) {
-            int32_t temp = (int32_t)output[c] + frame[c];
+        int32_t buffer[2 * nativeBlockFrames];
+        size_t count = (frames < (size_t)nativeBlockFrames) ? frames : (size_t)nativeBlockFrames;
+        resampledGenerateBlock(buffer, count);
+        for(size_t i = 0; i < 2 * count; ++i)
+        {
+            int32_t temp = (int32_t)output[i] + buffer[i];
             temp = (temp > -32768) ? temp : -32768;
             temp = (temp < 32767) ? temp : 32767;
-            output[c] = (int16_t)temp;
+            output[i] = (int16_t)temp;
         }
-        output += 2;
+        output += 2 * count;
+        frames -= count;
     }
     static_cast<T *>(this)->nativePostGenerate();
 }
@@ -166,27 +251,53 @@ template <class T>
 void OPLChipBaseT<T>::generate32(int32_t *output, size_t frames)
 {
     static_cast<T *>(this)->nativePreGenerate();
-    for(size_t i = 0; i < frames; ++i)
+    resampledGenerateBlock(output, frames);
+    static_cast<T *>(this)->nativePostGenerate();
+}
+
+template <class T>
+void OPLChipBaseT<T>::generateAndMix32(int32_t *output, size_t frames)
+{
+    static_cast<T *>(this)->nativePreGenerate();
+    while(frames > 0)
     {
-        static_cast<T *>(this)->resampledGenerate(output);
-        output += 2;
+        int32_t buffer[2 * nativeBlockFrames];
+        size_t count = (frames < (size_t)nativeBlockFrames) ? frames : (size_t)nativeBlockFrames;
+        resampledGenerateBlock(buffer, count);
+        for(size_t i = 0; i < 2 * count; ++i)
+            output[i] += buffer[i];
+        output += 2 * count;
+        frames -= count;
     }
     static_cast<T *>(this)->nativePostGenerate();
 }
 
 template <class T>
-void OPLChipBaseT<T>::generateAndMix32(int32_t *output, size_t frames)
+void OPLChipBaseT<T>::nativeGenerateAndMix32(int32_t *output, size_t frames)
 {
+    int16_t *native = m_nativeBlock;
+
     static_cast<T *>(this)->nativePreGenerate();
+    while(frames > 0)
+    {
+        size_t count = (frames < (size_t)nativeBlockFrames) ? frames : (size_t)nativeBlockFrames;
+        nativeTickBlock(native, count);
+        for(size_t i = 0; i < 2 * count; ++i)
+            output[i] += (int32_t)native[i] * T::resamplerPreAmplify / T::resamplerPostAttenuate;
+        output += 2 * count;
+        frames -= count;
+    }
+    static_cast<T *>(this)->nativePostGenerate();
+}
+
+template <class T>
+void OPLChipBaseT<T>::nativeGenerateBlock(int16_t *output, size_t frames)
+{
     for(size_t i = 0; i < frames; ++i)
     {
-        int32_t frame[2];
-        static_cast<T *>(this)->resampledGenerate(frame);
-        output[0] += frame[0];
-        output[1] += frame[1];
+        static_cast<T *>(this)->nativeGenerate(output);
         output += 2;
     }
-    static_cast<T *>(this)->nativePostGenerate();
 }
 
 template <class T>
@@ -198,11 +309,95 @@ void OPLChipBaseT<T>::nativeTick(int16_t *frame)
     static_cast<T *>(this)->nativeGenerate(frame);
 }
 
+template <class T>
+void OPLChipBaseT<T>::nativeTickBlock(int16_t *output, size_t frames)
+{
+#if defined(ADLMIDI_AUDIO_TICK_HANDLER)
+    // The tick handler must be called before every single frame
+    for(size_t i = 0; i < frames; ++i)
+    {
+        nativeTick(output);
+        output += 2;
+    }
+#else
+    static_cast<T *>(this)->nativeGenerateBlock(output, frames);
+#endif
+}
+
+template <class T>
+void OPLChipBaseT<T>::resampledSkip(uint64_t frames)
+{
+    if(frames == 0)
+        return;
+
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+    if(m_runningAtPcmRate)
+    {
+        static_cast<T *>(this)->nativeSkip(frames);
+        return;
+    }
+
+    // Pass the silence through the resampler: it takes the same native frames as while generating
+    VResampler *rsm = m_resampler;
+    while(frames > 0)
+    {
+        const unsigned int count = (frames < 0x10000) ? (unsigned int)frames : 0x10000u;
+        const uint64_t ticks = m_counter.skip(count);
+        rsm->inp_count = (unsigned int)ticks;
+        rsm->inp_data = NULL;
+        rsm->out_count = count;
+        rsm->out_data = NULL;
+        rsm->process();
+        assert(rsm->inp_count == 0 && rsm->out_count == 0);
+
+        m_silentInputs += ticks;
+        static_cast<T *>(this)->nativeSkip(ticks);
+        frames -= count;
+    }
+#else
+    if(m_runningAtPcmRate)
+    {
+        static_cast<T *>(this)->nativeSkip(frames);
+        return;
+    }
+
+    // Count native frames the resampler would consume, the silent input keeps the history at zero
+    const int64_t samplecnt = (int64_t)m_samplecnt + (int64_t)(frames - 1) * (1 << rsm_frac);
+    const int64_t ticks = samplecnt / m_rateratio;
+    m_samplecnt = (int32_t)(samplecnt - ticks * m_rateratio) + (1 << rsm_frac);
+    if(ticks > 0)
+    {
+        m_oldsamples[0] = m_oldsamples[1] = 0;
+        m_samples[0] = m_samples[1] = 0;
+    }
+    static_cast<T *>(this)->nativeSkip((uint64_t)ticks);
+#endif
+}
+
+template <class T>
+bool OPLChipBaseT<T>::outputFinished(bool native) const
+{
+    if(!static_cast<const T *>(this)->envelopesFinished())
+        return false;
+
+    if(native || m_runningAtPcmRate)
+        return true;
+
+    // The resampler must have no earlier output left in its history
+#if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+    return m_silentInputs >= (uint64_t)m_resampler->inpsize();
+#else
+    return (m_oldsamples[0] | m_oldsamples[1] | m_samples[0] | m_samples[1]) == 0;
+#endif
+}
+
 template <class T>
 void OPLChipBaseT<T>::setupResampler(uint32_t rate)
 {
 #if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
     m_resampler->setup(rate * (1.0 / 49716), 2, 48);
+    m_counter.setup(rate * (1.0 / 49716), 48);
+    m_silentInputs = (uint64_t)m_resampler->inpsize();
 #else
     m_oldsamples[0] = m_oldsamples[1] = 0;
     m_samples[0] = m_samples[1] = 0;
@@ -216,6 +411,8 @@ void OPLChipBaseT<T>::resetResampler()
 {
 #if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
     m_resampler->reset();
+    m_counter.reset();
+    m_silentInputs = (uint64_t)m_resampler->inpsize();
 #else
     m_oldsamples[0] = m_oldsamples[1] = 0;
     m_samples[0] = m_samples[1] = 0;
@@ -224,6 +421,15 @@ void OPLChipBaseT<T>::resetResampler()
 }
 
 #if defined(ADLMIDI_ENABLE_HQ_RESAMPLER)
+template <class T>
+void OPLChipBaseT<T>::countSilentInputs(const int16_t *input, size_t frames)
+{
+    size_t silent = 0;
+    while(silent < frames && (input[2 * (frames - 1 - silent)] | input[2 * (frames - 1 - silent) + 1]) == 0)
+        ++silent;
+    m_silentInputs = (silent == frames) ? m_silentInputs + frames : silent;
+}
+
 template <class T>
 void OPLChipBaseT<T>::resampledGenerate(int32_t *output)
 {
@@ -241,24 +447,100 @@ void OPLChipBaseT<T>::resampledGenerate(int32_t *output)
         (float)T::resamplerPostAttenuate;
     float f_in[2];
     float f_out[2];
+    unsigned needed = m_counter.next();
+    m_counter.take();
     rsm->inp_count = 0;
-    rsm->inp_data = f_in;
     rsm->out_count = 1;
     rsm->out_data = f_out;
-    while(rsm->process(), rsm->out_count != 0)
+    do
     {
-        int16_t in[2];
-        static_cast<T *>(this)->nativeTick(in);
-        f_in[0] = scale * (float)in[0];
-        f_in[1] = scale * (float)in[1];
-        rsm->inp_count = 1;
+        if(needed > 0)
+        {
+            int16_t in[2];
+            static_cast<T *>(this)->nativeTick(in);
+            countSilentInputs(in, 1);
+            f_in[0] = scale * (float)in[0];
+            f_in[1] = scale * (float)in[1];
+            rsm->inp_count = 1;
+            --needed;
+        }
         rsm->inp_data = f_in;
-        rsm->out_count = 1;
-        rsm->out_data = f_out;
-    }
+        rsm->process();
+    } while(needed > 0);
+    assert(rsm->inp_count == 0 && rsm->out_count == 0);
     output[0] = static_cast<int32_t>(lround(f_out[0]));
     output[1] = static_cast<int32_t>(lround(f_out[1]));
 }
+
+template <class T>
+void OPLChipBaseT<T>::resampledGenerateBlock(int32_t *output, size_t frames)
+{
+    int16_t *native = m_nativeBlock;
+
+    if(UNLIKELY(m_runningAtPcmRate))
+    {
+        while(frames > 0)
+        {
+            size_t count = (frames < (size_t)nativeBlockFrames) ? frames : (size_t)nativeBlockFrames;
+            nativeTickBlock(native, count);
+            for(size_t i = 0; i < 2 * count; ++i)
+                output[i] = (int32_t)native[i] * T::resamplerPreAmplify / T::resamplerPostAttenuate;
+            output += 2 * count;
+            frames -= count;
+        }
+        return;
+    }
+
+    VResampler *rsm = m_resampler;
+    const float scale = (float)T::resamplerPreAmplify /
+        (float)T::resamplerPostAttenuate;
+    float f_in[2 * nativeBlockFrames];
+    float f_out[2 * nativeBlockFrames];
+
+    while(frames > 0)
+    {
+        // Output frames which can be made from one block of native frames. Generating more
+        // may not be done: extra frames would be rendered before the next register writes
+        // and the output would not match the frame-by-frame path.
+        size_t needed = 0;
+        size_t count = 0;
+        while(count < frames && count < (size_t)nativeBlockFrames)
+        {
+            const size_t next = m_counter.next();
+            if(needed + next > (size_t)nativeBlockFrames)
+                break;
+            needed += next;
+            m_counter.take();
+            ++count;
+        }
+
+        if(UNLIKELY(count == 0))
+        {
+            // Extremely low output rate, a single frame doesn't fit the block
+            resampledGenerate(output);
+            output += 2;
+            --frames;
+            continue;
+        }
+
+        nativeTickBlock(native, needed);
+        countSilentInputs(native, needed);
+        for(size_t i = 0; i < 2 * needed; ++i)
+            f_in[i] = scale * (float)native[i];
+
+        rsm->inp_count = (unsigned int)needed;
+        rsm->inp_data = f_in;
+        rsm->out_count = (unsigned int)count;
+        rsm->out_data = f_out;
+        rsm->process();
+        assert(rsm->inp_count == 0 && rsm->out_count == 0);
+
+        for(size_t i = 0; i < 2 * count; ++i)
+            output[i] = static_cast<int32_t>(lround(f_out[i]));
+        output += 2 * count;
+        frames -= count;
+    }
+}
 #else
 template <class T>
 void OPLChipBaseT<T>::resampledGenerate(int32_t *output)
@@ -290,6 +572,80 @@ void OPLChipBaseT<T>::resampledGenerate(int32_t *output)
                             + m_samples[1] * samplecnt) / rateratio)/T::resamplerPostAttenuate);
     m_samplecnt = samplecnt + (1 << rsm_frac);
 }
+
+template <class T>
+void OPLChipBaseT<T>::resampledGenerateBlock(int32_t *output, size_t frames)
+{
+    int16_t *native = m_nativeBlock;
+
+    if(UNLIKELY(m_runningAtPcmRate))
+    {
+        while(frames > 0)
+        {
+            size_t count = (frames < (size_t)nativeBlockFrames) ? frames : (size_t)nativeBlockFrames;
+            nativeTickBlock(native, count);
+            for(size_t i = 0; i < 2 * count; ++i)
+                output[i] = (int32_t)native[i] * T::resamplerPreAmplify / T::resamplerPostAttenuate;
+            output += 2 * count;
+            frames -= count;
+        }
+        return;
+    }
+
+    const int32_t rateratio = m_rateratio;
+
+    while(frames > 0)
+    {
+        // Find how many output frames can be made from one block of native frames
+        int32_t samplecnt = m_samplecnt;
+        size_t needed = 0;
+        size_t count = 0;
+        while(count < frames)
+        {
+            size_t steps = (size_t)(samplecnt / rateratio);
+            if(needed + steps > (size_t)nativeBlockFrames)
+                break;
+            needed += steps;
+            samplecnt -= (int32_t)steps * rateratio;
+            samplecnt += (1 << rsm_frac);
+            ++count;
+        }
+
+        if(UNLIKELY(count == 0))
+        {
+            // Extremely low output rate, a single frame doesn't fit the block
+            resampledGenerate(output);
+            output += 2;
+            --frames;
+            continue;
+        }
+
+        nativeTickBlock(native, needed);
+
+        const int16_t *in = native;
+        samplecnt = m_samplecnt;
+        for(size_t i = 0; i < count; ++i)
+        {
+            while(samplecnt >= rateratio)
+            {
+                m_oldsamples[0] = m_samples[0];
+                m_oldsamples[1] = m_samples[1];
+                m_samples[0] = in[0] * T::resamplerPreAmplify;
+                m_samples[1] = in[1] * T::resamplerPreAmplify;
+                in += 2;
+                samplecnt -= rateratio;
+            }
+            output[0] = (int32_t)(((m_oldsamples[0] * (rateratio - samplecnt)
+                                    + m_samples[0] * samplecnt) / rateratio)/T::resamplerPostAttenuate);
+            output[1] = (int32_t)(((m_oldsamples[1] * (rateratio - samplecnt)
+                                    + m_samples[1] * samplecnt) / rateratio)/T::resamplerPostAttenuate);
+            samplecnt += (1 << rsm_frac);
+            output += 2;
+        }
+        m_samplecnt = samplecnt;
+        frames -= count;
+    }
+}
 #endif
 
 /* OPLChipBaseBufferedT */
@@ -312,3 +668,23 @@ void OPLChipBaseBufferedT<T, Buffer>::nativeGenerate(int16_t *frame)
     bufferIndex = (bufferIndex + 1 < Buffer) ? (bufferIndex + 1) : 0;
     m_bufferIndex = bufferIndex;
 }
+
+template <class T, unsigned Buffer>
+void OPLChipBaseBufferedT<T, Buffer>::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    unsigned bufferIndex = m_bufferIndex;
+
+    // Give out the frames left in the buffer first to keep the stream continuous
+    while(bufferIndex != 0 && frames > 0)
+    {
+        output[0] = m_buffer[2 * bufferIndex];
+        output[1] = m_buffer[2 * bufferIndex + 1];
+        bufferIndex = (bufferIndex + 1 < Buffer) ? (bufferIndex + 1) : 0;
+        output += 2;
+        --frames;
+    }
+    m_bufferIndex = bufferIndex;
+
+    if(frames > 0)
+        static_cast<T *>(this)->nativeGenerateN(output, frames);
+}
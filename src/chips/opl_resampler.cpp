@@ -0,0 +1,412 @@
+/*
+ * Interfaces over Yamaha OPL2 (YM3812) and Yamaha OPL3 (YMF262) chip emulators
+ *
+ * Copyright (c) 2017-2026 Vitaly Novichkov (Wohlstand)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "opl_resampler.h"
+#include <cmath>
+#include <cstring>
+
+#if !defined(OPL_RESAMPLER_NO_SIMD) && !defined(__DJGPP__) && !defined(__WATCOMC__)
+#   if (defined(__x86_64__) || defined(__i386__)) && \
+       (defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#       define OPL_RESAMPLER_X86
+#       define OPL_RESAMPLER_TARGET(x) __attribute__((target(x)))
+#       include <immintrin.h>
+#   elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#       define OPL_RESAMPLER_X86
+#       define OPL_RESAMPLER_TARGET(x)
+#       include <immintrin.h>
+#       include <intrin.h>
+#   elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#       define OPL_RESAMPLER_NEON
+#       include <arm_neon.h>
+#   endif
+#endif
+
+
+/* Filter kernels: make two dot products (two neighbour phases) for each channel */
+
+static void resamplerKernelScalar(const float *coef0, const float *coef1,
+                                  const float *histL, const float *histR,
+                                  unsigned taps, float *out)
+{
+    float l0 = 0.0f, l1 = 0.0f, r0 = 0.0f, r1 = 0.0f;
+
+    for(unsigned i = 0; i < taps; ++i)
+    {
+        l0 += coef0[i] * histL[i];
+        l1 += coef1[i] * histL[i];
+        r0 += coef0[i] * histR[i];
+        r1 += coef1[i] * histR[i];
+    }
+
+    out[0] = l0;
+    out[1] = l1;
+    out[2] = r0;
+    out[3] = r1;
+}
+
+#ifdef OPL_RESAMPLER_X86
+OPL_RESAMPLER_TARGET("sse2")
+static inline float resamplerHsumSSE2(__m128 v)
+{
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+// Taps count is always a multiple of 8
+OPL_RESAMPLER_TARGET("sse2")
+static void resamplerKernelSSE2(const float *coef0, const float *coef1,
+                                const float *histL, const float *histR,
+                                unsigned taps, float *out)
+{
+    __m128 l0 = _mm_setzero_ps(), l1 = _mm_setzero_ps();
+    __m128 r0 = _mm_setzero_ps(), r1 = _mm_setzero_ps();
+
+    for(unsigned i = 0; i < taps; i += 4)
+    {
+        __m128 c0 = _mm_loadu_ps(coef0 + i);
+        __m128 c1 = _mm_loadu_ps(coef1 + i);
+        __m128 hl = _mm_loadu_ps(histL + i);
+        __m128 hr = _mm_loadu_ps(histR + i);
+        l0 = _mm_add_ps(l0, _mm_mul_ps(c0, hl));
+        l1 = _mm_add_ps(l1, _mm_mul_ps(c1, hl));
+        r0 = _mm_add_ps(r0, _mm_mul_ps(c0, hr));
+        r1 = _mm_add_ps(r1, _mm_mul_ps(c1, hr));
+    }
+
+    out[0] = resamplerHsumSSE2(l0);
+    out[1] = resamplerHsumSSE2(l1);
+    out[2] = resamplerHsumSSE2(r0);
+    out[3] = resamplerHsumSSE2(r1);
+}
+
+OPL_RESAMPLER_TARGET("avx2,fma")
+static inline float resamplerHsumAVX2(__m256 v)
+{
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    __m128 shuf = _mm_movehdup_ps(lo);
+    __m128 sums = _mm_add_ps(lo, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+OPL_RESAMPLER_TARGET("avx2,fma")
+static void resamplerKernelAVX2(const float *coef0, const float *coef1,
+                                const float *histL, const float *histR,
+                                unsigned taps, float *out)
+{
+    __m256 l0 = _mm256_setzero_ps(), l1 = _mm256_setzero_ps();
+    __m256 r0 = _mm256_setzero_ps(), r1 = _mm256_setzero_ps();
+
+    for(unsigned i = 0; i < taps; i += 8)
+    {
+        __m256 c0 = _mm256_loadu_ps(coef0 + i);
+        __m256 c1 = _mm256_loadu_ps(coef1 + i);
+        __m256 hl = _mm256_loadu_ps(histL + i);
+        __m256 hr = _mm256_loadu_ps(histR + i);
+        l0 = _mm256_fmadd_ps(c0, hl, l0);
+        l1 = _mm256_fmadd_ps(c1, hl, l1);
+        r0 = _mm256_fmadd_ps(c0, hr, r0);
+        r1 = _mm256_fmadd_ps(c1, hr, r1);
+    }
+
+    out[0] = resamplerHsumAVX2(l0);
+    out[1] = resamplerHsumAVX2(l1);
+    out[2] = resamplerHsumAVX2(r0);
+    out[3] = resamplerHsumAVX2(r1);
+}
+
+static bool resamplerHasSSE2()
+{
+#   if defined(__x86_64__) || defined(_M_X64)
+    return true; // Always available on x86_64
+#   elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#   else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") != 0;
+#   endif
+}
+
+static bool resamplerHasAVX2()
+{
+#   if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if(!osxsave || !fma || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#   else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#   endif
+}
+#endif // OPL_RESAMPLER_X86
+
+#ifdef OPL_RESAMPLER_NEON
+static inline float resamplerHsumNEON(float32x4_t v)
+{
+    float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    s = vpadd_f32(s, s);
+    return vget_lane_f32(s, 0);
+}
+
+static void resamplerKernelNEON(const float *coef0, const float *coef1,
+                                const float *histL, const float *histR,
+                                unsigned taps, float *out)
+{
+    float32x4_t l0 = vdupq_n_f32(0.0f), l1 = vdupq_n_f32(0.0f);
+    float32x4_t r0 = vdupq_n_f32(0.0f), r1 = vdupq_n_f32(0.0f);
+
+    for(unsigned i = 0; i < taps; i += 4)
+    {
+        float32x4_t c0 = vld1q_f32(coef0 + i);
+        float32x4_t c1 = vld1q_f32(coef1 + i);
+        float32x4_t hl = vld1q_f32(histL + i);
+        float32x4_t hr = vld1q_f32(histR + i);
+        l0 = vmlaq_f32(l0, c0, hl);
+        l1 = vmlaq_f32(l1, c1, hl);
+        r0 = vmlaq_f32(r0, c0, hr);
+        r1 = vmlaq_f32(r1, c1, hr);
+    }
+
+    out[0] = resamplerHsumNEON(l0);
+    out[1] = resamplerHsumNEON(l1);
+    out[2] = resamplerHsumNEON(r0);
+    out[3] = resamplerHsumNEON(r1);
+}
+#endif // OPL_RESAMPLER_NEON
+
+
+/* Zero-order modified Bessel function of the first kind, used by the Kaiser window */
+static double resamplerBesselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    const double q = x * x * 0.25;
+
+    for(int k = 1; k < 64; ++k)
+    {
+        term *= q / ((double)k * (double)k);
+        sum += term;
+        if(term < sum * 1e-12)
+            break;
+    }
+
+    return sum;
+}
+
+
+OPLResampler::OPLResampler() :
+    m_inRate(0),
+    m_outRate(0),
+    m_phase(0),
+    m_taps(0),
+    m_table(NULL),
+    m_history(NULL),
+    m_historyPos(0),
+    m_kernel(resamplerKernelScalar),
+    m_kernelName("Scalar")
+{}
+
+OPLResampler::~OPLResampler()
+{
+    delete[] m_table;
+    delete[] m_history;
+}
+
+void OPLResampler::setup(uint32_t inRate, uint32_t outRate, Quality quality)
+{
+    const double pi = 3.14159265358979323846;
+    double beta, rolloff;
+
+    switch(quality)
+    {
+    default:
+    case QUALITY_MEDIUM:
+        m_taps = 16;
+        beta = 6.0;
+        rolloff = 0.90;
+        break;
+    case QUALITY_HIGH:
+        m_taps = 48;
+        beta = 9.0;
+        rolloff = 0.95;
+        break;
+    }
+
+    m_inRate = inRate;
+    m_outRate = outRate;
+
+    delete[] m_table;
+    delete[] m_history;
+    m_table = new float[(phases + 1) * m_taps];
+    m_history = new float[4 * m_taps];
+
+    // Cut-off frequency relative to the input rate, lowered to avoid aliasing when down-sampling
+    double cutoff = 0.5 * rolloff;
+    if(outRate < inRate)
+        cutoff *= (double)outRate / (double)inRate;
+
+    const double center = (double)(m_taps / 2) - 1.0;
+    const double halfLen = (double)(m_taps / 2);
+    const double i0beta = resamplerBesselI0(beta);
+
+    for(unsigned p = 0; p <= phases; ++p)
+    {
+        float *row = m_table + p * m_taps;
+        const double frac = (double)p / (double)phases;
+        double sum = 0.0;
+        double coefs[64];
+
+        for(unsigned k = 0; k < m_taps; ++k)
+        {
+            const double x = (double)k - center - frac;
+            const double y = 2.0 * cutoff * x;
+            const double sinc = (std::fabs(y) < 1e-9) ? 1.0 : std::sin(pi * y) / (pi * y);
+            const double w = x / halfLen;
+            const double window = (std::fabs(w) >= 1.0) ? 0.0 :
+                                  resamplerBesselI0(beta * std::sqrt(1.0 - w * w)) / i0beta;
+            coefs[k] = sinc * window;
+            sum += coefs[k];
+        }
+
+        // Normalize the gain of every phase to have the exact unity gain at DC
+        for(unsigned k = 0; k < m_taps; ++k)
+            row[k] = (float)(coefs[k] / sum);
+    }
+
+    m_kernel = resamplerKernelScalar;
+    m_kernelName = "Scalar";
+#if defined(OPL_RESAMPLER_X86)
+    if(resamplerHasAVX2())
+    {
+        m_kernel = resamplerKernelAVX2;
+        m_kernelName = "AVX2";
+    }
+    else if(resamplerHasSSE2())
+    {
+        m_kernel = resamplerKernelSSE2;
+        m_kernelName = "SSE2";
+    }
+#elif defined(OPL_RESAMPLER_NEON)
+    m_kernel = resamplerKernelNEON;
+    m_kernelName = "NEON";
+#endif
+
+    reset();
+}
+
+void OPLResampler::reset()
+{
+    m_phase = 0;
+    m_historyPos = 0;
+    if(m_history)
+        std::memset(m_history, 0, 4 * m_taps * sizeof(float));
+}
+
+size_t OPLResampler::countFrames(size_t outFrames, size_t maxInFrames, size_t *inFrames) const
+{
+    uint32_t phase = m_phase;
+    size_t needed = 0;
+    size_t count = 0;
+
+    while(count < outFrames)
+    {
+        uint32_t next = phase + m_inRate;
+        size_t steps = (size_t)(next / m_outRate);
+        if(needed + steps > maxInFrames)
+            break;
+        needed += steps;
+        phase = next - (uint32_t)steps * m_outRate;
+        ++count;
+    }
+
+    *inFrames = needed;
+    return count;
+}
+
+void OPLResampler::pushFrame(const int32_t *frame)
+{
+    const unsigned taps = m_taps;
+    float *histL = m_history;
+    float *histR = m_history + 2 * taps;
+    const unsigned pos = m_historyPos;
+
+    histL[pos] = histL[pos + taps] = (float)frame[0];
+    histR[pos] = histR[pos + taps] = (float)frame[1];
+    m_historyPos = (pos + 1 < taps) ? (pos + 1) : 0;
+}
+
+void OPLResampler::process(const int32_t *input, int32_t *output, size_t outFrames)
+{
+    const unsigned taps = m_taps;
+    const float *histL = m_history;
+    const float *histR = m_history + 2 * taps;
+    const uint32_t inRate = m_inRate;
+    const uint32_t outRate = m_outRate;
+    const double phaseScale = (double)phases / (double)outRate;
+    uint32_t phase = m_phase;
+    float out[4];
+
+    for(size_t i = 0; i < outFrames; ++i)
+    {
+        phase += inRate;
+        while(phase >= outRate)
+        {
+            pushFrame(input);
+            input += 2;
+            phase -= outRate;
+        }
+
+        const double pos = (double)phase * phaseScale;
+        const unsigned p = (unsigned)pos;
+        const float mu = (float)(pos - (double)p);
+        const float *coef0 = m_table + p * taps;
+
+        m_kernel(coef0, coef0 + taps, histL + m_historyPos, histR + m_historyPos, taps, out);
+
+        const float l = out[0] + mu * (out[1] - out[0]);
+        const float r = out[2] + mu * (out[3] - out[2]);
+        output[0] = (int32_t)std::floor(l + 0.5f);
+        output[1] = (int32_t)std::floor(r + 0.5f);
+        output += 2;
+    }
+
+    m_phase = phase;
+}
+
+const char *OPLResampler::kernelName() const
+{
+    return m_kernelName;
+}
@@ -0,0 +1,118 @@
+/*
+ * Interfaces over Yamaha OPL2 (YM3812) and Yamaha OPL3 (YMF262) chip emulators
+ *
+ * Copyright (c) 2017-2026 Vitaly Novichkov (Wohlstand)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OPL_RESAMPLER_H
+#define OPL_RESAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Windowed-sinc polyphase resampler of the interleaved stereo stream
+ *
+ * Filter kernels are vectorized (SSE2, AVX2 or NEON), the best one available
+ * at the running CPU gets chosen on setup.
+ */
+class OPLResampler
+{
+public:
+    enum Quality
+    {
+        //! 16 taps per phase, moderate CPU usage
+        QUALITY_MEDIUM = 0,
+        //! 48 taps per phase, high stop-band attenuation
+        QUALITY_HIGH
+    };
+
+    OPLResampler();
+    ~OPLResampler();
+
+    /**
+     * @brief Prepare the filter for the given conversion
+     * @param inRate Input sample rate
+     * @param outRate Output sample rate
+     * @param quality Quality of the filter
+     */
+    void setup(uint32_t inRate, uint32_t outRate, Quality quality);
+
+    /**
+     * @brief Clear the filter history, keeps the filter setup
+     */
+    void reset();
+
+    /**
+     * @brief Is resampler set up?
+     * @return true when filter is ready to process
+     */
+    bool isReady() const { return m_table != NULL; }
+
+    /**
+     * @brief Count output frames that can be made from the limited amount of input frames
+     * @param outFrames Wanted count of output frames
+     * @param maxInFrames Maximum count of input frames available
+     * @param inFrames [_out] Exact count of input frames needed to make the returned count of output frames
+     * @return Count of output frames which can be made
+     */
+    size_t countFrames(size_t outFrames, size_t maxInFrames, size_t *inFrames) const;
+
+    /**
+     * @brief Resample the block of frames
+     * @param input Input frames, must contain the amount of frames given by countFrames()
+     * @param output Output frames
+     * @param outFrames Count of output frames to make
+     */
+    void process(const int32_t *input, int32_t *output, size_t outFrames);
+
+    /**
+     * @brief Name of the filter kernel chosen for the running CPU
+     * @return Name of the instruction set
+     */
+    const char *kernelName() const;
+
+    typedef void (*KernelFunc)(const float *coef0, const float *coef1,
+                               const float *histL, const float *histR,
+                               unsigned taps, float *out);
+
+private:
+    OPLResampler(const OPLResampler &);
+    OPLResampler &operator=(const OPLResampler &);
+
+    void pushFrame(const int32_t *frame);
+
+    //! Count of phases in the filter table
+    enum { phases = 256 };
+
+    uint32_t m_inRate;
+    uint32_t m_outRate;
+    //! Position between two input frames, in units of 1/outRate
+    uint32_t m_phase;
+    //! Count of filter taps per phase
+    unsigned m_taps;
+    //! Filter table: (phases + 1) rows of m_taps coefficients
+    float *m_table;
+    //! History of input frames: left and right, each is mirrored twice to have a continuous window
+    float *m_history;
+    unsigned m_historyPos;
+    //! Filter kernel for the running CPU
+    KernelFunc m_kernel;
+    const char *m_kernelName;
+};
+
+#endif // OPL_RESAMPLER_H
@@ -23,6 +23,7 @@
 
 #include "opl_serial_port.h"
 #include "opl_serial_misc.h"
+#include <cstring>
 
 
 static size_t retrowave_protocol_serial_pack(const uint8_t *buf_in, size_t len_in, uint8_t *buf_out)
@@ -68,19 +69,26 @@ static size_t retrowave_protocol_serial_pack(const uint8_t *buf_in, size_t len_i
 }
 
 OPL_SerialPort::OPL_SerialPort()
-    : m_port(NULL), m_protocol(ProtocolUnknown)
+    : m_port(NULL), m_protocol(ProtocolUnknown),
+      m_writeBufferUsed(0), m_baudRate(0),
+      m_throttle(false), m_throttleBudget(0.0)
 {}
 
 OPL_SerialPort::~OPL_SerialPort()
 {
+    // Don't lose the last writes, such as the silencing of the chip
+    sendBuffered(m_writeBufferUsed);
     delete m_port;
     m_port = NULL;
 }
 
 bool OPL_SerialPort::connectPort(const std::string& name, unsigned baudRate, unsigned protocol)
 {
+    sendBuffered(m_writeBufferUsed);
     delete m_port;
     m_port = NULL;
+    m_baudRate = baudRate;
+    m_throttleBudget = 0.0;
 
     // ensure audio thread reads protocol atomically and in order,
     // so chipType() will be correct after the port is live
@@ -94,6 +102,78 @@ bool OPL_SerialPort::connectPort(const std::string& name, unsigned baudRate, uns
     return m_port->open(name, baudRate);
 }
 
+void OPL_SerialPort::setThrottle(bool throttle)
+{
+    m_throttle = throttle;
+    m_throttleBudget = 0.0;
+}
+
+void OPL_SerialPort::flushWrites(double seconds)
+{
+    size_t size = m_writeBufferUsed;
+
+    if(m_throttle && m_baudRate > 0)
+    {
+        // Every byte takes 10 bits on the line: the start bit, 8 data bits and the stop bit
+        m_throttleBudget += seconds * (double)m_baudRate / 10.0;
+        if(m_throttleBudget > (double)WriteBufferSize)
+            m_throttleBudget = (double)WriteBufferSize;
+
+        if(m_throttleBudget <= 0.0)
+            size = 0; // Data forced out by the full buffer is still being transferred
+        else if((double)size > m_throttleBudget)
+            size = (size_t)m_throttleBudget;
+
+        m_throttleBudget -= (double)size;
+    }
+
+    sendBuffered(size);
+}
+
+void OPL_SerialPort::queueWrite(const uint8_t *data, size_t size)
+{
+    // The buffer is full: send it right now, late writes are better than lost ones
+    if(m_writeBufferUsed + size > WriteBufferSize)
+    {
+        if(m_throttle && m_baudRate > 0)
+        {
+            // Send only the oldest data to fit the packet, next flushes pay it from their budget
+            const size_t overflow = m_writeBufferUsed + size - WriteBufferSize;
+            m_throttleBudget -= (double)overflow;
+            sendBuffered(overflow);
+        }
+        else
+            sendBuffered(m_writeBufferUsed);
+    }
+
+    std::memcpy(m_writeBuffer + m_writeBufferUsed, data, size);
+    m_writeBufferUsed += size;
+}
+
+void OPL_SerialPort::sendBuffered(size_t size)
+{
+    ChipSerialPortBase *port = m_port;
+
+    if(size == 0)
+        return;
+
+    if(port && port->isOpen())
+    {
+        size_t sent = 0;
+        while(sent < size)
+        {
+            int ret = port->write(m_writeBuffer + sent, size - sent);
+            if(ret <= 0)
+                break; // The port is broken, drop the data
+            sent += (size_t)ret;
+        }
+    }
+
+    m_writeBufferUsed -= size;
+    if(m_writeBufferUsed > 0)
+        std::memmove(m_writeBuffer, m_writeBuffer + size, m_writeBufferUsed);
+}
+
 bool OPL_SerialPort::hasFullPanning()
 {
     return false;
@@ -116,7 +196,7 @@ void OPL_SerialPort::writeReg(uint16_t addr, uint8_t data)
             break;
         sendBuffer[0] = (uint8_t)addr;
         sendBuffer[1] = (uint8_t)data;
-        port->write(sendBuffer, 2);
+        queueWrite(sendBuffer, 2);
         break;
     }
     case ProtocolNukeYktOPL3:
@@ -124,7 +204,7 @@ void OPL_SerialPort::writeReg(uint16_t addr, uint8_t data)
         sendBuffer[0] = (addr >> 6) | 0x80;
         sendBuffer[1] = ((addr & 0x3f) << 1) | (data >> 7);
         sendBuffer[2] = (data & 0x7f);
-        port->write(sendBuffer, 3);
+        queueWrite(sendBuffer, 3);
         break;
     }
     case ProtocolRetroWaveOPL3:
@@ -138,7 +218,7 @@ void OPL_SerialPort::writeReg(uint16_t addr, uint8_t data)
             0xfb, static_cast<uint8_t>(data)
         };
         size_t packed_len = retrowave_protocol_serial_pack(buf, sizeof(buf), sendBuffer);
-        port->write(sendBuffer, packed_len);
+        queueWrite(sendBuffer, packed_len);
         break;
     }
     }
@@ -150,6 +230,11 @@ void OPL_SerialPort::nativeGenerate(int16_t *frame)
     frame[1] = 0;
 }
 
+void OPL_SerialPort::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    std::memset(output, 0, 2 * frames * sizeof(int16_t));
+}
+
 const char *OPL_SerialPort::emulatorName()
 {
     return "OPL Serial Port Driver";
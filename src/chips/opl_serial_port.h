@@ -45,6 +45,17 @@ public:
 
     bool connectPort(const std::string &name, unsigned baudRate, unsigned protocol);
 
+    /**
+     * @brief Limit the data sent by flushWrites() by the bandwidth of the port
+     * @param throttle true to limit, false to send all buffered data at once
+     */
+    void setThrottle(bool throttle);
+    /**
+     * @brief Send buffered register writes to the port
+     * @param seconds Time passed since the previous flush, used by the throttle
+     */
+    void flushWrites(double seconds);
+
     bool canRunAtPcmRate() const override { return false; }
     void setRate(uint32_t /*rate*/) override {}
     void reset() override {}
@@ -52,6 +63,7 @@ public:
     void nativePreGenerate() override {}
     void nativePostGenerate() override {}
     void nativeGenerate(int16_t *frame) override;
+    void nativeGenerateBlock(int16_t *output, size_t frames) override;
     const char *emulatorName() override;
     ChipType chipType() override;
     bool hasFullPanning() override;
@@ -59,6 +71,22 @@ public:
 private:
     ChipSerialPortBase *m_port;
     int m_protocol;
+
+    //! Capacity of the buffer of packets waiting to be sent
+    enum { WriteBufferSize = 4096 };
+    //! Packets of register writes waiting to be sent
+    uint8_t m_writeBuffer[WriteBufferSize];
+    //! Count of bytes in the buffer
+    size_t m_writeBufferUsed;
+    //! Baud speed of the port
+    unsigned m_baudRate;
+    //! Limit the flushed data by the bandwidth of the port
+    bool m_throttle;
+    //! Count of bytes the port can take until the next flush, negative after the full buffer forced a send
+    double m_throttleBudget;
+
+    void queueWrite(const uint8_t *data, size_t size);
+    void sendBuffered(size_t size);
 };
 
 #endif // ENABLE_HW_OPL_SERIAL_PORT
@@ -205,6 +205,11 @@ void Win9x_OPL_Proxy::nativeGenerate(int16_t *frame)
     frame[1] = 0;
 }
 
+void Win9x_OPL_Proxy::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    std::memset(output, 0, 2 * frames * sizeof(int16_t));
+}
+
 const char *Win9x_OPL_Proxy::emulatorName()
 {
     return "OPL3 Proxy Driver";
@@ -105,6 +105,35 @@ void YmFmOPL3::nativeGenerate(int16_t *frame)
     frame[1] = static_cast<int16_t>(ymfm::clamp(frames_i.data[1] / 2, -32768, 32767));
 }
 
+void YmFmOPL3::nativeGenerateBlock(int16_t *output, size_t frames)
+{
+    ymfm::ymf262 *chip_r = reinterpret_cast<ymfm::ymf262*>(m_chip);
+
+    // pending writes are applied one per frame
+    while(frames > 0 && m_queueCount > 0)
+    {
+        nativeGenerate(output);
+        output += 2;
+        --frames;
+    }
+
+    enum { maxframes = 256 };
+    ymfm::ymf262::output_data frames_i[maxframes];
+
+    while(frames > 0)
+    {
+        uint32_t count = static_cast<uint32_t>((frames < (size_t)maxframes) ? frames : (size_t)maxframes);
+        chip_r->generate(frames_i, count);
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            output[0] = static_cast<int16_t>(ymfm::clamp(frames_i[i].data[0] / 2, -32768, 32767));
+            output[1] = static_cast<int16_t>(ymfm::clamp(frames_i[i].data[1] / 2, -32768, 32767));
+            output += 2;
+        }
+        frames -= count;
+    }
+}
+
 const char *YmFmOPL3::emulatorName()
 {
     return "YMFM OPL3";
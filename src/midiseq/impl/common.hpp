@@ -230,6 +230,34 @@ inline uint64_t readHMPVarLenEx(FileAndMemReader &fr, const size_t end, bool &ok
     return result;
 }
 
+/**
+ * @brief Utility function to find the lowest set bit of the mask
+ * @param bits Non-zero mask
+ * @return Index of the lowest set bit
+ */
+inline unsigned lowestBitIndex(uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+    unsigned i = 0;
+
+    while((bits & 0xFF) == 0)
+    {
+        bits >>= 8;
+        i += 8;
+    }
+
+    while((bits & 1) == 0)
+    {
+        bits >>= 1;
+        ++i;
+    }
+
+    return i;
+#endif
+}
+
 inline bool strEqual(const char *in_str, size_t length, const char *needle)
 {
     const char *it_i = in_str, *it_n = needle;
@@ -265,11 +265,11 @@ bool BW_MidiSequencer::debugDumpContents(FILE *out)
         fprintf(out, "Device Mask: 0x%04X\r\n", (unsigned)trackState.deviceMask);
         fprintf(out, "\r\n");
 
-        MidiTrackQueue::Leaf_t *it = m_trackBeginPosition.track[tk].pos;
+        const MidiTrackQueue &track = m_trackData[tk];
 
-        while(it != NULL)
+        for(size_t it = m_trackBeginPosition.track[tk].pos; it < track.size(); ++it)
         {
-            MidiTrackRow &row = it->data;
+            const MidiTrackRow &row = track[it];
 
             str2time(row.timeDelay, delayBuff, 100);
             str2time(row.time, timeBuff, 100);
@@ -307,7 +307,6 @@ bool BW_MidiSequencer::debugDumpContents(FILE *out)
             }
 
             fflush(out);
-            it = it->next;
         }
 
         fprintf(out, "=======================Track %lu=END===================\r\n\r\n\r\n", (unsigned long)tk);
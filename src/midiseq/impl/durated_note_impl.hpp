@@ -29,31 +29,56 @@
 #include <cstring>
 
 #include "../midi_sequencer.hpp"
+#include "common.hpp"
 
-bool BW_MidiSequencer::duratedNoteAlloc(size_t track, DuratedNote **note)
+bool BW_MidiSequencer::duratedNoteAlloc(size_t track, uint64_t expiry, DuratedNote **note)
 {
     DuratedNotesCache &cache = m_trackState[track].duratedNotes;
 
-    if(cache.notes_count >= 128)
+    if(cache.notes_count >= DURATED_NOTES_MAX)
         return false; // Can't insert delayed note off!
 
-    *note = cache.notes + cache.notes_count++;
+    *note = cache.notes + cache.notes_count;
+    (*note)->expiry = expiry;
+    (*note)->expired = 0;
+    duratedNoteLink(static_cast<uint32_t>(track * DURATED_NOTES_MAX + cache.notes_count));
+    ++cache.notes_count;
+    ++m_duratedWheel.count;
 
     return true;
 }
 
 void BW_MidiSequencer::duratedNoteClear()
 {
+    DuratedNotesWheel &w = m_duratedWheel;
+
     for(MidiTrackState *it = m_trackState.begin(); it != m_trackState.end(); ++it)
+    {
         it->duratedNotes.notes_count = 0;
+        it->duratedNotes.expired_count = 0;
+    }
+
+    w.tick = m_scheduleTick;
+    w.count = 0;
+    std::memset(w.occupied, 0, sizeof(w.occupied));
+    std::memset(w.head, 0xFF, sizeof(w.head));
 }
 
-void BW_MidiSequencer::duratedNoteTick(size_t track, int64_t ticks)
+void BW_MidiSequencer::duratedNoteClearTrack(size_t track)
 {
     DuratedNotesCache &cache = m_trackState[track].duratedNotes;
 
     for(size_t i = 0; i < cache.notes_count; ++i)
-        cache.notes[i].ttl -= ticks;
+    {
+        if(!cache.notes[i].expired)
+        {
+            duratedNoteUnlink(static_cast<uint32_t>(track * DURATED_NOTES_MAX + i));
+            --m_duratedWheel.count;
+        }
+    }
+
+    cache.notes_count = 0;
+    cache.expired_count = 0;
 }
 
 void BW_MidiSequencer::duratedNotePop(size_t track, size_t i)
@@ -62,10 +87,203 @@ void BW_MidiSequencer::duratedNotePop(size_t track, size_t i)
 
     if(i < cache.notes_count)
     {
-        if(cache.notes_count > 1)
-            std::memcpy(cache.notes + i, cache.notes + cache.notes_count - 1, sizeof(DuratedNote));
+        const size_t last = cache.notes_count - 1;
+
+        if(i != last)
+        {
+            const uint32_t id = static_cast<uint32_t>(track * DURATED_NOTES_MAX + i);
+            DuratedNote &n = cache.notes[i];
+            std::memcpy(&n, cache.notes + last, sizeof(DuratedNote));
+
+            // The moved note is referred by neighbours in the wheel's slot
+            if(!n.expired)
+            {
+                if(n.wheelPrev != DURATED_NOTE_NONE)
+                    duratedNoteAt(n.wheelPrev).wheelNext = id;
+                else
+                {
+                    size_t level, slot;
+                    duratedNotesSlot(n.expiry, level, slot);
+                    m_duratedWheel.head[level][slot] = id;
+                }
+
+                if(n.wheelNext != DURATED_NOTE_NONE)
+                    duratedNoteAt(n.wheelNext).wheelPrev = id;
+            }
+        }
+
         --cache.notes_count;
     }
 }
 
+BW_MidiSequencer::DuratedNote &BW_MidiSequencer::duratedNoteAt(uint32_t id)
+{
+    return m_trackState[id / DURATED_NOTES_MAX].duratedNotes.notes[id % DURATED_NOTES_MAX];
+}
+
+void BW_MidiSequencer::duratedNotesSlot(uint64_t expiry, size_t &level, size_t &slot) const
+{
+    const uint64_t diff = expiry ^ m_duratedWheel.tick;
+
+    level = 0;
+    while(level + 1 < DURATED_WHEEL_LEVELS && (diff >> ((level + 1) * 6)) != 0)
+        ++level;
+
+    slot = (expiry >> (level * 6)) & (DURATED_WHEEL_SLOTS - 1);
+}
+
+void BW_MidiSequencer::duratedNoteLink(uint32_t id)
+{
+    DuratedNotesWheel &w = m_duratedWheel;
+    DuratedNote &n = duratedNoteAt(id);
+    size_t level, slot;
+
+    duratedNotesSlot(n.expiry, level, slot);
+
+    const uint64_t bit = static_cast<uint64_t>(1) << slot;
+
+    n.wheelPrev = DURATED_NOTE_NONE;
+    n.wheelNext = w.head[level][slot];
+
+    if((w.occupied[level] & bit) == 0)
+    {
+        n.wheelNext = DURATED_NOTE_NONE;
+        w.occupied[level] |= bit;
+        w.earliest[level][slot] = n.expiry;
+    }
+    else
+    {
+        duratedNoteAt(n.wheelNext).wheelPrev = id;
+        if(n.expiry < w.earliest[level][slot])
+            w.earliest[level][slot] = n.expiry;
+    }
+
+    w.head[level][slot] = id;
+}
+
+void BW_MidiSequencer::duratedNoteUnlink(uint32_t id)
+{
+    DuratedNotesWheel &w = m_duratedWheel;
+    const DuratedNote &n = duratedNoteAt(id);
+    size_t level, slot;
+
+    duratedNotesSlot(n.expiry, level, slot);
+
+    if(n.wheelNext != DURATED_NOTE_NONE)
+        duratedNoteAt(n.wheelNext).wheelPrev = n.wheelPrev;
+
+    if(n.wheelPrev != DURATED_NOTE_NONE)
+        duratedNoteAt(n.wheelPrev).wheelNext = n.wheelNext;
+    else
+        w.head[level][slot] = n.wheelNext;
+
+    if(w.head[level][slot] == DURATED_NOTE_NONE)
+    {
+        w.occupied[level] &= ~(static_cast<uint64_t>(1) << slot);
+        return;
+    }
+
+    if(n.expiry == w.earliest[level][slot])
+    {
+        // Find the new earliest expiry of the slot, it's needed exactly to not wake up too early
+        uint64_t earliest = duratedNoteAt(w.head[level][slot]).expiry;
+
+        for(uint32_t it = w.head[level][slot]; it != DURATED_NOTE_NONE; it = duratedNoteAt(it).wheelNext)
+        {
+            const uint64_t e = duratedNoteAt(it).expiry;
+            if(e < earliest)
+                earliest = e;
+        }
+
+        w.earliest[level][slot] = earliest;
+    }
+}
+
+bool BW_MidiSequencer::duratedNotesEarliest(uint64_t &tick) const
+{
+    const DuratedNotesWheel &w = m_duratedWheel;
+
+    if(w.count == 0)
+        return false;
+
+    // Notes of lower levels are always earlier, slots below the wheel's tick are empty
+    for(size_t level = 0; level < DURATED_WHEEL_LEVELS; ++level)
+    {
+        if(w.occupied[level] != 0)
+        {
+            tick = w.earliest[level][lowestBitIndex(w.occupied[level])];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void BW_MidiSequencer::duratedNotesTurn(uint64_t tick)
+{
+    DuratedNotesWheel &w = m_duratedWheel;
+    size_t level, slot;
+
+    if(w.tick == tick)
+        return;
+
+    // The highest changed level of the wheel's tick
+    duratedNotesSlot(tick, level, slot);
+    w.tick = tick;
+
+    if(level == 0)
+        return; // Notes of the first level are placed by their exact ticks
+
+    // Lower levels are empty, notes of the reached slot get spread over them
+    const uint64_t bit = static_cast<uint64_t>(1) << slot;
+
+    if((w.occupied[level] & bit) == 0)
+        return;
+
+    uint32_t id = w.head[level][slot];
+    w.head[level][slot] = DURATED_NOTE_NONE;
+    w.occupied[level] &= ~bit;
+
+    while(id != DURATED_NOTE_NONE)
+    {
+        const uint32_t next = duratedNoteAt(id).wheelNext;
+        duratedNoteLink(id);
+        id = next;
+    }
+}
+
+void BW_MidiSequencer::duratedNotesExpire(uint64_t tick)
+{
+    DuratedNotesWheel &w = m_duratedWheel;
+    uint64_t earliest;
+
+    while(duratedNotesEarliest(earliest) && earliest <= tick)
+    {
+        duratedNotesTurn(earliest);
+
+        // All notes expiring at the wheel's tick are in its slot of the first level
+        const size_t slot = earliest & (DURATED_WHEEL_SLOTS - 1);
+        uint32_t id = w.head[0][slot];
+        w.head[0][slot] = DURATED_NOTE_NONE;
+        w.occupied[0] &= ~(static_cast<uint64_t>(1) << slot);
+
+        while(id != DURATED_NOTE_NONE)
+        {
+            const size_t track = id / DURATED_NOTES_MAX;
+            DuratedNotesCache &cache = m_trackState[track].duratedNotes;
+            DuratedNote &n = cache.notes[id % DURATED_NOTES_MAX];
+
+            id = n.wheelNext;
+            n.expired = 1;
+            --w.count;
+
+            cache.expired[cache.expired_count++] = static_cast<uint8_t>(&n - cache.notes);
+            if(cache.expired_count == 1)
+                nextEventsUpdate(track); // The track has Note-Offs to send right now
+        }
+    }
+
+    duratedNotesTurn(tick);
+}
+
 #endif /* BW_MIDISEQ_DURATED_NOTE_IMPL_HPP */
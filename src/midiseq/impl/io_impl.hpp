@@ -208,6 +208,7 @@ void BW_MidiSequencer::rewind()
 {
     m_currentPosition   = m_trackBeginPosition;
     m_atEnd             = false;
+    m_scheduleSynced = false;
 
     m_loop.loopsCount = m_loopCount;
     m_loop.reset();
@@ -178,18 +178,17 @@ void BW_MidiSequencer::installLoop(BW_MidiSequencer::LoopPointParseState &loopSt
         {
             Position::TrackInfo &track = scanPosition.track[tk];
             MidiTrackRow *ti = NULL;
-            // MidiTrackQueue::Leaf_t *end = m_trackData[tk].m_end;
 
             if((track.lastHandledEvent >= 0) && (track.delay <= 0))
             {
                 // Check is an end of track has been reached
-                if(track.pos == NULL)
+                if(track.pos >= m_trackData[tk].size())
                 {
                     track.lastHandledEvent = -1;
                     break;
                 }
 
-                ti = &track.pos->data;
+                ti = &m_trackData[tk][track.pos];
 
                 for(size_t i = ti->events_begin; i < ti->events_end; ++i)
                 {
@@ -291,7 +290,7 @@ void BW_MidiSequencer::installLoop(BW_MidiSequencer::LoopPointParseState &loopSt
                 if(track.lastHandledEvent >= 0)
                 {
                     track.delay += ti->delay;
-                    track.pos = track.pos->next;
+                    ++track.pos;
                 }
             }
         }
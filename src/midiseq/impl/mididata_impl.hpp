@@ -70,9 +70,17 @@ void BW_MidiSequencer::buildSmfSetupReset(size_t trackCount)
     m_dataBank.clear();
     m_eventBank.clear();
     m_branches.clear();
+    m_eventsTimeline.clear();
+    m_eventsTimelineEnabled = false;
+    m_nextEvents.clear();
+    m_nextEventsIndex.clear();
+    m_dueTracks.clear();
+    m_nextEventsCount = 0;
+    m_scheduleSynced = false;
 
     m_trackData.clear();
     m_trackState.clear();
+    duratedNoteClear();
 
     m_loop.reset();
     m_loop.invalidLoop = false;
@@ -96,16 +104,15 @@ void BW_MidiSequencer::initTracksBegin(size_t track)
 {
     if(m_trackData[track].size() > 0)
     {
-        MidiTrackQueue::Leaf_t *pos = m_trackData[track].m_begin;
-        m_trackBeginPosition.track[track].pos = pos;
+        m_trackBeginPosition.track[track].pos = 0;
         // Some events doesn't begin at zero!
-        m_trackBeginPosition.track[track].delay = pos->data.absPos;
+        m_trackBeginPosition.track[track].delay = m_trackData[track][0].absPos;
         m_trackBeginPosition.track[track].lastHandledEvent = 0;
         std::memcpy(&m_trackBeginPosition.track[track].state, &m_trackState[track].state, sizeof(TrackStateSaved));
     }
     else
     {
-        m_trackBeginPosition.track[track].pos = NULL;
+        m_trackBeginPosition.track[track].pos = 0;
         m_trackBeginPosition.track[track].delay = 0;
         m_trackBeginPosition.track[track].lastHandledEvent = -1;
     }
@@ -156,7 +163,7 @@ void BW_MidiSequencer::buildTimeLine(const TemposList &tempos,
         std::fflush(stdout);
 #endif
 
-        posPrev = &track.m_begin->data;//First element
+        posPrev = &track[0];//First element
 
         // If doesn't begins with zero, add a fake one!
         if(posPrev->absPos > 0)
@@ -166,12 +173,12 @@ void BW_MidiSequencer::buildTimeLine(const TemposList &tempos,
             posPrev = &fakePos;
         }
 
-        for(MidiTrackQueue::Leaf_t *it = track.m_begin; it != NULL; it = it->next)
+        for(size_t row = 0; row < track.size(); ++row)
         {
 #ifdef BWMIDI_DEBUG_TIME_CALCULATION
             bool tempoChanged = false;
 #endif
-            MidiTrackRow &pos = it->data;
+            MidiTrackRow &pos = track[row];
             if((posPrev != &pos) && // Skip first event
                (!tempos.empty()) && // Only when in-track tempo events are available
                (tempo_change_index < tempos.size)
@@ -275,8 +282,22 @@ void BW_MidiSequencer::buildTimeLine(const TemposList &tempos,
     }
 
     m_fullSongTimeLength += m_postSongWaitDelay;
+
+    buildEventsTimeline();
+
+    // Songs not fitting the merged time line are played by the next events queue
+    if(!m_eventsTimelineEnabled && m_tracksCount > 0)
+    {
+        m_nextEvents.resize_clean(m_tracksCount);
+        m_nextEventsIndex.resize_fill(m_tracksCount, ~static_cast<size_t>(0));
+        m_dueTracks.resize_clean(m_tracksCount);
+    }
+
+    m_nextEventsCount = 0;
+
     // Set begin of the music
     m_currentPosition = m_trackBeginPosition;
+    m_scheduleSynced = false;
     // Initial loop position will begin at begin of track until passing of the loop point
     m_loopBeginPosition = m_trackBeginPosition;
     // Set lowest level of the loop stack
@@ -306,13 +327,15 @@ void BW_MidiSequencer::buildTimeLine(const TemposList &tempos,
                 if((track.lastHandledEvent >= 0) && (track.delay <= 0))
                 {
                     // Check is an end of track has been reached
-                    if(track.pos == NULL)
+                    if(track.pos >= m_trackData[tk].size())
                     {
                         track.lastHandledEvent = -1;
                         continue;
                     }
 
-                    for(i = track.pos->data.events_begin; i < track.pos->data.events_end; ++i)
+                    const MidiTrackRow &row = m_trackData[tk][track.pos];
+
+                    for(i = row.events_begin; i < row.events_end; ++i)
                     {
                         const MidiEvent &evt = m_eventBank[i];
                         if(evt.type == MidiEvent::T_SPECIAL && evt.subtype == MidiEvent::ST_LOOPSTART)
@@ -325,8 +348,8 @@ void BW_MidiSequencer::buildTimeLine(const TemposList &tempos,
 
                     if(track.lastHandledEvent >= 0)
                     {
-                        track.delay += track.pos->data.delay;
-                        track.pos = track.pos->next;
+                        track.delay += row.delay;
+                        ++track.pos;
                     }
                 }
             }
@@ -349,6 +372,8 @@ void BW_MidiSequencer::buildTimeLine(const TemposList &tempos,
             for(tk = 0; tk < m_tracksCount; ++tk)
                 rowPosition.track[tk].delay -= shortestDelay;
 
+            rowPosition.absTickPosition += shortestDelay;
+
             if(caughLoopStart > 0)
             {
                 m_loopBeginPosition = rowBeginPosition;
@@ -362,4 +387,126 @@ void BW_MidiSequencer::buildTimeLine(const TemposList &tempos,
     }
 }
 
+void BW_MidiSequencer::buildEventsTimeline()
+{
+    miditrack_arr<EventsTimelineEntry> merged;
+    miditrack_arr<size_t> runs;
+    EventsTimelineEntry entry, *src, *dst, *swap;
+    size_t total = 0, runsCount, tk, i;
+    uint64_t tick;
+
+    m_eventsTimeline.clear();
+    m_eventsTimelineEnabled = false;
+
+    // Tracks moving independently from others need the next events queue
+    for(i = 0; i < m_eventBank.size; ++i)
+    {
+        const MidiEvent &evt = m_eventBank[i];
+
+        if(evt.type == MidiEvent::T_NOTEON_DURATED)
+            return;
+
+        if(evt.type != MidiEvent::T_SPECIAL)
+            continue;
+
+        switch(evt.subtype)
+        {
+        case MidiEvent::ST_TRACK_LOOPSTACK_BEGIN:
+        case MidiEvent::ST_TRACK_LOOPSTACK_BEGIN_ID:
+        case MidiEvent::ST_TRACK_LOOPSTACK_END:
+        case MidiEvent::ST_TRACK_LOOPSTACK_END_ID:
+        case MidiEvent::ST_TRACK_LOOPSTACK_BREAK:
+        case MidiEvent::ST_BRANCH_TO:
+        case MidiEvent::ST_TRACK_BRANCH_TO:
+            return;
+        default:
+            break;
+        }
+    }
+
+    // Every track has the entry of its end after the last row
+    for(tk = 0; tk < m_tracksCount; ++tk)
+    {
+        if(!m_trackData[tk].empty())
+            total += m_trackData[tk].size() + 1;
+    }
+
+    if(total == 0)
+        return;
+
+    m_eventsTimeline.resize_clean(total);
+    merged.resize_clean(total);
+    runs.resize_clean(m_tracksCount + 1);
+
+    // Put rows of every track in a row, they are sorted by ticks already
+    total = 0;
+    runsCount = 0;
+
+    for(tk = 0; tk < m_tracksCount; ++tk)
+    {
+        MidiTrackQueue &track = m_trackData[tk];
+
+        if(track.empty())
+            continue;
+
+        runs[runsCount++] = total;
+        entry.track = tk;
+
+        // Delays are played rather than positions, they differ at the skipped silence of the end
+        tick = track[0].absPos;
+
+        for(size_t row = 0; row < track.size(); ++row)
+        {
+            entry.tick = tick;
+            entry.time = track[row].time;
+            entry.row = row;
+            m_eventsTimeline[total++] = entry;
+            tick += track[row].delay;
+        }
+
+        entry.tick = tick;
+        entry.time = track.back().time + track.back().timeDelay;
+        entry.row = track.size();
+        m_eventsTimeline[total++] = entry;
+    }
+
+    runs[runsCount] = total;
+
+    // Merge neighbour runs until one left, the left run wins on equal ticks to keep the tracks order
+    src = m_eventsTimeline.data;
+    dst = merged.data;
+
+    while(runsCount > 1)
+    {
+        size_t r, outRuns = 0;
+
+        for(r = 0; r < runsCount; r += 2)
+        {
+            size_t a = runs[r], aEnd = runs[r + 1], o = runs[r];
+            size_t b = aEnd, bEnd = (r + 1 < runsCount) ? runs[r + 2] : aEnd;
+
+            while(a < aEnd && b < bEnd)
+                dst[o++] = (src[b].tick < src[a].tick) ? src[b++] : src[a++];
+            while(a < aEnd)
+                dst[o++] = src[a++];
+            while(b < bEnd)
+                dst[o++] = src[b++];
+
+            runs[outRuns++] = runs[r];
+        }
+
+        runs[outRuns] = total;
+        runsCount = outRuns;
+
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if(src != m_eventsTimeline.data)
+        std::memcpy(m_eventsTimeline.data, src, total * sizeof(EventsTimelineEntry));
+
+    m_eventsTimelineEnabled = true;
+}
+
 #endif /* BW_MIDISEQ_READ_SMF_IMPL_HPP */
@@ -155,8 +155,9 @@ struct miditrack_arr
 
     void push_back(const T &value)
     {
+        // Grow twice to keep the count of reallocations logarithmic
         if(size + 1 >= capacity)
-            reserve_extend(4096);
+            reserve_extend(capacity > 4096 ? capacity : 4096);
 
         if(is_class)
             new (data + size) T(value);
@@ -169,7 +170,7 @@ struct miditrack_arr
     void push_back_list(const T*in_data, size_t count)
     {
         if(size + count >= capacity)
-            reserve_extend(count + 1024);
+            reserve_extend(count + (capacity > 1024 ? capacity : 1024));
 
         for(size_t i = 0; i < count; ++i)
         {
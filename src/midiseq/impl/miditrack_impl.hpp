@@ -362,7 +362,12 @@ void BW_MidiSequencer::sortEvents(MidiTrackRow &row, MidiEventsList &eventsBank,
 BW_MidiSequencer::MidiTrackState::MidiTrackState() :
     deviceMask(BW_MidiSequencer::Device_ANY),
     disabled(false),
-    stateRestoreSetup(TRACK_RESTORE_DEFAULT)
+    stateRestoreSetup(TRACK_RESTORE_DEFAULT),
+    dueTick(0),
+    rowBeginSerial(0),
+    rowBeginPos(0),
+    rowBeginDueTick(0),
+    rowBeginLastHandledEvent(0)
 {
     loop.reset();
     loop.invalidLoop = false;
@@ -34,21 +34,21 @@
 #   include "dpmi_alloc.hpp"
 #endif
 
+/**
+ * @brief Rows of one track stored one after another in a single memory block
+ *
+ * Rows are referred by their indices, the index equal to size() is the end
+ * of the track. The block grows twice when it's full, so loading of the track
+ * takes only a few allocations, and the playback walks the memory in order.
+ */
 template<class T>
 struct TrackQueueList_t
 {
     void dpmi_lock_begin() {}
 
-    struct Leaf_t
-    {
-        Leaf_t *prev;
-        Leaf_t *next;
-        T data;
-    };
-
-    Leaf_t *m_begin;
-    Leaf_t *m_last;
+    T *m_data;
     size_t m_size;
+    size_t m_capacity;
 
     size_t size() const
     {
@@ -61,7 +61,7 @@ struct TrackQueueList_t
     }
 
     TrackQueueList_t() :
-        m_begin(NULL), m_last(NULL), m_size(0)
+        m_data(NULL), m_size(0), m_capacity(0)
     {}
 
     ~TrackQueueList_t()
@@ -69,64 +69,47 @@ struct TrackQueueList_t
         clean();
     }
 
-    T &make()
+    T &operator[](size_t i)
     {
-        Leaf_t *prev_last = m_last;
-
-        if(!m_begin && !m_last)
-        {
-            m_last = m_begin = (Leaf_t*)malloc(sizeof(Leaf_t));
-            memset(m_last, 0, sizeof(Leaf_t));
-        }
-        else
-        {
-            m_last->next = (Leaf_t*)malloc(sizeof(Leaf_t));
-            memset(m_last->next, 0, sizeof(Leaf_t));
-            m_last->next->prev = m_last;
-            m_last = m_last->next;
-        }
-
-#if defined(__DJGPP__)
-        dpmi_allocator_impl::dpmi_lock_memory(m_last, sizeof(Leaf_t));
-#endif
-
-        m_last->prev = prev_last;
-        ++m_size;
-
-        return m_last->data;
+        return m_data[i];
     }
 
-    T &makeAt(Leaf_t *pos)
+    const T &operator[](size_t i) const
     {
-        Leaf_t *cur = NULL;
-
-        if(!pos || (!m_begin && !m_last))
-            return make(); // Empty list!
+        return m_data[i];
+    }
 
-        cur = (Leaf_t*)malloc(sizeof(Leaf_t));
-        memset(cur, 0, sizeof(Leaf_t));
+    T &back()
+    {
+        return m_data[m_size - 1];
+    }
 
-        if(pos->next)
-            pos->next->prev = cur;
+    const T &back() const
+    {
+        return m_data[m_size - 1];
+    }
 
-        cur->next = pos->next;
-        pos->next = cur;
-        cur->prev = pos;
+    T &make()
+    {
+        if(m_size == m_capacity)
+        {
+            size_t capacity = m_capacity > 0 ? m_capacity * 2 : 64;
 
 #if defined(__DJGPP__)
-        dpmi_allocator_impl::dpmi_lock_memory(cur, sizeof(Leaf_t));
+            if(m_data)
+                dpmi_allocator_impl::dpmi_unlock_memory(m_data, m_capacity * sizeof(T));
 #endif
+            m_data = (T*)realloc(m_data, capacity * sizeof(T));
+            m_capacity = capacity;
 
-        memset(cur, 0, sizeof(Leaf_t));
-        ++m_size;
+#if defined(__DJGPP__)
+            dpmi_allocator_impl::dpmi_lock_memory(m_data, m_capacity * sizeof(T));
+#endif
+        }
 
-        return cur->data;
-    }
+        T &dst = m_data[m_size++];
+        memset(&dst, 0, sizeof(T));
 
-    T &insert(Leaf_t *pos, const T &o)
-    {
-        T &dst = makeAt(pos);
-        memcpy(&dst, &o, sizeof(T));
         return dst;
     }
 
@@ -136,54 +119,19 @@ struct TrackQueueList_t
         memcpy(&dst, &o, sizeof(T));
     }
 
-    // TODO: Verify the correctness of this!
-    Leaf_t *erase(Leaf_t *it)
-    {
-        Leaf_t *ret = NULL, *old_prev, *old_next;
-
-        old_prev = it->prev;
-        old_next = it->next;
-
-        if(old_prev)
-            old_prev->next = old_next;
-        else
-            m_begin = old_next;
-
-        if(old_next)
-            ret = old_next->prev = old_prev;
-        else
-            m_last = old_prev;
-
-#if defined(__DJGPP__)
-        dpmi_allocator_impl::dpmi_unlock_memory(it, sizeof(Leaf_t));
-#endif
-        free(it);
-
-        --m_size;
-
-        return ret;
-    }
-
     void clean()
     {
-        if(m_begin && m_last && m_size > 0)
+        if(m_data)
         {
-            Leaf_t *cur;
-
-            while(m_size > 0)
-            {
-                cur = m_begin;
-                m_begin = cur->next;
-
 #if defined(__DJGPP__)
-                dpmi_allocator_impl::dpmi_unlock_memory(cur, sizeof(Leaf_t));
+            dpmi_allocator_impl::dpmi_unlock_memory(m_data, m_capacity * sizeof(T));
 #endif
-                free(cur);
-                --m_size;
-            }
-
-            m_last = NULL;
+            free(m_data);
         }
+
+        m_data = NULL;
+        m_size = 0;
+        m_capacity = 0;
     }
 
     void dpmi_lock_end() {}
@@ -0,0 +1,146 @@
+/*
+ * BW_Midi_Sequencer - MIDI Sequencer for C++
+ *
+ * Copyright (c) 2015-2026 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef BW_MIDISEQ_NEXT_EVENTS_IMPL_HPP
+#define BW_MIDISEQ_NEXT_EVENTS_IMPL_HPP
+
+#include "../midi_sequencer.hpp"
+
+/*
+ * Queue ticks are compared as distances from the current schedule tick:
+ * delays of finished tracks may be wrapped, and all distances get reduced
+ * equally while the schedule goes on, so the order of the heap persists.
+ */
+
+bool BW_MidiSequencer::nextEventsEarlier(const NextEventsEntry &a, const NextEventsEntry &b) const
+{
+    const uint64_t da = a.tick - m_scheduleTick;
+    const uint64_t db = b.tick - m_scheduleTick;
+    return da < db || (da == db && a.track < b.track);
+}
+
+void BW_MidiSequencer::nextEventsSiftUp(size_t i)
+{
+    const NextEventsEntry e = m_nextEvents[i];
+
+    while(i > 0)
+    {
+        const size_t parent = (i - 1) / 2;
+        if(!nextEventsEarlier(e, m_nextEvents[parent]))
+            break;
+
+        m_nextEvents[i] = m_nextEvents[parent];
+        m_nextEventsIndex[m_nextEvents[i].track] = i;
+        i = parent;
+    }
+
+    m_nextEvents[i] = e;
+    m_nextEventsIndex[e.track] = i;
+}
+
+void BW_MidiSequencer::nextEventsSiftDown(size_t i)
+{
+    const NextEventsEntry e = m_nextEvents[i];
+
+    for(;;)
+    {
+        size_t child = i * 2 + 1;
+        if(child >= m_nextEventsCount)
+            break;
+
+        if(child + 1 < m_nextEventsCount && nextEventsEarlier(m_nextEvents[child + 1], m_nextEvents[child]))
+            ++child;
+
+        if(!nextEventsEarlier(m_nextEvents[child], e))
+            break;
+
+        m_nextEvents[i] = m_nextEvents[child];
+        m_nextEventsIndex[m_nextEvents[i].track] = i;
+        i = child;
+    }
+
+    m_nextEvents[i] = e;
+    m_nextEventsIndex[e.track] = i;
+}
+
+void BW_MidiSequencer::nextEventsRemove(size_t i)
+{
+    m_nextEventsIndex[m_nextEvents[i].track] = ~static_cast<size_t>(0);
+
+    if(--m_nextEventsCount == i)
+        return;
+
+    const size_t moved = m_nextEvents[m_nextEventsCount].track;
+    m_nextEvents[i] = m_nextEvents[m_nextEventsCount];
+    nextEventsSiftUp(i);
+    nextEventsSiftDown(m_nextEventsIndex[moved]);
+}
+
+size_t BW_MidiSequencer::nextEventsPop()
+{
+    const size_t tk = m_nextEvents[0].track;
+    nextEventsRemove(0);
+    return tk;
+}
+
+void BW_MidiSequencer::nextEventsUpdate(size_t tk)
+{
+    const size_t i = m_nextEventsIndex[tk];
+    uint64_t tick;
+
+    if(m_trackState[tk].duratedNotes.expired_count > 0)
+        tick = m_scheduleTick; // Note-Offs are waiting to be sent
+    else if(m_currentPosition.track[tk].lastHandledEvent >= 0)
+        tick = m_trackState[tk].dueTick;
+    else
+    {
+        if(i < m_nextEventsCount)
+            nextEventsRemove(i);
+        return;
+    }
+
+    if(i < m_nextEventsCount)
+    {
+        m_nextEvents[i].tick = tick;
+        nextEventsSiftUp(i);
+        nextEventsSiftDown(m_nextEventsIndex[tk]);
+    }
+    else
+    {
+        m_nextEvents[m_nextEventsCount].tick = tick;
+        m_nextEvents[m_nextEventsCount].track = tk;
+        nextEventsSiftUp(m_nextEventsCount++);
+    }
+}
+
+void BW_MidiSequencer::nextEventsClear()
+{
+    for(size_t i = 0; i < m_nextEventsCount; ++i)
+        m_nextEventsIndex[m_nextEvents[i].track] = ~static_cast<size_t>(0);
+
+    m_nextEventsCount = 0;
+}
+
+#endif /* BW_MIDISEQ_NEXT_EVENTS_IMPL_HPP */
@@ -341,12 +341,11 @@ void BW_MidiSequencer::handleEvent(size_t track, const BW_MidiSequencer::MidiEve
         return;
 
     case MidiEvent::T_NOTEON_DURATED: // Note on with duration
-        if(duratedNoteAlloc(track, &note)) // Do call true Note ON only when note OFF is successfully added into the list!
+        if(duratedNoteAlloc(track, m_scheduleTick + readBEint(evt.data_loc + 2, 3), &note)) // Do call true Note ON only when note OFF is successfully added into the list!
         {
             note->channel = evt.channel;
             note->note = evt.data_loc[0];
             note->velocity = evt.data_loc[1];
-            note->ttl = readBEint(evt.data_loc + 2, 3);
             m_interface->rt_noteOn(m_interface->rtUserData, static_cast<uint8_t>(midCh), evt.data_loc[0], evt.data_loc[1]);
         }
         return;
@@ -386,13 +385,29 @@ void BW_MidiSequencer::handleEvent(size_t track, const BW_MidiSequencer::MidiEve
 void BW_MidiSequencer::processDuratedNotes(size_t track, int32_t &status)
 {
     DuratedNotesCache &cache = m_trackState[track].duratedNotes;
+    size_t i, j;
 
-    if(cache.notes_count == 0)
+    if(cache.expired_count == 0)
         return; // Nothing to do!
 
-    for(size_t i = 0; i < cache.notes_count; )
+    // Sort indices of expired notes
+    for(i = 1; i < cache.expired_count; ++i)
     {
-        if(cache.notes[i].ttl <= 0)
+        const uint8_t index = cache.expired[i];
+        for(j = i; j > 0 && cache.expired[j - 1] > index; --j)
+            cache.expired[j] = cache.expired[j - 1];
+        cache.expired[j] = index;
+    }
+
+    /*
+     * Send Note-OFFs in order of the list, the last note moved into the
+     * place of the popped one goes next when it's expired too
+     */
+    for(j = 0; j < cache.expired_count; ++j)
+    {
+        i = cache.expired[j];
+
+        while(i < cache.notes_count && cache.notes[i].expired)
         {
             DuratedNote *n = &cache.notes[i];
 
@@ -402,21 +417,22 @@ void BW_MidiSequencer::processDuratedNotes(size_t track, int32_t &status)
             if(m_interface->rt_noteOffVel)
                 m_interface->rt_noteOffVel(m_interface->rtUserData, n->channel, n->note, n->velocity);
 
-            status = MidiEvent::T_NOTEOFF;
+            // Notes outliving their track must not bring the finished track back
+            if(status >= 0)
+                status = MidiEvent::T_NOTEOFF;
 
             duratedNotePop(track, i);
         }
-        else
-            ++i;
     }
+
+    cache.expired_count = 0;
 }
 
-void BW_MidiSequencer::handleLoopStart(LoopRuntimeState &state, LoopState &loop, Position::TrackInfo &tk, bool glob)
+void BW_MidiSequencer::handleLoopStart(LoopRuntimeState &state, LoopState &loop, const MidiTrackRow &row, bool glob)
 {
     if(loop.caughtStackStart)
     {
-        // assert(tk.pos);
-        if(glob && m_interface->onloopStart && (m_loopStartTime >= tk.pos->data.time)) // Loop Start hook
+        if(glob && m_interface->onloopStart && (m_loopStartTime >= row.time)) // Loop Start hook
             m_interface->onloopStart(m_interface->onloopStart_userData);
 
         state.numStackLoopStarts++;
@@ -430,7 +446,7 @@ void BW_MidiSequencer::handleLoopStart(LoopRuntimeState &state, LoopState &loop,
     }
 }
 
-bool BW_MidiSequencer::handleLoopEnd(LoopRuntimeState &state, LoopState &loop, Position::TrackInfo &tk, bool glob)
+bool BW_MidiSequencer::handleLoopEnd(LoopRuntimeState &state, LoopState &loop, const MidiTrackRow &row, bool glob)
 {
     if(loop.caughtBranchJump)
     {
@@ -449,7 +465,7 @@ bool BW_MidiSequencer::handleLoopEnd(LoopRuntimeState &state, LoopState &loop, P
         {
             loop.caughtStackEnd = false;
             state.numStackLoopEnds++;
-            state.stackLoopEndsTime = tk.pos->data.time;
+            state.stackLoopEndsTime = row.time;
         }
 
         if(glob)
@@ -461,10 +477,12 @@ bool BW_MidiSequencer::handleLoopEnd(LoopRuntimeState &state, LoopState &loop, P
     return false;
 }
 
-bool BW_MidiSequencer::processLoopPoints(LoopRuntimeState &state, LoopState &loop, bool glob, size_t tk, const Position &pos)
+bool BW_MidiSequencer::processLoopPoints(LoopRuntimeState &state, LoopState &loop, bool glob, size_t tk)
 {
     if(state.numStackLoopStarts > 0)
     {
+        const Position &pos = rowBeginPosition();
+
         while(state.numStackLoopStarts > 0)
         {
             loop.stackUp();
@@ -582,7 +600,7 @@ void BW_MidiSequencer::restoreTrackState(size_t track)
         else if(chan != 0xFF)
             m_interface->rt_controllerChange(m_interface->rtUserData, chan, 123, 0);
 
-        state.duratedNotes.notes_count = 0;
+        duratedNoteClearTrack(track);
     }
 
     if((m_stateRestoreSetup & TRACK_RESTORE_ALL_CC) != 0)
@@ -623,14 +641,20 @@ void BW_MidiSequencer::restoreTrackState(size_t track)
 
 void BW_MidiSequencer::jumpToPosition(size_t track, const Position *pos)
 {
+    // Saved track states of the row begin are about to be overwritten
+    if(m_rowBegin.recording)
+        rowBeginPosition();
+
     if(track == BRANCH_GLOBAL_TRACK)
     {
         m_currentPosition = *pos;
+        m_scheduleSynced = false;
         restoreSongState();
     }
     else
     {
         m_currentPosition.track[track] = pos->track[0];
+        m_trackState[track].dueTick = m_scheduleTick + pos->track[0].delay;
         // Reset the time (lesser evil than time going to infinite!)
         m_currentPosition.absTickPosition = pos->absTickPosition;
         m_currentPosition.absTimePosition = pos->absTimePosition;
@@ -657,105 +681,173 @@ bool BW_MidiSequencer::jumpToBranch(uint32_t dstTrack, uint16_t dstBranch)
     return false;
 }
 
-bool BW_MidiSequencer::processEvents(bool isSeek)
+void BW_MidiSequencer::beginRowJournal()
 {
-    if(m_currentPosition.track_size == 0)
-        m_atEnd = true; // No MIDI track data to play
+    m_rowBegin.wait = m_currentPosition.wait;
+    m_rowBegin.absTimePosition = m_currentPosition.absTimePosition;
+    m_rowBegin.absTickPosition = m_currentPosition.absTickPosition;
+    m_rowBegin.began = m_currentPosition.began;
+    m_rowBegin.scheduleTick = m_scheduleTick;
+    m_rowBegin.recording = true;
+    m_rowBegin.snapshotReady = false;
+    // Tracks get journaled by journalTrack() once the row touches them
+    ++m_rowBegin.serial;
+}
 
-    if(m_atEnd)
-        return false;   // No more events in the queue
+void BW_MidiSequencer::journalTrack(size_t tk)
+{
+    MidiTrackState &trackState = m_trackState[tk];
 
-    m_loop.caughtEnd = false;
-    const size_t        trackCount = m_currentPosition.track_size;
-    LoopRuntimeState    loopState, loopStateLoc;
-    Tempo_t t;
+    if(trackState.rowBeginSerial == m_rowBegin.serial)
+        return; // Already journaled by this row
 
-    m_currentPositionBegin = m_currentPosition;
+    const Position::TrackInfo &track = m_currentPosition.track[tk];
+    trackState.rowBeginSerial = m_rowBegin.serial;
+    trackState.rowBeginPos = track.pos;
+    trackState.rowBeginDueTick = trackState.dueTick;
+    trackState.rowBeginLastHandledEvent = track.lastHandledEvent;
+}
 
-    std::memset(&loopState, 0, sizeof(loopState));
+const BW_MidiSequencer::Position &BW_MidiSequencer::rowBeginPosition()
+{
+    if(m_rowBegin.snapshotReady)
+        return m_currentPositionBegin;
 
-#ifdef DEBUG_TIME_CALCULATION
-    double maxTime = 0.0;
-#endif
+    const size_t trackCount = m_currentPosition.track_size;
+
+    // Saved track states aren't changed by the row until a jump, which builds the snapshot first
+    m_currentPositionBegin.tracks_resize(trackCount);
+    if(trackCount > 0)
+        std::memcpy(m_currentPositionBegin.track, m_currentPosition.track, trackCount * sizeof(Position::TrackInfo));
+
+    m_currentPositionBegin.wait = m_rowBegin.wait;
+    m_currentPositionBegin.absTimePosition = m_rowBegin.absTimePosition;
+    m_currentPositionBegin.absTickPosition = m_rowBegin.absTickPosition;
+    m_currentPositionBegin.began = m_rowBegin.began;
 
     for(size_t tk = 0; tk < trackCount; ++tk)
     {
-        Position::TrackInfo &track = m_currentPosition.track[tk];
-        // MidiTrackQueue::Leaf_t* end = m_trackData[tk].end();
-        MidiTrackState &trackState = m_trackState[tk];
-        LoopState &trackLoop = trackState.loop;
+        Position::TrackInfo &track = m_currentPositionBegin.track[tk];
+        const MidiTrackState &trackState = m_trackState[tk];
 
-        std::memset(&loopStateLoc, 0, sizeof(loopStateLoc));
+        if(trackState.rowBeginSerial == m_rowBegin.serial)
+        {
+            track.pos = trackState.rowBeginPos;
+            track.delay = trackState.rowBeginDueTick - m_rowBegin.scheduleTick;
+            track.lastHandledEvent = trackState.rowBeginLastHandledEvent;
+        }
+        else
+            track.delay = trackState.dueTick - m_rowBegin.scheduleTick;
+    }
 
-        // Process note-OFFs
-        processDuratedNotes(tk, track.lastHandledEvent);
+    m_rowBegin.snapshotReady = true;
+    return m_currentPositionBegin;
+}
 
-        if((track.lastHandledEvent >= 0) && (track.delay <= 0))
-        {
-            // Check is an end of track has been reached
-            if(track.pos == NULL)
-            {
-                track.lastHandledEvent = -1;
-                break;
-            }
+bool BW_MidiSequencer::processTrackRow(size_t tk, bool isSeek, LoopRuntimeState &loopState)
+{
+    Position::TrackInfo &track = m_currentPosition.track[tk];
+    MidiTrackState &trackState = m_trackState[tk];
+    const MidiTrackRow &row = m_trackData[tk][track.pos];
+    LoopState &trackLoop = trackState.loop;
+    LoopRuntimeState loopStateLoc;
 
-            // Handle event
-            for(size_t i = track.pos->data.events_begin; i < track.pos->data.events_end; ++i)
-            {
-                const MidiEvent &evt = m_eventBank[i];
+    std::memset(&loopStateLoc, 0, sizeof(loopStateLoc));
+
+    // Handle event
+    for(size_t i = row.events_begin; i < row.events_end; ++i)
+    {
+        const MidiEvent &evt = m_eventBank[i];
 #ifdef ENABLE_BEGIN_SILENCE_SKIPPING
-                if(!m_currentPosition.began && (evt.type == MidiEvent::T_NOTEON))
-                    m_currentPosition.began = true;
+        if(!m_currentPosition.began && (evt.type == MidiEvent::T_NOTEON))
+            m_currentPosition.began = true;
 #endif
-                if(isSeek && (evt.type == MidiEvent::T_NOTEON || evt.type == MidiEvent::T_NOTEON_DURATED))
-                    continue;
+        if(isSeek && (evt.type == MidiEvent::T_NOTEON || evt.type == MidiEvent::T_NOTEON_DURATED))
+            continue;
 
-                handleEvent(tk, evt, track.lastHandledEvent);
+        handleEvent(tk, evt, track.lastHandledEvent);
 
-                // Global non-stacked loop start
-                if(m_loop.caughtStart)
-                {
-                    if(m_interface->onloopStart) // Loop Start hook
-                        m_interface->onloopStart(m_interface->onloopStart_userData);
+        // Global non-stacked loop start
+        if(m_loop.caughtStart)
+        {
+            if(m_interface->onloopStart) // Loop Start hook
+                m_interface->onloopStart(m_interface->onloopStart_userData);
 
-                    ++loopState.numGlobLoopStarts;
-                    m_loop.caughtStart = false;
-                }
+            ++loopState.numGlobLoopStarts;
+            m_loop.caughtStart = false;
+        }
 
-                // Global stacked loop start
-                handleLoopStart(loopState, m_loop, track, true);
-                // Local stacked loop start
-                handleLoopStart(loopStateLoc, trackLoop, track, false);
+        // Global stacked loop start
+        handleLoopStart(loopState, m_loop, row, true);
+        // Local stacked loop start
+        handleLoopStart(loopStateLoc, trackLoop, row, false);
 
-                if(handleLoopEnd(loopStateLoc, trackLoop, track, false))
-                    break;
+        if(handleLoopEnd(loopStateLoc, trackLoop, row, false))
+            break;
 
-                if(handleLoopEnd(loopState, m_loop, track, true))
-                    break;
-            }
+        if(handleLoopEnd(loopState, m_loop, row, true))
+            break;
+    }
+
+    // Read next event time (unless the track just ended)
+    if(track.lastHandledEvent >= 0)
+    {
+        trackState.dueTick += row.delay;
+        ++track.pos;
+    }
+
+    // Register global loop start position
+    if(loopState.numGlobLoopStarts > 0 && m_loopBeginPosition.absTimePosition <= 0.0)
+        m_loopBeginPosition = rowBeginPosition();
+
+    // Process local loop
+    if(processLoopPoints(loopStateLoc, trackLoop, false, tk))
+        return false; // Done with this track for now
+
+    return loopState.doLoopJump;
+}
+
+bool BW_MidiSequencer::processTimelineRow(bool isSeek, LoopRuntimeState &loopState, uint64_t &shortestDelay)
+{
+    const size_t count = m_eventsTimeline.size;
+    const EventsTimelineEntry *entries = m_eventsTimeline.data;
+    const uint64_t tick = m_currentPosition.absTickPosition;
+    size_t handledTrack = ~static_cast<size_t>(0);
+    size_t i;
 
 #ifdef DEBUG_TIME_CALCULATION
-            if(maxTime < track.pos->time)
-                maxTime = track.pos->time;
+    double maxTime = 0.0;
 #endif
-            // Read next event time (unless the track just ended)
-            if(track.lastHandledEvent >= 0)
-            {
-                track.delay += track.pos->data.delay;
-                track.pos = track.pos->next;
-            }
 
-            // Register global loop start position
-            if(loopState.numGlobLoopStarts > 0 && m_loopBeginPosition.absTimePosition <= 0.0)
-                m_loopBeginPosition = m_currentPositionBegin;
+    /*
+     * Rows of the same tick are sorted by tracks, and every track handles
+     * one its row per call, the same way as the next events queue handles them
+     */
+    for(i = m_eventsTimelineCursor; i < count && entries[i].tick == tick; ++i)
+    {
+        const EventsTimelineEntry &e = entries[i];
+        Position::TrackInfo &track = m_currentPosition.track[e.track];
+
+        if(e.track == handledTrack || track.lastHandledEvent < 0 || track.pos != e.row)
+            continue; // Already handled, finished, or not the current row of the track
 
-            // Process local loop
-            if(processLoopPoints(loopStateLoc, trackLoop, false, tk, m_currentPositionBegin))
-                continue; // Done with this track for now
+        journalTrack(e.track);
 
-            if(loopState.doLoopJump)
-                break;
+        // Check is an end of track has been reached
+        if(track.pos >= m_trackData[e.track].size())
+        {
+            track.lastHandledEvent = -1;
+            break;
         }
+
+#ifdef DEBUG_TIME_CALCULATION
+        if(maxTime < e.time)
+            maxTime = e.time;
+#endif
+        handledTrack = e.track;
+
+        if(processTrackRow(e.track, isSeek, loopState))
+            break;
     }
 
 #ifdef DEBUG_TIME_CALCULATION
@@ -764,46 +856,166 @@ bool BW_MidiSequencer::processEvents(bool isSeek)
     std::fflush(stdout);
 #endif
 
-    // Find a shortest delay from all track
-    uint64_t shortestDelay = 0;
-    bool     shortestDelayNotFound = true;
+    // Rows left at this tick will be handled by the next call without a delay
+    for(i = m_eventsTimelineCursor; i < count && entries[i].tick == tick; ++i)
+    {
+        const Position::TrackInfo &track = m_currentPosition.track[entries[i].track];
+        if(track.lastHandledEvent >= 0 && track.pos == entries[i].row)
+        {
+            shortestDelay = 0;
+            return true;
+        }
+    }
 
-    for(size_t tk = 0; tk < trackCount; ++tk)
+    // Skip rows of tracks which got finished before reaching them
+    while(i < count && m_currentPosition.track[entries[i].track].lastHandledEvent < 0)
+        ++i;
+
+    m_eventsTimelineCursor = i;
+
+    if(i >= count)
+        return false;
+
+    shortestDelay = entries[i].tick - tick;
+
+    return true;
+}
+
+bool BW_MidiSequencer::processQueuedTracks(bool isSeek, LoopRuntimeState &loopState, uint64_t &shortestDelay)
+{
+    size_t dueCount = 0, i;
+    uint64_t expiry;
+    bool stop = false, found = false;
+
+#ifdef DEBUG_TIME_CALCULATION
+    double maxTime = 0.0;
+#endif
+
+    // Tracks having expired notes get queued right now
+    duratedNotesExpire(m_scheduleTick);
+
+    // Take all tracks having a row or expired notes right now, the queue gives them in the tracks order
+    while(m_nextEventsCount > 0 && m_nextEvents[0].tick == m_scheduleTick)
+        m_dueTracks[dueCount++] = nextEventsPop();
+
+    for(i = 0; i < dueCount && !stop; ++i)
     {
+        const size_t tk = m_dueTracks[i];
         Position::TrackInfo &track = m_currentPosition.track[tk];
-        DuratedNotesCache &timedNotes = m_trackState[tk].duratedNotes;
 
-        // Normal events
-        if((track.lastHandledEvent >= 0) && (shortestDelayNotFound || track.delay < shortestDelay))
-        {
-            shortestDelay = track.delay;
-            shortestDelayNotFound = false;
-        }
+        journalTrack(tk);
+
+        // Process note-OFFs
+        processDuratedNotes(tk, track.lastHandledEvent);
 
-        // Note events with duration
-        for(size_t i = 0; i < timedNotes.notes_count; ++i)
+        if((track.lastHandledEvent >= 0) && (m_trackState[tk].dueTick == m_scheduleTick))
         {
-            DuratedNote &n = timedNotes.notes[i];
-            if(n.ttl <= 0)
+            // Check is an end of track has been reached
+            if(track.pos >= m_trackData[tk].size())
             {
-                shortestDelay = 0; // Just zero!
-                shortestDelayNotFound = false;
+                track.lastHandledEvent = -1;
+                stop = true;
             }
-            else if(shortestDelayNotFound || static_cast<uint64_t>(n.ttl) < shortestDelay)
+            else
             {
-                shortestDelay = n.ttl; // Extra tick
-                shortestDelayNotFound = false;
+#ifdef DEBUG_TIME_CALCULATION
+                if(maxTime < m_trackData[tk][track.pos].time)
+                    maxTime = m_trackData[tk][track.pos].time;
+#endif
+                stop = processTrackRow(tk, isSeek, loopState);
             }
         }
     }
 
-    // Schedule the next playevent to be processed after that delay
+#ifdef DEBUG_TIME_CALCULATION
+    std::fprintf(stdout, "                              \r");
+    std::fprintf(stdout, "Time: %10f; Audio: %10f\r", maxTime, m_currentPosition.absTimePosition);
+    std::fflush(stdout);
+#endif
+
+    // Put taken tracks back, those left unhandled will be taken again by the next call
+    for(i = 0; i < dueCount; ++i)
+        nextEventsUpdate(m_dueTracks[i]);
+
+    if(m_nextEventsCount > 0)
+    {
+        shortestDelay = m_nextEvents[0].tick - m_scheduleTick;
+        found = true;
+    }
+
+    if(duratedNotesEarliest(expiry) && (!found || expiry - m_scheduleTick < shortestDelay))
+    {
+        shortestDelay = expiry - m_scheduleTick;
+        found = true;
+    }
+
+    return found;
+}
+
+void BW_MidiSequencer::syncSchedule()
+{
+    const size_t trackCount = m_currentPosition.track_size;
+
+    // Delays of the position are counted from the current tick
     for(size_t tk = 0; tk < trackCount; ++tk)
+        m_trackState[tk].dueTick = m_scheduleTick + m_currentPosition.track[tk].delay;
+
+    if(m_eventsTimelineEnabled)
     {
-        m_currentPosition.track[tk].delay -= shortestDelay;
-        duratedNoteTick(tk, shortestDelay);
+        const uint64_t tick = m_currentPosition.absTickPosition;
+        size_t lo = 0, hi = m_eventsTimeline.size;
+
+        // Find the first row at the tick of the position
+        while(lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if(m_eventsTimeline[mid].tick < tick)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        m_eventsTimelineCursor = lo;
+    }
+    else
+    {
+        nextEventsClear();
+        for(size_t tk = 0; tk < trackCount; ++tk)
+            nextEventsUpdate(tk);
     }
 
+    m_scheduleSynced = true;
+}
+
+bool BW_MidiSequencer::processEvents(bool isSeek)
+{
+    if(m_currentPosition.track_size == 0)
+        m_atEnd = true; // No MIDI track data to play
+
+    if(m_atEnd)
+        return false;   // No more events in the queue
+
+    m_loop.caughtEnd = false;
+    LoopRuntimeState    loopState;
+    Tempo_t t;
+    uint64_t shortestDelay = 0;
+    bool     shortestDelayNotFound;
+
+    if(!m_scheduleSynced)
+        syncSchedule();
+
+    beginRowJournal();
+
+    std::memset(&loopState, 0, sizeof(loopState));
+
+    if(m_eventsTimelineEnabled)
+        shortestDelayNotFound = !processTimelineRow(isSeek, loopState, shortestDelay);
+    else
+        shortestDelayNotFound = !processQueuedTracks(isSeek, loopState, shortestDelay);
+
+    // Schedule the next playevent to be processed after that delay
+    m_scheduleTick += shortestDelay;
+
     tempo_mul(&t, &m_tempo, shortestDelay);
 
 #ifdef ENABLE_BEGIN_SILENCE_SKIPPING
@@ -815,9 +1027,12 @@ bool BW_MidiSequencer::processEvents(bool isSeek)
     }
 
     if(loopState.numGlobLoopStarts > 0 && m_loopBeginPosition.absTimePosition <= 0.0)
-        m_loopBeginPosition = m_currentPositionBegin;
+        m_loopBeginPosition = rowBeginPosition();
+
+    // Jumps below happen after loop points took the row begin, it's not needed anymore
+    m_rowBegin.recording = false;
 
-    if(processLoopPoints(loopState, m_loop, true, 0, m_currentPositionBegin))
+    if(processLoopPoints(loopState, m_loop, true, 0))
         return true; // When loop jump happen, quit the function
 
     if(shortestDelayNotFound || m_loop.caughtEnd)
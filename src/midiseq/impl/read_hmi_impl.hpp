@@ -1410,7 +1410,7 @@ bool BW_MidiSequencer::parseHMI(FileAndMemReader &fr)
             {
                 if(!m_trackData[tk_v].empty())
                 {
-                    MidiTrackRow &previous = m_trackData[tk_v].m_last->data;
+                    MidiTrackRow &previous = m_trackData[tk_v].back();
                     previous.delay = 0;
                     previous.timeDelay = 0;
                 }
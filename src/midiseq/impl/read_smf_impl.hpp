@@ -201,7 +201,7 @@ bool BW_MidiSequencer::smf_buildOneTrack(FileAndMemReader &fr,
         {
             if (!m_trackData[track_idx].empty())
             {
-                MidiTrackRow &previous = m_trackData[track_idx].m_last->data;
+                MidiTrackRow &previous = m_trackData[track_idx].back();
                 previous.delay = 0;
                 previous.timeDelay = 0;
             }
@@ -463,19 +463,61 @@ private:
      */
     struct DuratedNote
     {
-        int64_t ttl;
+        //! Schedule tick when the note expires
+        uint64_t expiry;
+        //! Next note in the same slot of the durated notes wheel
+        uint32_t wheelNext;
+        //! Previous note in the same slot of the durated notes wheel
+        uint32_t wheelPrev;
         uint8_t channel;
         uint8_t note;
         uint8_t velocity;
+        //! Is the note taken out of the wheel and waiting for its Note-Off
+        uint8_t expired;
     };
 
+    //! Maximum count of active durated notes per track
+    static const size_t DURATED_NOTES_MAX = 128;
+    //! No note, the end of the wheel's slot list
+    static const uint32_t DURATED_NOTE_NONE = 0xFFFFFFFF;
+
     /**
      * @brief The per-track storage of active durated notes before they will expire.
      */
     struct DuratedNotesCache
     {
-        DuratedNote notes[128];
+        DuratedNote notes[DURATED_NOTES_MAX];
         size_t notes_count;
+        //! Indices of expired notes waiting for the track to send their Note-Offs
+        uint8_t expired[DURATED_NOTES_MAX];
+        size_t expired_count;
+    };
+
+    //! Count of levels of the durated notes wheel, every level takes 6 bits of the expiry tick
+    static const size_t DURATED_WHEEL_LEVELS = 11;
+    //! Count of slots per level of the durated notes wheel
+    static const size_t DURATED_WHEEL_SLOTS = 64;
+
+    /**
+     * @brief Hierarchical timing wheel of durated notes of all tracks keyed by their expiry ticks
+     *
+     * The level of the note is the highest 6-bit group of its expiry tick which
+     * differs from the wheel's tick, the slot is the value of that group. Notes of
+     * the reached slot get moved to lower levels once the wheel turns into it, so
+     * expiring notes and finding the earliest expiry cost nothing per active note.
+     */
+    struct DuratedNotesWheel
+    {
+        //! Tick the wheel is turned to, no notes in the wheel expire earlier
+        uint64_t tick;
+        //! Count of notes in the wheel
+        size_t count;
+        //! Masks of non-empty slots per level
+        uint64_t occupied[DURATED_WHEEL_LEVELS];
+        //! First note of every slot (the track index multiplied by DURATED_NOTES_MAX plus the note index)
+        uint32_t head[DURATED_WHEEL_LEVELS][DURATED_WHEEL_SLOTS];
+        //! Earliest expiry tick of notes of every slot
+        uint64_t earliest[DURATED_WHEEL_LEVELS][DURATED_WHEEL_SLOTS];
     };
 
     /**
@@ -526,8 +568,8 @@ private:
         //! Track information
         struct TrackInfo
         {
-            //! MIDI Events queue position iterator
-            MidiTrackQueue::Leaf_t *pos;
+            //! Index of the next row in the track, equal to the count of rows at the end of the track
+            size_t pos;
             //! Delay to next event in a track
             uint64_t delay;
             //! Last handled event type
@@ -754,11 +796,64 @@ private:
         TrackStateSaved state;
         //! Track's state restore setup
         uint32_t stateRestoreSetup;
+        //! Schedule tick of the next row, the track's delay is counted from it while playing
+        uint64_t dueTick;
+        //! Serial number of the row which journaled the track last time
+        uint64_t rowBeginSerial;
+        //! Events queue position at the beginning of the currently processing row
+        size_t rowBeginPos;
+        //! Schedule tick of the next row at the beginning of the currently processing row
+        uint64_t rowBeginDueTick;
+        //! Last handled event type at the beginning of the currently processing row
+        int32_t rowBeginLastHandledEvent;
 
         //! Constructor to initialize member variables
         MidiTrackState();
     };
 
+    /**
+     * @brief Journal of the current position at the beginning of the events row
+     *
+     * Only the cheap parts of the position are recorded for every row, tracks
+     * get journaled into MidiTrackState once the row touches them. The full
+     * snapshot with saved track states gets built only when loop points need it,
+     * or before a jump overwrites them.
+     */
+    struct RowBeginJournal
+    {
+        //! Waiting time before next event in seconds
+        double wait;
+        //! Absolute time position on the track in seconds
+        double absTimePosition;
+        //! Absolute MIDI tick position on the song
+        uint64_t absTickPosition;
+        //! Was track began playing
+        bool began;
+        //! Is the row being processed right now
+        bool recording;
+        //! Is the snapshot of the row begin built already
+        bool snapshotReady;
+        //! Schedule tick of the row
+        uint64_t scheduleTick;
+        //! Serial number of the row, tracks journaled by the row have the same
+        uint64_t serial;
+    };
+
+    /**
+     * @brief Row of one track in the merged time line of all tracks
+     */
+    struct EventsTimelineEntry
+    {
+        //! Absolute position in ticks where the row gets handled (sum of delays of previous rows)
+        uint64_t tick;
+        //! Absolute time position in seconds
+        double time;
+        //! Track of the row
+        size_t track;
+        //! Index of the row, or the count of rows of the track for its end after the last row
+        size_t row;
+    };
+
     /**********************************************************************************
      *                      Private variable fields definitions                       *
      **********************************************************************************/
@@ -795,8 +890,10 @@ private:
 
     //! Current position
     Position m_currentPosition;
-    //! A snapshot of the current position before events processing
+    //! A snapshot of the current position before events processing, built by rowBeginPosition() on demand
     Position m_currentPositionBegin;
+    //! Journal of the current position before events processing
+    RowBeginJournal m_rowBegin;
     //! Track begin position
     Position m_trackBeginPosition;
     //! Loop start point
@@ -831,6 +928,43 @@ private:
     //! List of available branches
     BranchesList m_branches;
 
+    typedef miditrack_arr<EventsTimelineEntry> EventsTimeline;
+    //! Rows of all tracks merged and sorted by ticks, then by tracks
+    EventsTimeline m_eventsTimeline;
+    //! Is the song played by the merged time line instead of the next events queue
+    bool m_eventsTimelineEnabled;
+    //! First entry of the merged time line which isn't passed yet
+    size_t m_eventsTimelineCursor;
+
+    /**
+     * @brief Track waiting in the next events queue
+     */
+    struct NextEventsEntry
+    {
+        //! Schedule tick of the track's next row, or the current one when its durated notes are expired
+        uint64_t tick;
+        //! Track index
+        size_t track;
+    };
+
+    typedef miditrack_arr<NextEventsEntry> NextEventsHeap;
+    typedef miditrack_arr<size_t> TracksList;
+    //! Binary min-heap of tracks keyed by their ticks, then by track indices
+    NextEventsHeap m_nextEvents;
+    //! Count of tracks in the next events queue
+    size_t m_nextEventsCount;
+    //! Place of every track in the next events queue, or ~0 when the track isn't queued
+    TracksList m_nextEventsIndex;
+    //! Tracks taken from the next events queue to be handled by the current row
+    TracksList m_dueTracks;
+
+    //! Ticks passed by the playback, due ticks of tracks and expiries of durated notes are counted by it
+    uint64_t m_scheduleTick;
+    //! Expiries of durated notes of all tracks
+    DuratedNotesWheel m_duratedWheel;
+    //! Do due ticks of tracks, the timeline cursor and the next events queue match the current position
+    bool m_scheduleSynced;
+
     //! Song-wide on-loop state restore setup
     uint32_t m_stateRestoreSetup;
 
@@ -919,10 +1053,74 @@ private:
      *                             Durated note                                       *
      **********************************************************************************/
 
-    bool duratedNoteAlloc(size_t track, DuratedNote **note);
+    /**
+     * @brief Add the durated note to the track and put it into the wheel
+     * @param track Track index
+     * @param expiry Schedule tick when the note expires
+     * @param note [_out] Added note to fill
+     * @return false if the track has too many active durated notes
+     */
+    bool duratedNoteAlloc(size_t track, uint64_t expiry, DuratedNote **note);
     void duratedNoteClear();
-    void duratedNoteTick(size_t track, int64_t ticks);
+    /**
+     * @brief Drop all durated notes of the track without sending their Note-Offs
+     * @param track Track index
+     */
+    void duratedNoteClearTrack(size_t track);
     void duratedNotePop(size_t track, size_t i);
+    DuratedNote &duratedNoteAt(uint32_t id);
+    /**
+     * @brief Find the place of the expiry tick in the wheel turned to its current tick
+     * @param expiry Expiry tick, not earlier than the wheel's tick
+     * @param level [_out] Level of the wheel
+     * @param slot [_out] Slot of the level
+     */
+    void duratedNotesSlot(uint64_t expiry, size_t &level, size_t &slot) const;
+    void duratedNoteLink(uint32_t id);
+    void duratedNoteUnlink(uint32_t id);
+    /**
+     * @brief Find the earliest expiry tick of notes in the wheel
+     * @param tick [_out] Earliest expiry tick
+     * @return false if the wheel is empty
+     */
+    bool duratedNotesEarliest(uint64_t &tick) const;
+    /**
+     * @brief Turn the wheel to the tick, no notes may expire before it
+     * @param tick Schedule tick
+     */
+    void duratedNotesTurn(uint64_t tick);
+    /**
+     * @brief Move notes expiring until the tick into expired lists of their tracks and queue those tracks
+     * @param tick Schedule tick
+     */
+    void duratedNotesExpire(uint64_t tick);
+
+
+    /**********************************************************************************
+     *                             Next events queue                                  *
+     **********************************************************************************/
+
+    /**
+     * @brief Is the track's next event earlier than the other track's one
+     * @param a Queued track
+     * @param b Other queued track
+     * @return true if the track's tick is earlier, or is the same with the lower track index
+     */
+    bool nextEventsEarlier(const NextEventsEntry &a, const NextEventsEntry &b) const;
+    void nextEventsSiftUp(size_t i);
+    void nextEventsSiftDown(size_t i);
+    void nextEventsRemove(size_t i);
+    /**
+     * @brief Take the track with the earliest next event out of the queue
+     * @return Track index
+     */
+    size_t nextEventsPop();
+    /**
+     * @brief Queue the track by its next row or expired durated notes, or take it out of the queue if it has none
+     * @param tk Track index
+     */
+    void nextEventsUpdate(size_t tk);
+    void nextEventsClear();
 
 
 
@@ -1008,6 +1206,15 @@ private:
                        uint64_t loopStartTicks = 0,
                        uint64_t loopEndTicks = 0);
 
+    /**
+     * @brief Merge rows of all tracks into the single time line sorted by ticks
+     *
+     * The merged time line gets used instead of the next events queue, unless
+     * the song has durated notes, track-local loops or branches which move
+     * tracks independently.
+     */
+    void buildEventsTimeline();
+
 
     /**********************************************************************************
      *                                 Process                                        *
@@ -1024,7 +1231,7 @@ private:
     /**
      * @brief Run processing of active durated notes, trigger true Note-OFF events for expired notes
      * @param track Track where to run the operation
-     * @param status [_out] Last-triggered event (Note-Off) will be returned here
+     * @param status [_out] Last-triggered event (Note-Off) will be returned here, unless the track is finished
      */
     void processDuratedNotes(size_t track, int32_t &status);
 
@@ -1032,20 +1239,20 @@ private:
      * @brief Check the state of caught loop start points
      * @param state Runtime state (for the track or for the global row)
      * @param loop Loop state (for the track or for the entire song)
-     * @param tk Track info structure
+     * @param row Currently processing row
      * @param glob Is global loop or local?
      */
-    void handleLoopStart(LoopRuntimeState &state, LoopState &loop, Position::TrackInfo &tk, bool glob);
+    void handleLoopStart(LoopRuntimeState &state, LoopState &loop, const MidiTrackRow &row, bool glob);
 
     /**
      * @brief Check the state of caught loop end points
      * @param state Runtime state (for the track or for the global row)
      * @param loop Loop state (for the track or for the entire song)
-     * @param tk Track info structure
+     * @param row Currently processing row
      * @param glob Is global loop or local?
      * @return true if it's required to stop further handling of events in this row (track or entire row)
      */
-    bool handleLoopEnd(LoopRuntimeState &state, LoopState &loop, Position::TrackInfo &tk, bool glob);
+    bool handleLoopEnd(LoopRuntimeState &state, LoopState &loop, const MidiTrackRow &row, bool glob);
 
 
 
@@ -1055,10 +1262,26 @@ private:
      * @param loop Loop state (for the track or for the entire song)
      * @param glob Is global loop or local?
      * @param tk Track number, used for local loops only, for global loop checks is unused
-     * @param pos Begin of the current row position
      * @return true if it's required to don't process the global loop end and end of the song
      */
-    bool processLoopPoints(LoopRuntimeState &state, LoopState &loop, bool glob, size_t tk, const Position &pos);
+    bool processLoopPoints(LoopRuntimeState &state, LoopState &loop, bool glob, size_t tk);
+
+    /**
+     * @brief Record the journal of the current position at the beginning of the events row
+     */
+    void beginRowJournal();
+
+    /**
+     * @brief Record the track into the journal of the row unless it's recorded already
+     * @param tk Track index
+     */
+    void journalTrack(size_t tk);
+
+    /**
+     * @brief Get the snapshot of the current position at the beginning of the events row
+     * @return Position at the beginning of the currently processing row
+     */
+    const Position &rowBeginPosition();
 
     void restoreSongState();
 
@@ -1082,6 +1305,38 @@ private:
      */
     bool jumpToBranch(uint32_t dstTrack, uint16_t dstBranch);
 
+    /**
+     * @brief Handle the current row of the track and step the track to its next row
+     * @param tk MIDI track
+     * @param isSeek is a seeking process
+     * @param loopState Runtime state of the global loop
+     * @return true if it's required to stop handling of other tracks in the row
+     */
+    bool processTrackRow(size_t tk, bool isSeek, LoopRuntimeState &loopState);
+
+    /**
+     * @brief Handle rows of the current tick by the merged time line
+     * @param isSeek is a seeking process
+     * @param loopState Runtime state of the global loop
+     * @param shortestDelay [_out] Delay until the next row in ticks
+     * @return false if no more rows left
+     */
+    bool processTimelineRow(bool isSeek, LoopRuntimeState &loopState, uint64_t &shortestDelay);
+
+    /**
+     * @brief Handle durated notes and rows of the tracks taken from the next events queue
+     * @param isSeek is a seeking process
+     * @param loopState Runtime state of the global loop
+     * @param shortestDelay [_out] Delay until the next event in ticks
+     * @return false if no more rows and durated notes left
+     */
+    bool processQueuedTracks(bool isSeek, LoopRuntimeState &loopState, uint64_t &shortestDelay);
+
+    /**
+     * @brief Count due ticks of tracks from the current position, find the timeline cursor or refill the next events queue
+     */
+    void syncSchedule();
+
     /**
      * @brief Process MIDI events on the current tick moment
      * @param isSeek is a seeking process
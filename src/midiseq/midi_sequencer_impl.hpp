@@ -37,6 +37,7 @@
 
 #include "impl/err_string_impl.hpp"
 #include "impl/durated_note_impl.hpp"
+#include "impl/next_events_impl.hpp"
 #include "impl/loop_impl.hpp"
 #include "impl/databank_impl.hpp"
 
@@ -107,6 +108,11 @@ BW_MidiSequencer::BW_MidiSequencer() :
     m_postSongWaitDelay(1.0),
     m_loopStartTime(-1.0),
     m_loopEndTime(-1.0),
+    m_eventsTimelineEnabled(false),
+    m_eventsTimelineCursor(0),
+    m_nextEventsCount(0),
+    m_scheduleTick(0),
+    m_scheduleSynced(false),
     m_atEnd(false),
     m_loopCount(-1),
     m_deviceMask(Device_ANY),
@@ -117,6 +123,9 @@ BW_MidiSequencer::BW_MidiSequencer() :
     m_loop.reset();
     m_loop.invalidLoop = false;
 
+    std::memset(&m_rowBegin, 0, sizeof(m_rowBegin));
+    duratedNoteClear();
+
     m_time.init();
 
     m_tempo.nom = 0;
@@ -0,0 +1,347 @@
+#include <catch.hpp>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+
+// The sequencer gets built into the test alone, under its own name
+#define BW_MidiSequencer DuratedNotesTestSequencer
+#include "midiseq/midi_sequencer_impl.hpp"
+
+/*
+ * HMI songs are made in memory: every HMI Note-On has the duration, and the
+ * sequencer expires these notes by the timing wheel. The first track sends
+ * controller markers at ticks around the expiry of every note, so the latest
+ * marker before the Note-Off tells the tick the note expired at: the tracks
+ * of the same tick are processed in order of their indices.
+ */
+
+struct TestNote
+{
+    size_t   track;
+    uint64_t tick;
+    uint32_t duration;
+    uint8_t  key;
+
+    //! HMI notes expire one tick after their durations
+    uint64_t expiry() const { return tick + duration + 1; }
+};
+
+struct NoteOffRecord
+{
+    uint8_t channel;
+    uint8_t key;
+    //! Index of the latest marker sent before the Note-Off, -1 if none
+    long    marker;
+};
+
+struct TestPlayer
+{
+    long marker;
+    std::vector<NoteOffRecord> noteOffs;
+};
+
+static const uint8_t MarkerFirstCC = 20;
+
+static void rtNoteOn(void *, uint8_t, uint8_t, uint8_t) {}
+static void rtNoteAfterTouch(void *, uint8_t, uint8_t, uint8_t) {}
+static void rtChannelAfterTouch(void *, uint8_t, uint8_t) {}
+static void rtPatchChange(void *, uint8_t, uint8_t) {}
+static void rtPitchBend(void *, uint8_t, uint8_t, uint8_t) {}
+static void rtSysEx(void *, const uint8_t *, size_t) {}
+static void debugMessage(void *, const char *, ...) {}
+
+static void rtNoteOff(void *userdata, uint8_t channel, uint8_t key)
+{
+    TestPlayer *p = static_cast<TestPlayer *>(userdata);
+    NoteOffRecord r;
+    r.channel = channel;
+    r.key = key;
+    r.marker = p->marker;
+    p->noteOffs.push_back(r);
+}
+
+static void rtControllerChange(void *userdata, uint8_t channel, uint8_t type, uint8_t value)
+{
+    TestPlayer *p = static_cast<TestPlayer *>(userdata);
+    if(channel == 0 && type >= MarkerFirstCC)
+        p->marker = (long)(type - MarkerFirstCC) * 128 + value;
+}
+
+static void putVarLen(std::vector<uint8_t> &out, uint64_t value)
+{
+    uint8_t bytes[10];
+    size_t count = 0;
+
+    do
+    {
+        bytes[count++] = static_cast<uint8_t>(value & 0x7F);
+        value >>= 7;
+    } while(value != 0);
+
+    while(count > 1)
+        out.push_back(bytes[--count] | 0x80);
+    out.push_back(bytes[0]);
+}
+
+static void putLE(std::vector<uint8_t> &out, size_t at, uint32_t value, size_t bytes)
+{
+    for(size_t i = 0; i < bytes; ++i)
+        out[at + i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+struct TrackEvent
+{
+    uint64_t tick;
+    std::vector<uint8_t> data;
+};
+
+static bool eventEarlier(const TrackEvent &a, const TrackEvent &b)
+{
+    return a.tick < b.tick;
+}
+
+/**
+ * Build the HMI song: markers at the given ticks in the first track,
+ * notes in following tracks, the channel of a note is its track index
+ */
+static std::vector<uint8_t> makeSong(const std::vector<uint64_t> &markers, const std::vector<TestNote> &notes, size_t tracks)
+{
+    std::vector<std::vector<uint8_t> > trackData(tracks + 1);
+
+    for(size_t t = 0; t <= tracks; ++t)
+    {
+        std::vector<TrackEvent> events;
+
+        if(t == 0)
+        {
+            // The loader puts the initial tempo at the zero tick of the first track, keep its own row there too
+            TrackEvent volume;
+            volume.tick = 0;
+            volume.data.push_back(0xB0);
+            volume.data.push_back(7);
+            volume.data.push_back(127);
+            events.push_back(volume);
+
+            for(size_t i = 0; i < markers.size(); ++i)
+            {
+                TrackEvent e;
+                e.tick = markers[i];
+                e.data.push_back(0xB0);
+                e.data.push_back(static_cast<uint8_t>(MarkerFirstCC + i / 128));
+                e.data.push_back(static_cast<uint8_t>(i % 128));
+                events.push_back(e);
+            }
+        }
+
+        for(size_t i = 0; i < notes.size(); ++i)
+        {
+            if(notes[i].track != t)
+                continue;
+            TrackEvent e;
+            e.tick = notes[i].tick;
+            e.data.push_back(static_cast<uint8_t>(0x90 | t));
+            e.data.push_back(notes[i].key);
+            e.data.push_back(100);
+            putVarLen(e.data, notes[i].duration);
+            events.push_back(e);
+        }
+
+        std::stable_sort(events.begin(), events.end(), eventEarlier);
+
+        std::vector<uint8_t> &d = trackData[t];
+        uint64_t tick = 0;
+        for(size_t i = 0; i < events.size(); ++i)
+        {
+            putVarLen(d, events[i].tick - tick);
+            d.insert(d.end(), events[i].data.begin(), events[i].data.end());
+            tick = events[i].tick;
+        }
+        putVarLen(d, 0);
+        d.push_back(0xFF);
+        d.push_back(0x2F);
+    }
+
+    std::vector<uint8_t> song(0x100, 0);
+    std::memcpy(&song[0], "HMI-MIDISONG061595", 18);
+    putLE(song, 0xD4, 60, 2);
+    putLE(song, 0xE4, static_cast<uint32_t>(tracks + 1), 2);
+    putLE(song, 0xE8, 0x100, 4);
+
+    const size_t dir = song.size();
+    song.resize(dir + 4 * (tracks + 1), 0);
+
+    for(size_t t = 0; t <= tracks; ++t)
+    {
+        putLE(song, dir + 4 * t, static_cast<uint32_t>(song.size()), 4);
+        const size_t header = song.size();
+        song.resize(header + 0xB0, 0);
+        std::memcpy(&song[header], "HMI-MIDITRACK", 13);
+        putLE(song, header + 0x57, 0xB0, 4);
+        song.insert(song.end(), trackData[t].begin(), trackData[t].end());
+    }
+
+    return song;
+}
+
+static std::vector<NoteOffRecord> playSong(const std::vector<uint8_t> &song)
+{
+    TestPlayer player;
+    player.marker = -1;
+
+    BW_MidiRtInterface iface;
+    std::memset(&iface, 0, sizeof(iface));
+    iface.onDebugMessage = debugMessage;
+    iface.rtUserData = &player;
+    iface.rt_noteOn = rtNoteOn;
+    iface.rt_noteOff = rtNoteOff;
+    iface.rt_noteAfterTouch = rtNoteAfterTouch;
+    iface.rt_channelAfterTouch = rtChannelAfterTouch;
+    iface.rt_controllerChange = rtControllerChange;
+    iface.rt_patchChange = rtPatchChange;
+    iface.rt_pitchBend = rtPitchBend;
+    iface.rt_systemExclusive = rtSysEx;
+
+    DuratedNotesTestSequencer seq;
+    seq.setInterface(&iface);
+    REQUIRE(seq.loadMIDI(&song[0], song.size()));
+    seq.setLoopEnabled(false);
+
+    // Songs have a few thousands of events, don't hang if the song never ends
+    double wait = 0.0;
+    for(size_t i = 0; i < 20000 && !seq.positionAtEnd(); ++i)
+        wait = seq.Tick(wait, 0.0001);
+    REQUIRE(seq.positionAtEnd());
+
+    return player.noteOffs;
+}
+
+/**
+ * Every note must be released once at its expiry tick, the notes of the same
+ * tick in order of their tracks
+ */
+static void checkNoteOffs(const std::vector<TestNote> &notes, const std::vector<uint64_t> &markers,
+                          const std::vector<NoteOffRecord> &noteOffs)
+{
+    REQUIRE(noteOffs.size() == notes.size());
+
+    std::vector<bool> released(notes.size(), false);
+    uint64_t lastExpiry = 0;
+    size_t lastTrack = 0;
+
+    for(size_t i = 0; i < noteOffs.size(); ++i)
+    {
+        const NoteOffRecord &r = noteOffs[i];
+        size_t n = 0;
+        while(n < notes.size() && (notes[n].track != r.channel || notes[n].key != r.key))
+            ++n;
+
+        INFO("Note-Off #" << i << " of channel " << (int)r.channel << " key " << (int)r.key);
+        REQUIRE(n < notes.size());
+        REQUIRE(!released[n]);
+        released[n] = true;
+
+        const uint64_t expiry = notes[n].expiry();
+        INFO("Expires at tick " << expiry);
+        REQUIRE(r.marker >= 0);
+        REQUIRE(markers[static_cast<size_t>(r.marker)] == expiry);
+
+        REQUIRE(expiry >= lastExpiry);
+        if(expiry == lastExpiry)
+            REQUIRE(notes[n].track >= lastTrack);
+        lastExpiry = expiry;
+        lastTrack = notes[n].track;
+    }
+}
+
+// Markers right before, at, and after the expiry of every note
+static std::vector<uint64_t> makeMarkers(const std::vector<TestNote> &notes)
+{
+    std::vector<uint64_t> markers;
+
+    for(size_t i = 0; i < notes.size(); ++i)
+    {
+        const uint64_t e = notes[i].expiry();
+        markers.push_back(e - 1);
+        markers.push_back(e);
+        markers.push_back(e + 1);
+    }
+
+    std::sort(markers.begin(), markers.end());
+    markers.erase(std::unique(markers.begin(), markers.end()), markers.end());
+    return markers;
+}
+
+static TestNote makeNote(size_t track, uint64_t tick, uint32_t duration, uint8_t key)
+{
+    TestNote n;
+    n.track = track;
+    n.tick = tick;
+    n.duration = duration;
+    n.key = key;
+    return n;
+}
+
+TEST_CASE("[DuratedNotes] Ties of notes placed at different levels of the wheel")
+{
+    std::vector<TestNote> notes;
+
+    // All these notes expire at the tick 5000, placed from the 3rd level down to the 1st one
+    notes.push_back(makeNote(3, 0, 4999, 1));
+    notes.push_back(makeNote(1, 1000, 3999, 2));
+    notes.push_back(makeNote(2, 4900, 99, 3));
+    notes.push_back(makeNote(4, 4990, 9, 4));
+    notes.push_back(makeNote(1, 4999, 0, 5));
+
+    // Neighbours of the tie on both sides of it
+    notes.push_back(makeNote(2, 3, 4995, 6));
+    notes.push_back(makeNote(4, 4998, 2, 7));
+    notes.push_back(makeNote(3, 7, 4994, 8));
+
+    const std::vector<uint64_t> markers = makeMarkers(notes);
+    checkNoteOffs(notes, markers, playSong(makeSong(markers, notes, 4)));
+}
+
+TEST_CASE("[DuratedNotes] Long durations cascade through higher levels")
+{
+    static const uint32_t durations[] =
+    {
+        62, 63, 64, 4094, 4095, 4096, 262142, 262143, 262144,
+        1000000, 16777213, 16777214
+    };
+
+    std::vector<TestNote> notes;
+    for(size_t i = 0; i < sizeof(durations) / sizeof(durations[0]); ++i)
+    {
+        // Start ticks unaligned to the wheel's slots
+        notes.push_back(makeNote(1 + i % 3, 37 + i * 5, durations[i], static_cast<uint8_t>(i)));
+        notes.push_back(makeNote(1 + (i + 1) % 3, 4100 + i, durations[i], static_cast<uint8_t>(64 + i)));
+    }
+
+    const std::vector<uint64_t> markers = makeMarkers(notes);
+    checkNoteOffs(notes, markers, playSong(makeSong(markers, notes, 3)));
+}
+
+TEST_CASE("[DuratedNotes] Random durations of many notes")
+{
+    static const uint32_t ranges[] = {1, 64, 4096, 262144, 16777215};
+    std::vector<TestNote> notes;
+    uint32_t state = 12345;
+
+    for(size_t track = 1; track <= 6; ++track)
+    {
+        uint64_t tick = 0;
+        for(uint8_t key = 0; key < 100; ++key)
+        {
+            state = state * 1103515245u + 12345u;
+            tick += (state >> 16) % 200;
+            state = state * 1103515245u + 12345u;
+            const uint32_t range = ranges[(state >> 16) % 5];
+            state = state * 1103515245u + 12345u;
+            const uint32_t duration = (state >> 8) % range;
+            notes.push_back(makeNote(track, tick, duration, key));
+        }
+    }
+
+    const std::vector<uint64_t> markers = makeMarkers(notes);
+    checkNoteOffs(notes, markers, playSong(makeSong(markers, notes, 6)));
+}
@@ -0,0 +1,69 @@
+#include <catch.hpp>
+#include <vector>
+#include "adlmidi.h"
+
+struct SkipTestSetup
+{
+    const char *path;
+    int chips;
+    bool mixBus;
+};
+
+static const SkipTestSetup test_setups[] =
+{
+    {"projects/watcom/ttd10.mid", 1, false},
+    {"projects/watcom/ttd10.mid", 4, true},
+    {"projects/watcom/onestop.mid", 1, true},
+    {"projects/watcom/onestop.mid", 4, false}
+};
+
+static std::vector<short> render(const char *path, int chips, bool skip, bool mixBus)
+{
+    std::vector<short> output;
+    ADL_MIDIPlayer *device = adl_init(44100);
+    REQUIRE(device != NULL);
+
+    REQUIRE(adl_switchEmulator(device, ADLMIDI_EMU_NUKED) == 0);
+    REQUIRE(adl_setNumChips(device, chips) == 0);
+    REQUIRE(adl_setBank(device, 58) == 0);
+    REQUIRE(adl_setSkipIdleChips(device, skip ? 1 : 0) == 0);
+    REQUIRE(adl_setMixBusResampling(device, mixBus ? 1 : 0) == 0);
+    REQUIRE(adl_openFile(device, path) == 0);
+
+    const size_t total = 2 * 44100 * 15;
+    short buffer[2048];
+    while(output.size() < total)
+    {
+        int got = adl_play(device, 2048, buffer);
+        if(got <= 0)
+            break;
+        output.insert(output.end(), buffer, buffer + got);
+    }
+
+    adl_close(device);
+    return output;
+}
+
+static size_t countDifferences(const std::vector<short> &a, const std::vector<short> &b)
+{
+    size_t diffs = 0;
+    for(size_t i = 0; i < a.size() && i < b.size(); ++i)
+    {
+        if(a[i] != b[i])
+            ++diffs;
+    }
+    return diffs;
+}
+
+TEST_CASE("[IdleSkip] Skipping of idle chips keeps the output bit-identical")
+{
+    for(const SkipTestSetup &setup : test_setups)
+    {
+        INFO("File " << setup.path << ", " << setup.chips << " chips, mix bus " << setup.mixBus);
+        std::vector<short> emulated = render(setup.path, setup.chips, false, setup.mixBus);
+        std::vector<short> skipped = render(setup.path, setup.chips, true, setup.mixBus);
+        REQUIRE(emulated.size() > 0);
+        REQUIRE(emulated.size() == skipped.size());
+        REQUIRE(countDifferences(emulated, skipped) == 0);
+    }
+}
@@ -0,0 +1,161 @@
+#include <catch.hpp>
+#include <thread>
+#include "adlmidi_midi_queue.hpp"
+
+static MidiInputQueue::Event makeEvent(uint32_t n)
+{
+    MidiInputQueue::Event e = MidiInputQueue::Event();
+    e.frameOffset = n;
+    e.size = 3;
+    e.data[0] = static_cast<uint8_t>(0x90 | (n & 0x0F));
+    e.data[1] = static_cast<uint8_t>((n >> 4) & 0x7F);
+    e.data[2] = static_cast<uint8_t>((n >> 11) & 0x7F);
+    return e;
+}
+
+static bool sameEvent(const MidiInputQueue::Event &e, uint32_t n)
+{
+    const MidiInputQueue::Event ref = makeEvent(n);
+    return e.frameOffset == ref.frameOffset && e.size == ref.size &&
+           e.data[0] == ref.data[0] && e.data[1] == ref.data[1] && e.data[2] == ref.data[2];
+}
+
+TEST_CASE("[MidiInputQueue] Capacity")
+{
+    MidiInputQueue queue;
+    MidiInputQueue::Event e = makeEvent(0);
+
+    SECTION("Disabled queue takes nothing")
+    {
+        REQUIRE(queue.capacity() == 0);
+        REQUIRE(!queue.push(e));
+        REQUIRE(!queue.pop(e));
+        REQUIRE(queue.overflows() == 0);
+    }
+
+    SECTION("Capacity is rounded up to the power of two")
+    {
+        REQUIRE(queue.setCapacity(100));
+        REQUIRE(queue.capacity() == 128);
+        REQUIRE(queue.setCapacity(64));
+        REQUIRE(queue.capacity() == 64);
+        REQUIRE(!queue.setCapacity(0x40000001));
+        REQUIRE(queue.setCapacity(0));
+        REQUIRE(queue.capacity() == 0);
+    }
+
+    SECTION("Changing of the capacity drops queued events")
+    {
+        REQUIRE(queue.setCapacity(4));
+        REQUIRE(queue.push(e));
+        REQUIRE(queue.setCapacity(8));
+        REQUIRE(!queue.pop(e));
+    }
+}
+
+TEST_CASE("[MidiInputQueue] Events wrap around the ring in order")
+{
+    MidiInputQueue queue;
+    REQUIRE(queue.setCapacity(8));
+
+    uint32_t pushed = 0, popped = 0;
+
+    // Fill the queue partially at different phases, so indices wrap many times
+    for(uint32_t round = 0; round < 100; ++round)
+    {
+        const uint32_t count = 1 + round % 8;
+
+        // Make room for the whole batch, the queue gets full at some rounds
+        while(pushed - popped + count > 8)
+        {
+            MidiInputQueue::Event e = MidiInputQueue::Event();
+            REQUIRE(queue.pop(e));
+            REQUIRE(sameEvent(e, popped++));
+        }
+
+        for(uint32_t i = 0; i < count; ++i)
+            REQUIRE(queue.push(makeEvent(pushed++)));
+
+        for(uint32_t i = 0; i < count / 2; ++i)
+        {
+            MidiInputQueue::Event e = MidiInputQueue::Event();
+            REQUIRE(queue.pop(e));
+            REQUIRE(sameEvent(e, popped++));
+        }
+    }
+
+    MidiInputQueue::Event e = MidiInputQueue::Event();
+    while(queue.pop(e))
+        REQUIRE(sameEvent(e, popped++));
+
+    REQUIRE(popped == pushed);
+    REQUIRE(pushed > 8 * 20);
+    REQUIRE(queue.overflows() == 0);
+}
+
+TEST_CASE("[MidiInputQueue] Overflows are dropped and counted")
+{
+    MidiInputQueue queue;
+    REQUIRE(queue.setCapacity(4));
+
+    for(uint32_t i = 0; i < 4; ++i)
+        REQUIRE(queue.push(makeEvent(i)));
+
+    REQUIRE(!queue.push(makeEvent(100)));
+    REQUIRE(!queue.push(makeEvent(101)));
+    REQUIRE(queue.overflows() == 2);
+
+    // The space of the taken event gets reused
+    MidiInputQueue::Event e = MidiInputQueue::Event();
+    REQUIRE(queue.pop(e));
+    REQUIRE(sameEvent(e, 0));
+    REQUIRE(queue.push(makeEvent(4)));
+    REQUIRE(!queue.push(makeEvent(102)));
+    REQUIRE(queue.overflows() == 3);
+
+    // Dropped events never appear
+    for(uint32_t i = 1; i <= 4; ++i)
+    {
+        REQUIRE(queue.pop(e));
+        REQUIRE(sameEvent(e, i));
+    }
+    REQUIRE(!queue.pop(e));
+}
+
+TEST_CASE("[MidiInputQueue] Producer and consumer threads")
+{
+    MidiInputQueue queue;
+    REQUIRE(queue.setCapacity(64));
+
+    const uint32_t total = 200000;
+    uint32_t accepted = 0;
+
+    std::thread producer([&]()
+    {
+        for(uint32_t i = 0; i < total; ++i)
+        {
+            if(queue.push(makeEvent(accepted)))
+                ++accepted;
+        }
+    });
+
+    // Every taken event must be the next accepted one, nothing gets lost or duplicated
+    uint32_t popped = 0;
+    bool ordered = true;
+    MidiInputQueue::Event e = MidiInputQueue::Event();
+    for(;;)
+    {
+        if(queue.pop(e))
+        {
+            ordered = ordered && sameEvent(e, popped);
+            ++popped;
+        }
+        else if(popped + queue.overflows() == total)
+            break;
+    }
+
+    producer.join();
+    REQUIRE(ordered);
+    REQUIRE(popped == accepted);
+    REQUIRE(popped + queue.overflows() == total);
+}
@@ -0,0 +1,102 @@
+#include <catch.hpp>
+#include <vector>
+#include "chips/nuked_opl3.h"
+
+static const uint32_t test_rates[] = {44100, 48000, 22050, 8000, 96000, 80};
+
+static uint32_t nextRandom(uint32_t &state)
+{
+    state = state * 1103515245u + 12345u;
+    return state >> 16;
+}
+
+static void writeBoth(OPLChipBase &a, OPLChipBase &b, uint16_t addr, uint8_t data)
+{
+    a.writeReg(addr, data);
+    b.writeReg(addr, data);
+}
+
+static void setupVoices(OPLChipBase &a, OPLChipBase &b)
+{
+    writeBoth(a, b, 0x105, 0x01);
+    writeBoth(a, b, 0x001, 0x20);
+    for(uint16_t c = 0; c < 9; ++c)
+    {
+        const uint16_t op = (uint16_t)((c % 3) + (c / 3) * 8);
+        for(uint16_t o = 0; o < 2; ++o)
+        {
+            const uint16_t slot = (uint16_t)(op + o * 3);
+            writeBoth(a, b, 0x20 + slot, (uint8_t)(0x21 + c % 4));
+            writeBoth(a, b, 0x40 + slot, (uint8_t)(o ? 0x00 : 0x18));
+            writeBoth(a, b, 0x60 + slot, 0xF4);
+            writeBoth(a, b, 0x80 + slot, 0x46);
+            writeBoth(a, b, 0xE0 + slot, (uint8_t)(c % 4));
+        }
+        writeBoth(a, b, 0xC0 + c, (uint8_t)(0x30 | ((c % 8) << 1)));
+        writeBoth(a, b, 0xA0 + c, (uint8_t)(0x40 + c * 16));
+        writeBoth(a, b, 0xB0 + c, (uint8_t)(0x20 | ((c % 6) << 2) | 1));
+    }
+}
+
+// Key voices on and off, and change their pitches at random frames
+static void writeRandom(OPLChipBase &a, OPLChipBase &b, uint32_t &state)
+{
+    const uint16_t c = (uint16_t)(nextRandom(state) % 9);
+    const uint8_t block = (uint8_t)(nextRandom(state) % 8);
+    const bool keyOn = (nextRandom(state) % 3) != 0;
+    writeBoth(a, b, 0xA0 + c, (uint8_t)nextRandom(state));
+    writeBoth(a, b, 0xB0 + c, (uint8_t)((keyOn ? 0x20 : 0x00) | (block << 2) | (nextRandom(state) % 4)));
+}
+
+TEST_CASE("[Resampler] Block rendering matches frame-by-frame rendering")
+{
+    for(size_t r = 0; r < sizeof(test_rates) / sizeof(test_rates[0]); ++r)
+    {
+        const uint32_t rate = test_rates[r];
+        INFO("Rate " << rate);
+
+        NukedOPL3 block, single;
+        // The frame-by-frame path is only public through the base interface
+        OPLChipBase &frames = single;
+        block.setRate(rate);
+        single.setRate(rate);
+        setupVoices(block, single);
+
+        std::vector<int32_t> blockOut, singleOut;
+        const size_t total = (size_t)rate * 2 + 4;
+        // Several register writes per second even at the lowest rates
+        const size_t longest = (total / 16 < 1500) ? total / 16 : 1500;
+        uint32_t state = rate;
+
+        size_t done = 0;
+        while(done < total)
+        {
+            size_t count = 1 + nextRandom(state) % longest;
+            if(count > total - done)
+                count = total - done;
+
+            const size_t at = blockOut.size();
+            blockOut.resize(at + 2 * count);
+            block.generate32(&blockOut[at], count);
+
+            singleOut.resize(at + 2 * count);
+            for(size_t i = 0; i < count; ++i)
+                frames.resampledGenerate(&singleOut[at + 2 * i]);
+
+            writeRandom(block, single, state);
+            done += count;
+        }
+
+        size_t differ = 0, nonzero = 0;
+        for(size_t i = 0; i < blockOut.size(); ++i)
+        {
+            if(blockOut[i] != singleOut[i])
+                ++differ;
+            if(blockOut[i] != 0)
+                ++nonzero;
+        }
+
+        REQUIRE(nonzero > 0);
+        REQUIRE(differ == 0);
+    }
+}
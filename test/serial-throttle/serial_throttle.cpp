@@ -0,0 +1,112 @@
+#include <catch.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include "chips/opl_serial_port.h"
+
+/*
+ * The chip writes into the slave side of a pseudo-terminal, and the test
+ * counts bytes which reach its master side after every tick.
+ */
+
+struct PseudoTerminal
+{
+    int master;
+    std::string slaveName;
+
+    PseudoTerminal() : master(-1)
+    {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if(master < 0)
+            return;
+
+        const char *name = NULL;
+        if(grantpt(master) != 0 || unlockpt(master) != 0 || (name = ptsname(master)) == NULL)
+        {
+            ::close(master);
+            master = -1;
+            return;
+        }
+
+        fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+        // The port opens devices by names relative to /dev/
+        slaveName = name;
+        if(slaveName.compare(0, 5, "/dev/") == 0)
+            slaveName.erase(0, 5);
+    }
+
+    ~PseudoTerminal()
+    {
+        if(master >= 0)
+            ::close(master);
+    }
+
+    //! Take all bytes sent to the port so far
+    size_t drain()
+    {
+        uint8_t buf[1024];
+        size_t total = 0;
+        ssize_t got;
+
+        while((got = ::read(master, buf, sizeof(buf))) > 0)
+            total += static_cast<size_t>(got);
+
+        return total;
+    }
+};
+
+static const unsigned Baud = 115200;
+// Packets of the Nuke.YKT protocol are 3 bytes
+static const size_t PacketSize = 3;
+
+static void writePackets(OPL_SerialPort &chip, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+        chip.writeReg(static_cast<uint16_t>(0x20 + i % 0x16), static_cast<uint8_t>(i));
+}
+
+TEST_CASE("[SerialThrottle] The full buffer doesn't exceed the bandwidth")
+{
+    PseudoTerminal pty;
+    REQUIRE(pty.master >= 0);
+
+    OPL_SerialPort chip;
+    REQUIRE(chip.connectPort(pty.slaveName, Baud, OPL_SerialPort::ProtocolNukeYktOPL3));
+    chip.setThrottle(true);
+
+    const double seconds = 0.01;
+    const double bandwidth = Baud / 10.0 * seconds;
+    const size_t packetsPerTick = static_cast<size_t>(bandwidth) / PacketSize + 1;
+    size_t written = 0, sent = 0;
+
+    // A burst nearly fills the buffer, and the following ticks write more than the port takes
+    writePackets(chip, 1350);
+    written += 1350 * PacketSize;
+
+    for(int tick = 0; tick < 200; ++tick)
+    {
+        if(tick > 0)
+        {
+            writePackets(chip, packetsPerTick);
+            written += packetsPerTick * PacketSize;
+        }
+
+        chip.flushWrites(seconds);
+
+        const size_t got = pty.drain();
+        INFO("Tick " << tick);
+        REQUIRE(static_cast<double>(got) <= bandwidth + PacketSize);
+        sent += got;
+    }
+
+    // The buffer was full, the data kept in it isn't lost
+    REQUIRE(written - sent >= 4096 - PacketSize);
+
+    chip.setThrottle(false);
+    chip.flushWrites(seconds);
+    sent += pty.drain();
+    REQUIRE(sent == written);
+}
@@ -0,0 +1,155 @@
+#include <catch.hpp>
+#include <thread>
+#include "adlmidi.h"
+#include "adlmidi_staged.hpp"
+
+TEST_CASE("[StagedSettings] Staged settings are applied by the render call")
+{
+    ADL_MIDIPlayer *device = adl_init(44100);
+    REQUIRE(device != NULL);
+
+    short buffer[128];
+
+    adl_setHVibrato(device, 0);
+    REQUIRE(adl_getHVibrato(device) == 0);
+    REQUIRE(adl_stageSetting(device, ADLMIDI_Stage_HVibrato, 1) == 0);
+    REQUIRE(adl_getHVibrato(device) == 0);
+    REQUIRE(adl_generate(device, 128, buffer) == 128);
+    REQUIRE(adl_getHVibrato(device) == 1);
+
+    SECTION("The same value staged again after the direct change")
+    {
+        adl_setHVibrato(device, 0);
+        REQUIRE(adl_stageSetting(device, ADLMIDI_Stage_HVibrato, 1) == 0);
+        REQUIRE(adl_generate(device, 128, buffer) == 128);
+        REQUIRE(adl_getHVibrato(device) == 1);
+    }
+
+    SECTION("Settings staged earlier are not applied again")
+    {
+        adl_setHVibrato(device, 0);
+        REQUIRE(adl_stageSetting(device, ADLMIDI_Stage_AutoArpeggio, 1) == 0);
+        REQUIRE(adl_generate(device, 128, buffer) == 128);
+        REQUIRE(adl_getHVibrato(device) == 0);
+        REQUIRE(adl_getAutoArpeggio(device) == 1);
+    }
+
+    SECTION("The latest of values staged between render calls wins")
+    {
+        REQUIRE(adl_stageSetting(device, ADLMIDI_Stage_HVibrato, 0) == 0);
+        REQUIRE(adl_stageSetting(device, ADLMIDI_Stage_HVibrato, 1) == 0);
+        REQUIRE(adl_stageSetting(device, ADLMIDI_Stage_HVibrato, 0) == 0);
+        REQUIRE(adl_generate(device, 128, buffer) == 128);
+        REQUIRE(adl_getHVibrato(device) == 0);
+    }
+
+    SECTION("Unknown settings are rejected")
+    {
+        REQUIRE(adl_stageSetting(device, -1, 0) < 0);
+        REQUIRE(adl_stageSetting(device, ADLMIDI_Stage_Count, 0) < 0);
+    }
+
+    adl_close(device);
+}
+
+struct StagedTestBlock
+{
+    uint32_t serial;
+    uint32_t values[16];
+};
+
+static void fillBlock(StagedTestBlock &b, uint32_t serial)
+{
+    b.serial = serial;
+    for(uint32_t i = 0; i < 16; ++i)
+        b.values[i] = serial * 31 + i;
+}
+
+static bool blockConsistent(const StagedTestBlock &b)
+{
+    for(uint32_t i = 0; i < 16; ++i)
+    {
+        if(b.values[i] != b.serial * 31 + i)
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE("[StagedBlock] Publish and take")
+{
+    StagedBlock<StagedTestBlock> staged;
+
+    REQUIRE(staged.take() == NULL);
+
+    fillBlock(staged.back(), 1);
+    staged.publish();
+
+    const StagedTestBlock *taken = staged.take();
+    REQUIRE(taken != NULL);
+    REQUIRE(taken->serial == 1);
+    REQUIRE(blockConsistent(*taken));
+    REQUIRE(staged.take() == NULL);
+
+    SECTION("Only the latest of missed blocks is taken")
+    {
+        for(uint32_t i = 2; i <= 5; ++i)
+        {
+            fillBlock(staged.back(), i);
+            staged.publish();
+        }
+
+        taken = staged.take();
+        REQUIRE(taken != NULL);
+        REQUIRE(taken->serial == 5);
+        REQUIRE(blockConsistent(*taken));
+        REQUIRE(staged.take() == NULL);
+    }
+
+    SECTION("The writer never fills the block held by the reader")
+    {
+        for(uint32_t i = 2; i <= 10; ++i)
+        {
+            REQUIRE(&staged.back() != taken);
+            fillBlock(staged.back(), i);
+            staged.publish();
+            REQUIRE(taken->serial == i - 1);
+
+            taken = staged.take();
+            REQUIRE(taken != NULL);
+            REQUIRE(taken->serial == i);
+        }
+    }
+}
+
+TEST_CASE("[StagedBlock] Writer and reader threads")
+{
+    StagedBlock<StagedTestBlock> staged;
+    const uint32_t total = 100000;
+
+    std::thread writer([&]()
+    {
+        for(uint32_t i = 1; i <= total; ++i)
+        {
+            fillBlock(staged.back(), i);
+            staged.publish();
+        }
+    });
+
+    // Taken blocks must be whole and never older than the previous one
+    uint32_t last = 0;
+    bool consistent = true, ordered = true;
+    while(last < total)
+    {
+        const StagedTestBlock *taken = staged.take();
+        if(!taken)
+            continue;
+        consistent = consistent && blockConsistent(*taken);
+        ordered = ordered && taken->serial > last;
+        last = taken->serial;
+    }
+
+    writer.join();
+    REQUIRE(consistent);
+    REQUIRE(ordered);
+    REQUIRE(last == total);
+}
@@ -224,6 +224,7 @@ int Args::parseArgs(int argc, char **argv_arr, bool *quit)
             " --emu-nuked7 Uses Nuked OPL3 Fast emulator\n"
             " --emu-nuked-opl2 Uses Nuked OPL2 Lite emulator\n"
             " --emu-nuked-cqm Uses Nuked CQM emulator\n"
+            " --emu-nuked-simd Uses Nuked OPL3 v 1.8 emulator with vectorized slots\n"
 #   endif
 #   ifndef ADLMIDI_DISABLE_DOSBOX_EMULATOR
             " --emu-dosbox Uses DosBox 0.74 OPL3 emulator\n"
@@ -383,6 +384,8 @@ int Args::parseArgs(int argc, char **argv_arr, bool *quit)
             emulator = ADLMIDI_EMU_NUKED_OPL2_LITE;
         else if(!std::strcmp("--emu-nuked-cqm", argv[2]))
             emulator = ADLMIDI_EMU_NUKED_CQM;
+        else if(!std::strcmp("--emu-nuked-simd", argv[2]))
+            emulator = ADLMIDI_EMU_NUKED_SIMD;
         else if(!std::strcmp("--emu-dosbox", argv[2]))
             emulator = ADLMIDI_EMU_DOSBOX;
         else if(!std::strcmp("--emu-dosbox-opl2", argv[2]))
@@ -0,0 +1,204 @@
+/*
+ * Benchmark of the concurrent rendering of many independent players by adl_renderMany()
+ *
+ * Every run renders the same song by the given count of players with a different
+ * count of threads, and reports the aggregate real-time factor: seconds of audio
+ * rendered by all players per second of the wall time.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <adlmidi.h>
+#include "utf8main.h" // IWYU pragma: keep
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <time.h>
+#   include <unistd.h>
+#endif
+
+static double wallTime()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+static int coreCount()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+struct BenchSetup
+{
+    const char *musicPath;
+    int players;
+    double seconds;
+    int emulator;
+    int chips;
+    int bank;
+};
+
+static const int sampleRate = 44100;
+static const int blockFrames = 512;
+
+/*
+ * Render the song by all players with the given count of threads,
+ * returns the wall time of the rendering, or a negative value on failure
+ */
+static double runBench(const BenchSetup &setup, int threads, unsigned long *checksum)
+{
+    std::vector<ADL_MIDIPlayer *> devices(setup.players, (ADL_MIDIPlayer *)NULL);
+    std::vector<short> buffers((size_t)setup.players * blockFrames * 2);
+    std::vector<ADL_UInt8 *> left(setup.players), right(setup.players);
+    ADL_RenderPool *pool = NULL;
+    double elapsed = -1.0;
+    unsigned long sum = 0;
+
+    for(int i = 0; i < setup.players; ++i)
+    {
+        ADL_MIDIPlayer *dev = adl_init(sampleRate);
+        devices[i] = dev;
+
+        if(!dev)
+        {
+            std::fprintf(stderr, "Failed to initialize the player!\n");
+            goto cleanup;
+        }
+
+        if(setup.emulator >= 0 && adl_switchEmulator(dev, setup.emulator) < 0)
+        {
+            std::fprintf(stderr, "Failed to switch the emulator: %s\n", adl_errorInfo(dev));
+            goto cleanup;
+        }
+
+        if(adl_setNumChips(dev, setup.chips) < 0 || adl_setBank(dev, setup.bank) < 0)
+        {
+            std::fprintf(stderr, "Failed to set up the player: %s\n", adl_errorInfo(dev));
+            goto cleanup;
+        }
+
+        if(adl_openFile(dev, setup.musicPath) < 0)
+        {
+            std::fprintf(stderr, "Failed to open the music file: %s\n", adl_errorInfo(dev));
+            goto cleanup;
+        }
+
+        left[i] = (ADL_UInt8 *)&buffers[(size_t)i * blockFrames * 2];
+        right[i] = left[i] + sizeof(short);
+    }
+
+    if(threads > 1)
+    {
+        pool = adl_renderPoolCreate(threads);
+        if(!pool)
+        {
+            std::fprintf(stderr, "Failed to create the pool of %d threads!\n", threads);
+            goto cleanup;
+        }
+    }
+
+    {
+        const long totalFrames = (long)(setup.seconds * sampleRate);
+        const double start = wallTime();
+
+        for(long done = 0; done < totalFrames; done += blockFrames)
+        {
+            adl_renderMany(&devices[0], devices.size(), blockFrames * 2,
+                           &left[0], &right[0], NULL, 1, pool);
+
+            // Checksum proves the output doesn't depend on the count of threads
+            for(size_t s = 0; s < buffers.size(); ++s)
+                sum = sum * 31 + (unsigned short)buffers[s];
+        }
+
+        elapsed = wallTime() - start;
+    }
+
+cleanup:
+    adl_renderPoolDestroy(pool);
+
+    for(size_t i = 0; i < devices.size(); ++i)
+    {
+        if(devices[i])
+            adl_close(devices[i]);
+    }
+
+    *checksum = sum;
+    return elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    BenchSetup setup;
+    int maxThreads = coreCount();
+
+    if(argc < 2)
+    {
+        std::printf("Usage: adlmidi-renderbench <music file> [players=64] [seconds=10] [threads=%d] [emulator=-1] [chips=2] [bank=58]\n"
+                    "\n"
+                    "Renders the music by many players with 1, 2, 4... up to the given count of threads,\n"
+                    "and reports the aggregate real-time factor of all players.\n", maxThreads);
+        return 1;
+    }
+
+    setup.musicPath = argv[1];
+    setup.players = argc > 2 ? std::atoi(argv[2]) : 64;
+    setup.seconds = argc > 3 ? std::atof(argv[3]) : 10.0;
+    maxThreads = argc > 4 ? std::atoi(argv[4]) : maxThreads;
+    setup.emulator = argc > 5 ? std::atoi(argv[5]) : -1;
+    setup.chips = argc > 6 ? std::atoi(argv[6]) : 2;
+    setup.bank = argc > 7 ? std::atoi(argv[7]) : 58;
+
+    if(setup.players < 1 || setup.seconds <= 0.0 || maxThreads < 1)
+    {
+        std::fprintf(stderr, "Invalid arguments!\n");
+        return 1;
+    }
+
+    std::printf("%d players, %g seconds of audio each, %d cores\n\n", setup.players, setup.seconds, coreCount());
+    std::printf("threads    wall, s    aggregate RTF    speedup    efficiency    checksum\n");
+
+    double baseTime = 0.0;
+
+    for(int threads = 1; ; threads = (threads * 2 > maxThreads && threads < maxThreads) ? maxThreads : threads * 2)
+    {
+        unsigned long checksum = 0;
+        double elapsed = runBench(setup, threads, &checksum);
+
+        if(elapsed < 0.0)
+            return 1;
+
+        if(threads == 1)
+            baseTime = elapsed;
+
+        const double rtf = setup.players * setup.seconds / elapsed;
+        const double speedup = baseTime / elapsed;
+
+        std::printf("%7d %10.3f %16.1f %10.2f %12.0f%% %11lx\n",
+                    threads, elapsed, rtf, speedup, 100.0 * speedup / threads, checksum);
+        std::fflush(stdout);
+
+        if(threads >= maxThreads)
+            break;
+    }
+
+    return 0;
+}